@@ -0,0 +1,58 @@
+#include "AgentTable.h"
+
+int AgentTable::Add(NPC* npc, double px, double py, TeamId t, Role r)
+{
+    handle.push_back(npc);
+    x.push_back(px);
+    y.push_back(py);
+    dirX.push_back(0.0);
+    dirY.push_back(0.0);
+    targetX.push_back(px);
+    targetY.push_back(py);
+    hp.push_back(100);
+    team.push_back(t);
+    role.push_back(r);
+    alive.push_back(1);
+    moving.push_back(0);
+    cellX.push_back(-1);
+    cellY.push_back(-1);
+    return (int)handle.size() - 1;
+}
+
+void AgentTable::Clear()
+{
+    handle.clear();
+    x.clear();
+    y.clear();
+    dirX.clear();
+    dirY.clear();
+    targetX.clear();
+    targetY.clear();
+    hp.clear();
+    team.clear();
+    role.clear();
+    alive.clear();
+    moving.clear();
+    cellX.clear();
+    cellY.clear();
+}
+
+int AgentTable::CountAlive(TeamId t) const
+{
+    int count = 0;
+    const int n = Count();
+    for (int i = 0; i < n; ++i) {
+        count += (alive[i] && team[i] == t) ? 1 : 0;
+    }
+    return count;
+}
+
+int AgentTable::CountAlive(TeamId t, Role r) const
+{
+    int count = 0;
+    const int n = Count();
+    for (int i = 0; i < n; ++i) {
+        count += (alive[i] && team[i] == t && role[i] == r) ? 1 : 0;
+    }
+    return count;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "Roles.h"
+
+class NPC;
+
+// ---------------------------------------------------------
+// AgentTable - the per-tick NPC fields of one world, as structure of arrays
+// Every NPC owns one slot, handed out in spawn order (Orange team first),
+// so walking the slots visits NPCs in team-vector order. The NPC object
+// keeps the cold half (FSM, path, timers, supplies) and is a handle: its
+// accessors read and write its slot. Loops that only need positions,
+// health or teams (spatial queries, counts, snapshots) walk these arrays
+// instead of dereferencing one heap object per NPC. Movement still runs
+// per NPC in NPC::DoSomeWork, interleaved with the FSM: a step checks the
+// occupancy that NPCs earlier in the same tick have already updated.
+// Slots are never reused within a match; Clear empties the table.
+// ---------------------------------------------------------
+class AgentTable {
+public:
+    // Appends a slot for 'npc' and returns its index
+    int Add(NPC* npc, double x, double y, TeamId team, Role role);
+    void Clear();
+
+    int Count() const { return (int)handle.size(); }
+
+    int CountAlive(TeamId team) const;
+    int CountAlive(TeamId team, Role role) const;
+
+    std::vector<NPC*> handle;           // owning NPC of each slot
+    std::vector<double> x, y;
+    std::vector<double> dirX, dirY;     // unit direction toward the target
+    std::vector<double> targetX, targetY;   // current waypoint
+    std::vector<int> hp;
+    std::vector<TeamId> team;
+    std::vector<Role> role;
+    std::vector<uint8_t> alive;         // hp > 0
+    std::vector<uint8_t> moving;
+    std::vector<int> cellX, cellY;      // cell marked occupied, -1 = none
+};
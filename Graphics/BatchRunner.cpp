@@ -0,0 +1,104 @@
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <algorithm>
+#include "BatchRunner.h"
+#include "Simulation.h"
+
+namespace BatchRunner
+{
+    MatchOutcome PlayMatch(const MatchParams& params, Map::VisibilityBackend visibility, Path::SearchMode pathSearch)
+    {
+        // Heap allocated: the map layers alone are several hundred KB
+        std::unique_ptr<World> world(new World(params));
+        WorldScope scope(world.get());
+        Map::SetVisibilityBackend(visibility);
+        Path::SetSearchMode(pathSearch);
+
+        Simulation::Setup();
+        while (Simulation::GetMatchState() == MatchState::Running) {
+            Simulation::Step();
+        }
+
+        MatchOutcome outcome;
+        outcome.state = Simulation::GetMatchState();
+        outcome.duration = Simulation::GetMatchDuration();
+        outcome.timedOut = outcome.state == MatchState::Draw &&
+            Simulation::CountAlive(world->teamOrange) > 0 &&
+            Simulation::CountAlive(world->teamBlue) > 0;
+
+        Simulation::Cleanup();
+        return outcome;
+    }
+
+    std::vector<BatchResult> Run(const BatchConfig& config)
+    {
+        std::vector<double> fireRanges = config.fireRanges;
+        std::vector<int> grenadeDamages = config.grenadeDamages;
+        if (fireRanges.empty()) fireRanges.push_back(FIRE_RANGE);
+        if (grenadeDamages.empty()) grenadeDamages.push_back(GRENADE_DAMAGE);
+
+        // One entry per parameter combination
+        std::vector<BatchResult> results;
+        for (double fireRange : fireRanges) {
+            for (int grenadeDamage : grenadeDamages) {
+                BatchResult r;
+                r.params.fireRange = fireRange;
+                r.params.grenadeDamage = grenadeDamage;
+                r.params.seed = config.baseSeed;
+                r.params.maxMatchSeconds = config.maxMatchSeconds;
+                results.push_back(r);
+            }
+        }
+
+        const int perSetting = std::max(0, config.matchesPerSetting);
+        const int totalMatches = (int)results.size() * perSetting;
+        std::vector<MatchOutcome> outcomes(totalMatches);
+        std::atomic<int> nextMatch(0);
+
+        auto worker = [&]() {
+            for (;;) {
+                int index = nextMatch.fetch_add(1);
+                if (index >= totalMatches) return;
+
+                MatchParams params = results[index / perSetting].params;
+                params.seed = config.baseSeed + (unsigned int)(index % perSetting);
+                outcomes[index] = PlayMatch(params, config.visibility, config.pathSearch);
+            }
+        };
+
+        int threadCount = config.threads;
+        if (threadCount <= 0) threadCount = (int)std::thread::hardware_concurrency();
+        threadCount = std::max(1, std::min(threadCount, totalMatches));
+
+        std::vector<std::thread> pool;
+        for (int i = 0; i < threadCount; ++i) {
+            pool.emplace_back(worker);
+        }
+        for (std::thread& t : pool) {
+            t.join();
+        }
+
+        // Aggregate in match order so the report is independent of scheduling
+        for (int index = 0; index < totalMatches; ++index) {
+            const MatchOutcome& o = outcomes[index];
+            BatchResult& r = results[index / perSetting];
+
+            if (r.matches == 0) {
+                r.minDuration = r.maxDuration = o.duration;
+            }
+            r.matches++;
+            r.totalDuration += o.duration;
+            r.minDuration = std::min(r.minDuration, o.duration);
+            r.maxDuration = std::max(r.maxDuration, o.duration);
+
+            switch (o.state) {
+            case MatchState::OrangeWin: r.orangeWins++; break;
+            case MatchState::BlueWin:   r.blueWins++; break;
+            default:                    r.draws++; break;
+            }
+            if (o.timedOut) r.timeouts++;
+        }
+        return results;
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <vector>
+#include "World.h"
+
+// ---------------------------------------------------------
+// BatchRunner - plays many independent matches on a thread pool
+// Each match gets its own World, so workers share no state.
+// ---------------------------------------------------------
+
+struct BatchConfig
+{
+    int matchesPerSetting = 100;        // matches played for each parameter combination
+    int threads = 0;                    // 0 = one per hardware thread
+    unsigned int baseSeed = 1;          // match i of every setting uses seed baseSeed + i
+    double maxMatchSeconds = 600.0;     // must be > 0, matches often stalemate
+    std::vector<double> fireRanges;     // empty = FIRE_RANGE only
+    std::vector<int> grenadeDamages;    // empty = GRENADE_DAMAGE only
+    Map::VisibilityBackend visibility = Map::VisibilityBackend::Rays;
+    Path::SearchMode pathSearch = Path::SearchMode::AStar;
+};
+
+// Outcome of a single match
+struct MatchOutcome
+{
+    MatchState state = MatchState::Running;
+    bool timedOut = false;              // Draw because the time limit was reached
+    double duration = 0.0;              // simulation seconds
+};
+
+// Aggregate over all matches of one parameter combination
+struct BatchResult
+{
+    MatchParams params;                 // seed field is the first seed of the setting
+    int matches = 0;
+    int orangeWins = 0;
+    int blueWins = 0;
+    int draws = 0;                      // includes timeouts
+    int timeouts = 0;
+    double totalDuration = 0.0;
+    double minDuration = 0.0;
+    double maxDuration = 0.0;
+
+    double AverageDuration() const { return matches > 0 ? totalDuration / matches : 0.0; }
+    double Rate(int count) const { return matches > 0 ? (double)count / matches : 0.0; }
+};
+
+namespace BatchRunner
+{
+    // Plays one match to the end in a private world bound to the calling thread.
+    MatchOutcome PlayMatch(const MatchParams& params,
+        Map::VisibilityBackend visibility = Map::VisibilityBackend::Rays,
+        Path::SearchMode pathSearch = Path::SearchMode::AStar);
+
+    // Plays the cartesian product of the configured sweeps. Results are in
+    // sweep order (fire range major) and do not depend on the thread count.
+    std::vector<BatchResult> Run(const BatchConfig& config);
+}
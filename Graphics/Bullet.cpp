@@ -1,10 +1,10 @@
 #include "Bullet.h"
 #include "Map.h"
 #include <math.h>
-#include "glut.h"
 #include "Roles.h"
+#include "SimClock.h"
 
-const double BULLET_SPEED = 0.45;
+const double BULLET_SPEED = 27.0; // cells per second
 
 Bullet::Bullet(double xPos, double yPos, double alpha)
 {
@@ -21,8 +21,9 @@ void Bullet::Move()
     double tmpX = x, tmpY = y;
     if (isMoving)
     {
-        tmpX += BULLET_SPEED * dirX;
-        tmpY += BULLET_SPEED * dirY;
+        double step = BULLET_SPEED * SimClock::Dt();
+        tmpX += step * dirX;
+        tmpY += step * dirY;
         
         int tx = (int)tmpX;
         int ty = (int)tmpY;
@@ -39,27 +40,18 @@ void Bullet::Move()
     }
 }
 
-void Bullet::Show() const
-{
-    glColor3d(1, 0, 0);
-    glBegin(GL_POLYGON);
-    glVertex2d(x - 0.5, y);
-    glVertex2d(x, y + 0.5);
-    glVertex2d(x + 0.5, y);
-    glVertex2d(x, y - 0.5);
-    glEnd();
-}
-
 void Bullet::CreateSecurityMap()
 {
     double tmpX = x, tmpY = y;
     double xsm = x, ysm = y;
 
+    // trace the flight one tick at a time
+    double step = BULLET_SPEED * SimClock::FIXED_DT;
     isCreatingSecurityMap = true;
     while (isCreatingSecurityMap)
     {
-        tmpX += BULLET_SPEED * dirX;
-        tmpY += BULLET_SPEED * dirY;
+        tmpX += step * dirX;
+        tmpY += step * dirY;
         
         int tx = (int)tmpX;
         int ty = (int)tmpY;
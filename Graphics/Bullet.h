@@ -12,7 +12,6 @@ public:
     Bullet(double xPos, double yPos, double alpha);
     
     void Move();
-    void Show() const;
     void SetIsMoving(bool value) { isMoving = value; }
     void SetIsCreatingSecurityMap(bool value) { isCreatingSecurityMap = value; }
     void CreateSecurityMap();
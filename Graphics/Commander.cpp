@@ -8,7 +8,8 @@
 #include "Map.h"
 #include "Pathfinding.h"
 #include "ReturnToWarehouse.h"
-#include <stdio.h>
+#include "StatePool.h"
+#include "Log.h"
 #include "NPC.h"
 #include <algorithm>
 #include <numeric>
@@ -17,20 +18,14 @@
 #include <limits>
 #include <cmath>
 #include "Definitions.h"
-#include <time.h>
+#include "SimClock.h"
+#include "World.h"
 #include <array>
 #include <cstdlib>
 
-extern std::vector<NPC*> teamOrange;
-extern std::vector<NPC*> teamBlue;
-
 namespace {
     enum class CoverBand : int { Retreat = 0, Defend = 1, Attack = 2 };
 
-    std::array<std::vector<std::pair<int, int>>, 3> coverSlotsOrange;
-    std::array<std::vector<std::pair<int, int>>, 3> coverSlotsBlue;
-    bool coverCatalogBuilt = false;
-
     inline int ClampInt(int value, int minValue, int maxValue)
     {
         if (value < minValue) return minValue;
@@ -70,8 +65,7 @@ namespace {
                 int nx = x + dx;
                 int ny = y + dy;
                 if (!Map::InBounds(nx, ny)) continue;
-                Map::Cell c = Map::Get(nx, ny);
-                if (c == Map::TREE || c == Map::ROCK || c == Map::WAREHOUSE) {
+                if (Map::BlocksBullets(nx, ny)) {
                     return true;
                 }
             }
@@ -81,10 +75,11 @@ namespace {
 
     void BuildCoverCatalog()
     {
-        if (coverCatalogBuilt) return;
+        World::CommanderState& state = World::Current().commanders;
+        if (state.coverCatalogBuilt) return;
 
-        for (auto& vec : coverSlotsOrange) vec.clear();
-        for (auto& vec : coverSlotsBlue) vec.clear();
+        for (auto& vec : state.coverSlotsOrange) vec.clear();
+        for (auto& vec : state.coverSlotsBlue) vec.clear();
 
         for (int y = 1; y < Map::H - 1; ++y) {
             for (int x = 1; x < Map::W - 1; ++x) {
@@ -95,28 +90,28 @@ namespace {
                 CoverBand orangeBand = ClassifyBandForTeam(TeamId::Orange, x);
                 CoverBand blueBand = ClassifyBandForTeam(TeamId::Blue, x);
 
-                coverSlotsOrange[static_cast<int>(orangeBand)].push_back({ x, y });
-                coverSlotsBlue[static_cast<int>(blueBand)].push_back({ x, y });
+                state.coverSlotsOrange[static_cast<int>(orangeBand)].push_back({ x, y });
+                state.coverSlotsBlue[static_cast<int>(blueBand)].push_back({ x, y });
             }
         }
 
-        coverCatalogBuilt = true;
+        state.coverCatalogBuilt = true;
     }
 
     const std::vector<std::pair<int, int>>& GetCoverSlots(TeamId team, TeamState state)
     {
         BuildCoverCatalog();
         int idx = StateToIndex(state);
-        return (team == TeamId::Orange) ? coverSlotsOrange[idx] : coverSlotsBlue[idx];
+        const World::CommanderState& slots = World::Current().commanders;
+        return (team == TeamId::Orange) ? slots.coverSlotsOrange[idx] : slots.coverSlotsBlue[idx];
     }
 }
 
-static TeamState lastPlannedTeamState = TeamState::DEFEND;
-
 std::pair<int, int> Commander::ComputeEnemyFocus() const
 {
+    World& world = World::Current();
     const std::vector<NPC*>& enemies =
-        (commander && commander->getTeam() == TeamId::Orange) ? teamBlue : teamOrange;
+        (commander && commander->getTeam() == TeamId::Orange) ? world.teamBlue : world.teamOrange;
 
     double sumX = 0.0;
     double sumY = 0.0;
@@ -304,7 +299,7 @@ void Commander::AssignDeliverAmmo(NPC* porter, NPC* soldier, double now)
 {
     if (!porter || !soldier) return;
     if (!porter->CanTakeAssist()) {
-        printf("   [WARN] Porter %c assist limit reached (%d/%d). Assignment aborted.\n",
+        LOG_WARN(Commander, "Porter %c assist limit reached (%d/%d). Assignment aborted.",
             porter->getSymbol(), porter->GetAssistsDone(), NPC::ASSIST_LIMIT);
         return;
     }
@@ -318,10 +313,9 @@ void Commander::AssignDeliverAmmo(NPC* porter, NPC* soldier, double now)
     State* current = porter->getCurrentState();
     if (current) {
         current->OnExit(porter);
-        delete current;
     }
 
-    porter->setCurrentState(new GoDeliverAmmo(soldier));
+    porter->setCurrentState(porter->getStatePool().Acquire<GoDeliverAmmo>(soldier));
     porter->getCurrentState()->OnEnter(porter);
 
     lastOrderType = OrderType::DeliverAmmo;
@@ -331,8 +325,8 @@ void Commander::AssignDeliverAmmo(NPC* porter, NPC* soldier, double now)
 
 // Evaluate team condition: decide if attack / defend / retreat
 void Commander::EvaluateTeamStatus() {
-    double now = clock() / (double)CLOCKS_PER_SEC;
-    if (battleStartTime <= 0.0) {
+    double now = SimClock::Now();
+    if (battleStartTime < 0.0) {  // simulation time starts at 0
         battleStartTime = now;
     }
 
@@ -360,8 +354,9 @@ void Commander::EvaluateTeamStatus() {
         commanderHP = commander->getHP();
     }
 
+    World& world = World::Current();
     const std::vector<NPC*>& enemies =
-        (commander && commander->getTeam() == TeamId::Orange) ? teamBlue : teamOrange;
+        (commander && commander->getTeam() == TeamId::Orange) ? world.teamBlue : world.teamOrange;
 
     int enemiesAlive = 0;
     double enemyHpSum = 0.0;
@@ -425,13 +420,13 @@ void Commander::EvaluateTeamStatus() {
     if (teamState != previousState) {
         switch (teamState) {
         case TeamState::ATTACK:
-            printf("[INFO] Commander orders ATTACK.\n");
+            LOG_INFO(Commander, "Commander orders ATTACK.");
             break;
         case TeamState::DEFEND:
-            printf("[INFO] Commander switches to DEFEND mode.\n");
+            LOG_INFO(Commander, "Commander switches to DEFEND mode.");
             break;
         case TeamState::RETREAT:
-            printf("[WARN] Commander orders RETREAT.\n");
+            LOG_WARN(Commander, "Commander orders RETREAT.");
             break;
         }
     }
@@ -442,7 +437,7 @@ void Commander::PlanAndAssignOrders()
 {
     // If commander is dead, warriors continue on their own (without combined visibility map)
     if (!commander || !commander->IsAlive()) {
-        printf("[WARN] Commander is dead. Warriors continue independently.\n");
+        LOG_WARN(Commander, "Commander is dead. Warriors continue independently.");
         
         // Warriors can continue fighting but without commander's strategic planning
         for (NPC* npc : team) {
@@ -452,7 +447,7 @@ void Commander::PlanAndAssignOrders()
             if (npc->getRole() == Role::Warrior) {
                 // Warriors can continue fighting independently
                 if (!npc->getCurrentState()) {
-                    npc->setCurrentState(new GoToCombat());
+                    npc->setCurrentState(npc->getStatePool().Acquire<GoToCombat>());
                     npc->getCurrentState()->OnEnter(npc);
                 }
             }
@@ -466,10 +461,10 @@ void Commander::PlanAndAssignOrders()
     // Use visibility map to plan attack routes (only if commander is alive)
     PlanAttackRoute();
 
-    double now = clock() / (double)CLOCKS_PER_SEC;
+    double now = SimClock::Now();
 
     EvaluateTeamStatus();
-    printf("[INFO] Commander %c assigning updated orders based on security map.\n", commander->getSymbol());
+    LOG_DEBUG(Commander, "Commander %c assigning updated orders based on security map.", commander->getSymbol());
 
     std::vector<std::pair<int, int>> reservedPositions;
 
@@ -581,7 +576,7 @@ void Commander::PlanAndAssignOrders()
             }
         }
 
-        if (teamState != lastPlannedTeamState) {
+        if (teamState != World::Current().commanders.lastPlannedTeamState) {
             shouldReassign = true;
         }
         
@@ -593,7 +588,6 @@ void Commander::PlanAndAssignOrders()
         // Clean up old state
         if (currentState) {
             currentState->OnExit(npc);
-            delete currentState;
             npc->setCurrentState(nullptr);
         }
 
@@ -606,8 +600,8 @@ void Commander::PlanAndAssignOrders()
         case Role::Warrior:
             {
                 if (forcedRetreat) {
-                    printf("   [INFO] Forcing %c to retreat from danger (security=%.2f)\n", symbol, security);
-                    npc->setCurrentState(new GoToCover());
+                    LOG_INFO(Commander, "Forcing %c to retreat from danger (security=%.2f)", symbol, security);
+                    npc->setCurrentState(npc->getStatePool().Acquire<GoToCover>());
                     npc->getCurrentState()->OnEnter(npc);
                     break;
                 }
@@ -621,7 +615,7 @@ void Commander::PlanAndAssignOrders()
                     std::vector<size_t> order(slots.size());
                     std::iota(order.begin(), order.end(), 0);
                     for (size_t i = 0; i < order.size(); ++i) {
-                        size_t j = i + (rand() % (order.size() - i));
+                        size_t j = i + (World::Current().Random() % (order.size() - i));
                         std::swap(order[i], order[j]);
                     }
 
@@ -687,25 +681,25 @@ void Commander::PlanAndAssignOrders()
                 }
 
                 if (npc->getAmmo() == 0 && npc->getSupply() == 0) {
-                    printf("   [WARN] %c fully depleted, ordering supply run.\n", symbol);
-                    npc->setCurrentState(new GoToSupply());
+                    LOG_WARN(Commander, "%c fully depleted, ordering supply run.", symbol);
+                    npc->setCurrentState(npc->getStatePool().Acquire<GoToSupply>());
                     npc->getCurrentState()->OnEnter(npc);
                     break;
                 }
 
                 // If warrior is in danger, prioritize cover
                 if (security > 0.5 && npc->getHP() < 50) {
-                    printf("   [WARN] %c is in danger (security=%.2f, HP=%d) - sending to cover\n", 
+                    LOG_WARN(Commander, "%c is in danger (security=%.2f, HP=%d) - sending to cover", 
                         symbol, security, npc->getHP());
-                    npc->setCurrentState(new GoToCover());
+                    npc->setCurrentState(npc->getStatePool().Acquire<GoToCover>());
                 } else if (teamState == TeamState::ATTACK) {
-                    printf("   [INFO] Assigning GoToCombat() to %c (security=%.2f)\n", symbol, security);
-                    npc->setCurrentState(new GoToCombat());
+                    LOG_INFO(Commander, "Assigning GoToCombat() to %c (security=%.2f)", symbol, security);
+                    npc->setCurrentState(npc->getStatePool().Acquire<GoToCombat>());
                 } else if (teamState == TeamState::DEFEND || teamState == TeamState::RETREAT) {
-                    printf("   [INFO] Assigning GoToCover() to %c (DEFEND/RETREAT mode)\n", symbol);
-                    npc->setCurrentState(new GoToCover());
+                    LOG_INFO(Commander, "Assigning GoToCover() to %c (DEFEND/RETREAT mode)", symbol);
+                    npc->setCurrentState(npc->getStatePool().Acquire<GoToCover>());
                 } else {
-                    npc->setCurrentState(new GoToCombat());
+                    npc->setCurrentState(npc->getStatePool().Acquire<GoToCombat>());
                 }
                 npc->getCurrentState()->OnEnter(npc);
             }
@@ -715,28 +709,28 @@ void Commander::PlanAndAssignOrders()
             {
         bool hasCriticalPatients = !criticalInjured.empty();
         if (forcedRetreat && !hasCriticalPatients) {
-            printf("   [WARN] Medic %c under heavy fire, retreating to cover (security=%.2f)\n", symbol, security);
-            npc->setCurrentState(new GoToCover());
+            LOG_WARN(Commander, "Medic %c under heavy fire, retreating to cover (security=%.2f)", symbol, security);
+            npc->setCurrentState(npc->getStatePool().Acquire<GoToCover>());
             npc->getCurrentState()->OnEnter(npc);
             break;
         }
 
                 if (!npc->CanTakeAssist()) {
-                    printf("   [INFO] Medic %c assist limit reached (%d/%d). Returning to warehouse.\n",
+                    LOG_INFO(Commander, "Medic %c assist limit reached (%d/%d). Returning to warehouse.",
                         symbol, npc->GetAssistsDone(), NPC::ASSIST_LIMIT);
                     Map::WarehouseInfo wh = Map::GetWarehouseForTeam(npc->getTeam());
-                    npc->setCurrentState(new ReturnToWarehouse(wh.medX, wh.medY));
+                    npc->setCurrentState(npc->getStatePool().Acquire<ReturnToWarehouse>(wh.medX, wh.medY));
                     npc->getCurrentState()->OnEnter(npc);
                     break;
                 }
 
                 if (criticalInjured.empty()) {
                     if (npc->getSupply() == 0) {
-                        printf("   [INFO] Medic %c depleted, heading to med supply.\n", symbol);
-                        npc->setCurrentState(new GoToMedSupply());
+                        LOG_INFO(Commander, "Medic %c depleted, heading to med supply.", symbol);
+                        npc->setCurrentState(npc->getStatePool().Acquire<GoToMedSupply>());
                         npc->getCurrentState()->OnEnter(npc);
                     } else if (security > 0.45) {
-                        npc->setCurrentState(new GoToCover());
+                        npc->setCurrentState(npc->getStatePool().Acquire<GoToCover>());
                         npc->getCurrentState()->OnEnter(npc);
                     }
                     break;
@@ -748,11 +742,11 @@ void Commander::PlanAndAssignOrders()
                 if (injured && injured != npc) hasInjured = true;
 
                 if (hasInjured) {
-                    printf("   [INFO] Assigning GoToHeal() to %c (injured ally detected)\n", symbol);
-                    npc->setCurrentState(new GoToHeal());
+                    LOG_INFO(Commander, "Assigning GoToHeal() to %c (injured ally detected)", symbol);
+                    npc->setCurrentState(npc->getStatePool().Acquire<GoToHeal>());
                 } else {
-                    printf("   [INFO] No injured allies, sending %c to medical supply.\n", symbol);
-                    npc->setCurrentState(new GoToMedSupply());
+                    LOG_INFO(Commander, "No injured allies, sending %c to medical supply.", symbol);
+                    npc->setCurrentState(npc->getStatePool().Acquire<GoToMedSupply>());
                 }
                 npc->getCurrentState()->OnEnter(npc);
             }
@@ -761,24 +755,24 @@ void Commander::PlanAndAssignOrders()
         case Role::Porter:
             {
                 if (forcedRetreat) {
-                    printf("   [WARN] Porter %c retreating from danger (security=%.2f)\n", symbol, security);
-                    npc->setCurrentState(new GoToCover());
+                    LOG_WARN(Commander, "Porter %c retreating from danger (security=%.2f)", symbol, security);
+                    npc->setCurrentState(npc->getStatePool().Acquire<GoToCover>());
                     npc->getCurrentState()->OnEnter(npc);
                     break;
                 }
 
                 if (!npc->CanTakeAssist()) {
-                    printf("   [INFO] Porter %c assist limit reached (%d/%d). Returning to warehouse.\n",
+                    LOG_INFO(Commander, "Porter %c assist limit reached (%d/%d). Returning to warehouse.",
                         symbol, npc->GetAssistsDone(), NPC::ASSIST_LIMIT);
                     Map::WarehouseInfo wh = Map::GetWarehouseForTeam(npc->getTeam());
-                    npc->setCurrentState(new ReturnToWarehouse(wh.ammoX, wh.ammoY));
+                    npc->setCurrentState(npc->getStatePool().Acquire<ReturnToWarehouse>(wh.ammoX, wh.ammoY));
                     npc->getCurrentState()->OnEnter(npc);
                     break;
                 }
 
                 if (npc->getSupply() == 0 && npc->getCurrentState() && typeid(*npc->getCurrentState()) != typeid(GoToSupply)) {
-                    printf("   [INFO] Porter %c depleted, returning to warehouse.\n", symbol);
-                    npc->setCurrentState(new GoToSupply());
+                    LOG_INFO(Commander, "Porter %c depleted, returning to warehouse.", symbol);
+                    npc->setCurrentState(npc->getStatePool().Acquire<GoToSupply>());
                     npc->getCurrentState()->OnEnter(npc);
                     break;
                 }
@@ -787,19 +781,19 @@ void Commander::PlanAndAssignOrders()
                 bool needsAmmo = (ammoStarved != nullptr);
 
                 if (needsAmmo && !HasActiveSupplyFor(ammoStarved)) {
-                    printf("   [INFO] Assigning GoDeliverAmmo() to %c (warrior needs ammo)\n", symbol);
+                    LOG_INFO(Commander, "Assigning GoDeliverAmmo() to %c (warrior needs ammo)", symbol);
                     AssignDeliverAmmo(npc, ammoStarved, now);
                     break;
                 }
 
                 if (needsAmmo) {
-                    printf("   [INFO] Porter %c: supply already en route to warrior %c, standing by at warehouse.\n",
+                    LOG_INFO(Commander, "Porter %c: supply already en route to warrior %c, standing by at warehouse.",
                         symbol, ammoStarved->getSymbol());
-                    npc->setCurrentState(new GoToSupply());
+                    npc->setCurrentState(npc->getStatePool().Acquire<GoToSupply>());
                     npc->getCurrentState()->OnEnter(npc);
                 } else {
-                    printf("   [INFO] Porter %c heading to ammo supply.\n", symbol);
-                    npc->setCurrentState(new GoToSupply());
+                    LOG_INFO(Commander, "Porter %c heading to ammo supply.", symbol);
+                    npc->setCurrentState(npc->getStatePool().Acquire<GoToSupply>());
                     npc->getCurrentState()->OnEnter(npc);
                 }
             }
@@ -810,8 +804,8 @@ void Commander::PlanAndAssignOrders()
         }
     }
 
-    printf("[INFO] Commander %c finished assigning orders.\n", commander->getSymbol());
-    lastPlannedTeamState = teamState;
+    LOG_DEBUG(Commander, "Commander %c finished assigning orders.", commander->getSymbol());
+    World::Current().commanders.lastPlannedTeamState = teamState;
 
 
 }
@@ -822,25 +816,24 @@ void Commander::ReceiveReport(NPC* sender, ReportType type)
     if (!sender || !sender->IsAlive()) return;
     
     if (!commander || !commander->IsAlive()) {
-        printf("💀 Commander is dead! Warriors continue fighting independently...\n");
+        LOG_WARN(Commander, "Commander is dead! Warriors continue fighting independently...");
         return;
     }
 
     bool assignmentMade = false;
     
     if (type == ReportType::LOW_AMMO) {
-        printf("📢 Commander %c received report: %c has LOW AMMO! (Ammo: %d)\n",
+        LOG_INFO(Commander, "Commander %c received report: %c has LOW AMMO! (Ammo: %d)",
             commander->getSymbol(), sender->getSymbol(), sender->getAmmo());
         
         for (NPC* npc : team) {
             if (npc->getRole() == Role::Porter && npc->IsAlive()) {
                 if (typeid(*npc->getCurrentState()) != typeid(GoDeliverAmmo)) {
-                    printf("   📦 Commander assigns GoDeliverAmmo to Porter %c for %c\n", npc->getSymbol(), sender->getSymbol());
+                    LOG_INFO(Commander, "Commander assigns GoDeliverAmmo to Porter %c for %c", npc->getSymbol(), sender->getSymbol());
                     
-                    if (npc->getCurrentState()) delete npc->getCurrentState();
                     npc->setTargetNPC(sender);
                     npc->setIsDelivering(true);
-                    npc->setCurrentState(new GoDeliverAmmo());
+                    npc->setCurrentState(npc->getStatePool().Acquire<GoDeliverAmmo>());
                     npc->getCurrentState()->OnEnter(npc);
                     assignmentMade = true;
                     break;
@@ -849,7 +842,7 @@ void Commander::ReceiveReport(NPC* sender, ReportType type)
         }
     }
     else if (type == ReportType::INJURED) {
-        printf("📢 Commander %c received report: %c is INJURED! (HP=%d)\n",
+        LOG_INFO(Commander, "Commander %c received report: %c is INJURED! (HP=%d)",
             commander->getSymbol(), sender->getSymbol(), sender->getHP());
             
         for (NPC* npc : team) {
@@ -861,17 +854,16 @@ void Commander::ReceiveReport(NPC* sender, ReportType type)
                 bool senderSupport = (sender->getRole() != Role::Warrior);
 
                 if (!alreadyHealing || senderCritical || senderSupport) {
-                    printf("   💉 Commander assigns GoToHeal to Medic %c for %c\n", 
+                    LOG_INFO(Commander, "Commander assigns GoToHeal to Medic %c for %c", 
                         npc->getSymbol(), sender->getSymbol());
                     
                     if (currentState) {
                         currentState->OnExit(npc);
-                        delete currentState;
                         npc->setCurrentState(nullptr);
                     }
                     npc->setTargetNPC(sender);
                     npc->setIsDelivering(true);
-                    npc->setCurrentState(new GoToHeal());
+                    npc->setCurrentState(npc->getStatePool().Acquire<GoToHeal>());
                     npc->getCurrentState()->OnEnter(npc);
                     assignmentMade = true;
                     break;
@@ -880,7 +872,7 @@ void Commander::ReceiveReport(NPC* sender, ReportType type)
         }
     }
     else if (type == ReportType::ENEMY_SPOTTED) {
-        printf("📢 Commander %c received report: %c spotted an ENEMY!\n",
+        LOG_INFO(Commander, "Commander %c received report: %c spotted an ENEMY!",
             commander->getSymbol(), sender->getSymbol());
     }
 
@@ -892,7 +884,7 @@ void Commander::MoveToSafePosition()
 {
     if (!commander || !commander->IsAlive()) return;
     
-    double now = clock() / (double)CLOCKS_PER_SEC;
+    double now = SimClock::Now();
     if (lastRepositionCheck <= 0.0) {
         lastRepositionCheck = now;
     }
@@ -909,10 +901,10 @@ void Commander::MoveToSafePosition()
 
     if (forceMove || periodicMove) {
         if (forceMove) {
-            printf("[WARN] Commander %c is in danger (security=%.2f), moving to safe position.\n",
+            LOG_WARN(Commander, "Commander %c is in danger (security=%.2f), moving to safe position.",
                 commander->getSymbol(), security);
         } else {
-            printf("[INFO] Commander %c repositions to avoid clustering (security=%.2f).\n",
+            LOG_INFO(Commander, "Commander %c repositions to avoid clustering (security=%.2f).",
                 commander->getSymbol(), security);
         }
         
@@ -922,7 +914,7 @@ void Commander::MoveToSafePosition()
             std::vector<std::pair<int, int>> path;
             if (Path::FindSafePath(cx, cy, safePos.first, safePos.second, commander->getTeam(), path, 0.8, commander->GetId())) {
                 commander->SetPath(path);
-                printf("[INFO] Commander %c moving to safe position (%d,%d)\n",
+                LOG_INFO(Commander, "Commander %c moving to safe position (%d,%d)",
                     commander->getSymbol(), safePos.first, safePos.second);
             }
         }
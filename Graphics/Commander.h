@@ -41,7 +41,7 @@ public:
         team(members),
         teamState(TeamState::DEFEND),
         lastRepositionCheck(0.0),
-        battleStartTime(0.0),
+        battleStartTime(-1.0),
         lastAttackIssuedTime(-100.0),
         lastStateChangeTime(0.0),
         lastOrderType(OrderType::None),
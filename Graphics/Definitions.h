@@ -2,7 +2,7 @@
 
 #define MSZ 100
 
-#define SPEED  0.03
+#define SPEED  1.8     // NPC movement speed (cells per second of simulation time)
 #define M_PI     3.14159265358979323846
 
 #ifndef SHOW_SECURITY
@@ -34,6 +34,7 @@ const int PORTER_RELOAD_AMOUNT = MAX_AMMO; // Ammo restored by a single crate
 
 const double ENEMY_REPORT_COOLDOWN = 3.0;  // Seconds between enemy spotted reports
 const double ORDER_DEBOUNCE_SECONDS = 2.0; // Prevent spamming identical orders
+const int REPLAN_BLOCKED_TICKS = 3;        // Blocked ticks before repairing the route (cover after 6)
 
 
 
@@ -0,0 +1,150 @@
+#include <algorithm>
+#include <limits>
+#include "FlowField.h"
+#include "SimClock.h"
+#include "World.h"
+#include "Log.h"
+
+namespace {
+    const int DX[4] = { +1, -1, 0, 0 };
+    const int DY[4] = { 0, 0, +1, -1 };
+}
+
+bool FlowFieldCache::IsStale(const Field& f) const
+{
+    if (f.terrainHash != Map::GetTerrainHash()) return true;
+    if (f.securityVersion == Map::GetSecurityVersion(f.team)) return false;
+    double age = SimClock::Now() - f.builtAt;
+    return age < 0.0 || age >= REFRESH_SECONDS;    // negative: built before a SimClock reset
+}
+
+void FlowFieldCache::Build(Field& f)
+{
+    const int N = Map::W * Map::H;
+    f.cost.assign(N, std::numeric_limits<float>::infinity());
+    f.next.assign(N, (unsigned char)NO_STEP);
+    f.settled.assign(N, 0);
+    f.open.clear();
+
+    f.cost[f.goal] = 0.0f;
+    f.open.push_back({ 0.0f, f.goal });
+
+    f.terrainHash = Map::GetTerrainHash();
+    f.securityVersion = Map::GetSecurityVersion(f.team);
+    f.builtAt = SimClock::Now();
+    ++builds;
+
+    LOG_DEBUG(Path, "Flow field started toward (%d,%d) for team %d (weight %.2f)",
+        f.goal % Map::W, f.goal / Map::W, (int)f.team, f.securityWeight);
+}
+
+void FlowFieldCache::Settle(Field& f, int cell)
+{
+    const Map::TerrainPlanes& planes = Map::Planes();
+
+    while (!f.settled[cell] && !f.open.empty()) {
+        std::pop_heap(f.open.begin(), f.open.end());
+        Frontier cur = f.open.back();
+        f.open.pop_back();
+        if (f.settled[cur.cell]) continue;
+        f.settled[cur.cell] = 1;
+
+        int cx = cur.cell % Map::W;
+        int cy = cur.cell / Map::W;
+
+        // Stepping from a neighbour into this cell costs what FindSafePath charges for entering it
+        double security = Map::GetSecurityValue(cy, cx, f.team);
+        float enter = (float)(1.0 + f.securityWeight * security * 10.0);
+
+        for (int k = 0; k < 4; ++k) {
+            int nx = cx + DX[k];
+            int ny = cy + DY[k];
+            if (!planes.Walkable(nx, ny)) continue;
+
+            int ni = ny * Map::W + nx;
+            float tentative = cur.cost + enter;
+            if (tentative < f.cost[ni]) {
+                f.cost[ni] = tentative;
+                f.next[ni] = (unsigned char)(k ^ 1);     // opposite direction leads back to cur
+                f.open.push_back({ tentative, ni });
+                std::push_heap(f.open.begin(), f.open.end());
+            }
+        }
+    }
+}
+
+FlowFieldCache::Field* FlowFieldCache::Acquire(int gx, int gy, TeamId team, double securityWeight)
+{
+    if (!Map::InBounds(gx, gy) || !Map::IsWalkable(gx, gy)) return nullptr;
+
+    int goal = gy * Map::W + gx;
+    ++useCounter;
+
+    Field* slot = nullptr;
+    for (Field& f : fields) {
+        if (f.goal == goal && f.team == team && f.securityWeight == securityWeight) {
+            slot = &f;
+            break;
+        }
+    }
+
+    if (!slot) {
+        if ((int)fields.size() < MAX_FIELDS) {
+            fields.emplace_back();
+            slot = &fields.back();
+        }
+        else {
+            slot = &fields[0];
+            for (Field& f : fields) {
+                if (f.lastUsed < slot->lastUsed) slot = &f;
+            }
+        }
+        slot->goal = goal;
+        slot->team = team;
+        slot->securityWeight = securityWeight;
+        Build(*slot);
+    }
+    else if (IsStale(*slot)) {
+        Build(*slot);
+    }
+
+    slot->lastUsed = useCounter;
+    return slot;
+}
+
+void FlowFieldCache::Clear()
+{
+    fields.clear();
+}
+
+bool FlowFieldCache::Route(int sx, int sy, int gx, int gy, TeamId team, double securityWeight, std::vector<Path::Cell>& out)
+{
+    if (!Map::InBounds(sx, sy) || !Map::IsWalkable(sx, sy)) return false;
+
+    Field* field = Acquire(gx, gy, team, securityWeight);
+    if (!field) return false;
+
+    int cell = sy * Map::W + sx;
+    Settle(*field, cell);
+    if (!field->settled[cell]) return false;
+
+    // Every cell on the chain settled before this one, so its direction is final
+    out.clear();
+    out.emplace_back(sx, sy);
+    while (cell != field->goal) {
+        unsigned char k = field->next[cell];
+        int x = cell % Map::W + DX[k];
+        int y = cell / Map::W + DY[k];
+        cell = y * Map::W + x;
+        out.emplace_back(x, y);
+    }
+    return true;
+}
+
+namespace Path
+{
+    bool FindFlowPath(int sx, int sy, int gx, int gy, TeamId team, std::vector<Cell>& out, double securityWeight)
+    {
+        return World::Current().flowFields.Route(sx, sy, gx, gy, team, securityWeight, out);
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <vector>
+#include "Roles.h"
+#include "Map.h"
+#include "Pathfinding.h"
+
+// ---------------------------------------------------------
+// FlowFieldCache - shared routes toward fixed team goals
+// A field is one Dijkstra from a goal cell, with the same security-weighted
+// step cost as Path::FindSafePath (occupancy and dynamic costs are left
+// out, they change every tick). Every settled cell keeps the direction of
+// its next step, so any number of NPCs heading to the same goal walk the
+// field instead of running their own A*. The search is resumed on demand:
+// it only expands until the requesting NPC's cell is settled, and the
+// next, farther request continues from its saved frontier.
+// A field is rebuilt when the terrain differs, or when the team's
+// security map has changed and the field is older than REFRESH_SECONDS.
+// ---------------------------------------------------------
+class FlowFieldCache {
+public:
+    static const int MAX_FIELDS = 8;            // least recently used field is replaced
+    static constexpr double REFRESH_SECONDS = 2.0;
+
+    struct Frontier {
+        float cost;
+        int cell;
+        // Min-heap on cost, then cell index, so equal costs settle in a fixed order
+        bool operator<(const Frontier& other) const
+        {
+            if (cost != other.cost) return cost > other.cost;
+            return cell > other.cell;
+        }
+    };
+
+    struct Field {
+        int goal = -1;                          // cell index, -1 = unused slot
+        TeamId team = TeamId::Orange;
+        double securityWeight = 0.0;
+        uint64_t terrainHash = 0;
+        unsigned int securityVersion = 0;
+        double builtAt = 0.0;                   // SimClock time
+        unsigned long long lastUsed = 0;
+        std::vector<float> cost;                // best known cost to the goal, final once settled
+        std::vector<unsigned char> next;        // direction of the next step (NO_STEP at the goal)
+        std::vector<unsigned char> settled;
+        std::vector<Frontier> open;             // saved Dijkstra frontier (binary heap)
+    };
+
+    static const unsigned char NO_STEP = 0xFF;
+
+    // Route from (sx,sy) to (gx,gy) along the team's field, start cell first.
+    // Returns false if the goal is not walkable or (sx,sy) cannot reach it.
+    bool Route(int sx, int sy, int gx, int gy, TeamId team, double securityWeight, std::vector<Path::Cell>& out);
+
+    // Drops every field
+    void Clear();
+
+    // Number of fields started so far (for profiling)
+    unsigned long long Builds() const { return builds; }
+
+private:
+    // Field toward (gx,gy) for the team, restarted if missing or stale
+    Field* Acquire(int gx, int gy, TeamId team, double securityWeight);
+    bool IsStale(const Field& f) const;
+    void Build(Field& f);
+    // Expands the field until 'cell' is settled or the frontier is empty
+    void Settle(Field& f, int cell);
+
+    std::vector<Field> fields;
+    unsigned long long useCounter = 0;
+    unsigned long long builds = 0;
+};
+
+namespace Path
+{
+    // Path from (sx,sy) to a shared goal read from the world's flow field
+    // for that goal (same layout as FindSafePath: start cell first).
+    // Use it for goals many NPCs share, such as warehouse entries.
+    bool FindFlowPath(int sx, int sy, int gx, int gy, TeamId team, std::vector<Cell>& out, double securityWeight = 0.5);
+}
@@ -1,21 +1,20 @@
 #include "GoDeliverAmmo.h"
+#include "StatePool.h"
 #include "NPC.h"
 #include "Map.h"
 #include "GoToCover.h"
 #include "GoToSupply.h"
-#include <stdio.h>
+#include "Log.h"
 #include <cmath>
-#include <ctime>
+#include "SimClock.h"
 #include <limits>
 #include <vector>
 #include <cstdlib>
 #include "Pathfinding.h"
 #include "Definitions.h"
+#include "World.h"
 #include "ReturnToWarehouse.h"
 
-extern std::vector<NPC*> teamOrange;
-extern std::vector<NPC*> teamBlue;
-
 namespace {
 
 int RoundToGrid(double value)
@@ -104,7 +103,7 @@ bool PlanPathToAlly(NPC* pn, NPC* target)
     auto pickRandom = [&](const std::vector<std::pair<int, int>>& candidates) -> std::vector<std::pair<int, int>> {
         std::vector<std::pair<int, int>> shuffled = candidates;
         for (size_t i = 0; i < shuffled.size(); ++i) {
-            size_t j = i + (rand() % (shuffled.size() - i));
+            size_t j = i + (World::Current().Random() % (shuffled.size() - i));
             std::swap(shuffled[i], shuffled[j]);
         }
         return shuffled;
@@ -125,15 +124,15 @@ bool PlanPathToAlly(NPC* pn, NPC* target)
             }
         }
         if (!exits.empty()) {
-            auto exitCell = exits[rand() % exits.size()];
-            printf("[WARN] Porter %c: stepping out of warehouse via (%d,%d).\n",
+            auto exitCell = exits[World::Current().Random() % exits.size()];
+            LOG_WARN(State, "Porter %c: stepping out of warehouse via (%d,%d).",
                 pn->getSymbol(), exitCell.first, exitCell.second);
             std::vector<std::pair<int, int>> escapePath;
             escapePath.emplace_back(exitCell.first, exitCell.second);
             pn->SetPath(escapePath);
             return true;
         }
-        printf("[ERROR] Porter %c: no walkable exit around (%d,%d).\n", pn->getSymbol(), sx, sy);
+        LOG_ERROR(State, "Porter %c: no walkable exit around (%d,%d).", pn->getSymbol(), sx, sy);
         return false;
     }
 
@@ -171,7 +170,7 @@ bool PlanPathToAlly(NPC* pn, NPC* target)
             }
             if (Path::FindSafePath(sx, sy, fallbackCover.first, fallbackCover.second, pn->getTeam(), path, 0.4, pn->GetId()) ||
                 Path::FindPath(sx, sy, fallbackCover.first, fallbackCover.second, path, pn->GetId())) {
-                printf("[PATH] Porter %c rerouting near ally cover (%d,%d)\n",
+                LOG_DEBUG(Path, "Porter %c rerouting near ally cover (%d,%d)",
                     pn->getSymbol(), fallbackCover.first, fallbackCover.second);
                 pn->SetPath(path);
                 return true;
@@ -182,7 +181,7 @@ bool PlanPathToAlly(NPC* pn, NPC* target)
 
     PrependDepotExit(pn, path);
 
-    printf("[PATH] Porter %c safe path to ally length=%zu from (%d,%d) -> (%d,%d)\n",
+    LOG_DEBUG(Path, "Porter %c safe path to ally length=%zu from (%d,%d) -> (%d,%d)",
         pn->getSymbol(), path.size(), sx, sy, goalX, goalY);
     pn->SetPath(path);
     return true;
@@ -193,8 +192,7 @@ bool FindLowAmmoAlly(NPC* pn, NPC*& outTarget)
     outTarget = nullptr;
     double bestDist = 1e9;
 
-    const std::vector<NPC*>& myTeam =
-        (pn->getTeam() == TeamId::Orange) ? teamOrange : teamBlue;
+    const std::vector<NPC*>& myTeam = World::Current().Team(pn->getTeam());
 
     for (NPC* ally : myTeam)
     {
@@ -224,17 +222,17 @@ bool FindLowAmmoAlly(NPC* pn, NPC*& outTarget)
 
 void GoDeliverAmmo::OnEnter(NPC* pn)
 {
-    printf("[STATE] Porter %c entering GoDeliverAmmo state.\n", pn->getSymbol());
+    LOG_INFO(State, "Porter %c entering GoDeliverAmmo state.", pn->getSymbol());
     pn->setIsResting(false);
     pn->setIsDelivering(true);
     waitingToDeliver = false;
-    lastDistanceCheckTime = clock() / (double)CLOCKS_PER_SEC;
+    lastDistanceCheckTime = SimClock::Now();
     lastDistanceToTarget = std::numeric_limits<double>::max();
 
     if (pn->getSupply() == 0) {
-        printf("[WARN] Porter %c has no ammo crates. Redirecting to warehouse.\n", pn->getSymbol());
+        LOG_WARN(State, "Porter %c has no ammo crates. Redirecting to warehouse.", pn->getSymbol());
         OnExit(pn);
-        pn->setCurrentState(new GoToSupply());
+        pn->setCurrentState(pn->getStatePool().Acquire<GoToSupply>());
         pn->getCurrentState()->OnEnter(pn);
         return;
     }
@@ -246,9 +244,9 @@ void GoDeliverAmmo::OnEnter(NPC* pn)
     }
 
     if (!targetLowAmmo && !FindLowAmmoAlly(pn, targetLowAmmo)) {
-        printf("[INFO] Porter %c found no ally needing ammo. Holding position.\n", pn->getSymbol());
+        LOG_INFO(State, "Porter %c found no ally needing ammo. Holding position.", pn->getSymbol());
         OnExit(pn);
-        pn->setCurrentState(new GoToCover());
+        pn->setCurrentState(pn->getStatePool().Acquire<GoToCover>());
         pn->getCurrentState()->OnEnter(pn);
         return;
     }
@@ -257,15 +255,15 @@ void GoDeliverAmmo::OnEnter(NPC* pn)
     targetY = targetLowAmmo->getY();
     pn->setTargetNPC(targetLowAmmo);
 
-    printf("[PATH] Porter %c moving to low-ammo ally at (%.1f, %.1f) [Ammo=%d]\n",
+    LOG_DEBUG(Path, "Porter %c moving to low-ammo ally at (%.1f, %.1f) [Ammo=%d]",
         pn->getSymbol(),
         targetLowAmmo->getX(), targetLowAmmo->getY(),
         targetLowAmmo->getAmmo());
 
     if (!PlanPathToAlly(pn, targetLowAmmo)) {
-        printf("[WARN] Porter %c: Need to step out before reaching ally. Moving to cover.\n", pn->getSymbol());
+        LOG_WARN(State, "Porter %c: Need to step out before reaching ally. Moving to cover.", pn->getSymbol());
         OnExit(pn);
-        pn->setCurrentState(new GoToCover());
+        pn->setCurrentState(pn->getStatePool().Acquire<GoToCover>());
         pn->getCurrentState()->OnEnter(pn);
         return;
     }
@@ -276,17 +274,17 @@ void GoDeliverAmmo::Transition(NPC* pn)
     if (!pn) return;
 
     if (!targetLowAmmo || !targetLowAmmo->IsAlive()) {
-        printf("[WARN] Porter %c: Target unavailable. Standing down.\n", pn->getSymbol());
+        LOG_WARN(State, "Porter %c: Target unavailable. Standing down.", pn->getSymbol());
         OnExit(pn);
-        pn->setCurrentState(new GoToSupply());
+        pn->setCurrentState(pn->getStatePool().Acquire<GoToSupply>());
         pn->getCurrentState()->OnEnter(pn);
         return;
     }
 
     if (!targetLowAmmo->NeedsAmmo()) {
-        printf("[INFO] Porter %c: Target already resupplied. Returning.\n", pn->getSymbol());
+        LOG_INFO(State, "Porter %c: Target already resupplied. Returning.", pn->getSymbol());
         OnExit(pn);
-        pn->setCurrentState(new GoToSupply());
+        pn->setCurrentState(pn->getStatePool().Acquire<GoToSupply>());
         pn->getCurrentState()->OnEnter(pn);
         return;
     }
@@ -296,7 +294,7 @@ void GoDeliverAmmo::Transition(NPC* pn)
 
     double distance = Distance(pn->getX(), pn->getY(), targetX, targetY);
     const double DELIVERY_RADIUS = 3.5;
-    double now = clock() / (double)CLOCKS_PER_SEC;
+    double now = SimClock::Now();
 
     if (distance <= DELIVERY_RADIUS) {
         if (!waitingToDeliver) {
@@ -304,7 +302,7 @@ void GoDeliverAmmo::Transition(NPC* pn)
             pn->setIsMoving(false);
             waitingToDeliver = true;
             targetLowAmmo->RefillAmmo();
-            printf("[INFO] [P] delivered ammo to [%c] at (%.1f, %.1f)\n",
+            LOG_INFO(State, "[P] delivered ammo to [%c] at (%.1f, %.1f)",
                 targetLowAmmo->getSymbol(), targetX, targetY);
 
             double assistedX = targetLowAmmo->getX();
@@ -312,14 +310,14 @@ void GoDeliverAmmo::Transition(NPC* pn)
             pn->consumeSupply(1);
             pn->RegisterAssistCompletion();
             if (!pn->CanTakeAssist()) {
-                printf("[INFO] Porter %c reached assist limit (%d/%d).\n",
+                LOG_INFO(State, "Porter %c reached assist limit (%d/%d).",
                     pn->getSymbol(), pn->GetAssistsDone(), NPC::ASSIST_LIMIT);
             }
             pn->setIsDelivering(false);
             OnExit(pn);
             Map::WarehouseInfo wh = Map::GetWarehouseForTeam(pn->getTeam());
-            printf("[INFO] Porter %c returning to warehouse standby.\n", pn->getSymbol());
-            pn->setCurrentState(new ReturnToWarehouse(wh.ammoX, wh.ammoY, 4.0, assistedX, assistedY));
+            LOG_INFO(State, "Porter %c returning to warehouse standby.", pn->getSymbol());
+            pn->setCurrentState(pn->getStatePool().Acquire<ReturnToWarehouse>(wh.ammoX, wh.ammoY, 4.0, assistedX, assistedY));
             pn->getCurrentState()->OnEnter(pn);
         }
         return;
@@ -328,13 +326,13 @@ void GoDeliverAmmo::Transition(NPC* pn)
     if (pn->getIsMoving()) {
         if ((now - lastDistanceCheckTime) > 1.0) {
             if (distance >= lastDistanceToTarget - 0.2) {
-                printf("[WARN] Porter %c progress stalled at distance %.2f. Replanning route.\n",
+                LOG_WARN(State, "Porter %c progress stalled at distance %.2f. Replanning route.",
                     pn->getSymbol(), distance);
                 if (!PlanPathToAlly(pn, targetLowAmmo)) {
-                    printf("[ERROR] Porter %c unable to find alternate path to ally. Seeking cover.\n",
+                    LOG_ERROR(State, "Porter %c unable to find alternate path to ally. Seeking cover.",
                         pn->getSymbol());
                     OnExit(pn);
-                    pn->setCurrentState(new GoToCover());
+                    pn->setCurrentState(pn->getStatePool().Acquire<GoToCover>());
                     pn->getCurrentState()->OnEnter(pn);
                     return;
                 }
@@ -346,9 +344,9 @@ void GoDeliverAmmo::Transition(NPC* pn)
     }
 
     if (!PlanPathToAlly(pn, targetLowAmmo)) {
-        printf("[WARN] Porter %c stuck en route. Replanning failed, seeking cover.\n", pn->getSymbol());
+        LOG_WARN(State, "Porter %c stuck en route. Replanning failed, seeking cover.", pn->getSymbol());
         OnExit(pn);
-        pn->setCurrentState(new GoToCover());
+        pn->setCurrentState(pn->getStatePool().Acquire<GoToCover>());
         pn->getCurrentState()->OnEnter(pn);
     }
 }
@@ -1,44 +1,36 @@
-﻿#include <time.h>
-#include <stdio.h>
+﻿#include "SimClock.h"
+#include "Log.h"
 #include <cmath>
+#include <algorithm>
 #include <typeinfo>
 #include "GoToCombat.h"
+#include "StatePool.h"
 #include "NPC.h"
 #include "GoToCover.h"   // go to cover after fight
 #include "GoToSupply.h"  // if needs ammo
 #include "Pathfinding.h"
+#include "PathService.h"
 #include "Map.h"
 #include "Commander.h"   // for reports
 #include "Definitions.h"
+#include "World.h"
 
-// Global access to both teams
-extern std::vector<NPC*> teamOrange;
-extern std::vector<NPC*> teamBlue;
+// Shared combat timers live in the current world
+static World::CombatState& Combat() { return World::Current().combat; }
 
-static double lastShotTime = 0;
-static double combatStartTime = 0;
-static Role lastThrowerRole = Role::Commander;
 static void ExitCombatState(NPC* pn)
 {
     if (!pn) return;
     pn->setIsEngaging(false);
-    printf("[STATE] [%c] exited combat state.\n", pn->getSymbol());
+    LOG_INFO(State, "[%c] exited combat state.", pn->getSymbol());
 }
 
-static bool AlliesWithinRadius(const std::vector<NPC*>& allies, const NPC* self, double px, double py, double radiusSq)
+static bool AlliesWithinRadius(const NPC* self, double px, double py, double radius)
 {
-    for (NPC* ally : allies) {
-        if (!ally || ally == self || !ally->IsAlive()) continue;
-        double dx = ally->getX() - px;
-        double dy = ally->getY() - py;
-        if ((dx * dx + dy * dy) <= radiusSq) {
-            return true;
-        }
-    }
-    return false;
+    return World::Current().npcGrid.AnyInRadius(self->getTeam(), px, py, radius, self);
 }
 
-static bool ClearAllyLineOfFire(NPC* shooter, NPC* target, const std::vector<NPC*>& allies)
+static bool ClearAllyLineOfFire(NPC* shooter, NPC* target)
 {
     double sx = shooter->getX();
     double sy = shooter->getY();
@@ -50,6 +42,12 @@ static bool ClearAllyLineOfFire(NPC* shooter, NPC* target, const std::vector<NPC
     if (targetDistSq < 1e-6) return false;
 
     double invLenSq = 1.0 / targetDistSq;
+    double safeRadius = std::max(0.6, shooter->getSize() * 0.4);
+
+    // Only allies near the segment can block it: query the circle around its midpoint
+    std::vector<NPC*> allies;
+    World::Current().npcGrid.QueryRadius(shooter->getTeam(), sx + 0.5 * dirX, sy + 0.5 * dirY,
+        0.5 * std::sqrt(targetDistSq) + safeRadius + 0.01, allies);
 
     for (NPC* ally : allies) {
         if (!ally || ally == shooter || ally == target || !ally->IsAlive()) continue;
@@ -65,7 +63,6 @@ static bool ClearAllyLineOfFire(NPC* shooter, NPC* target, const std::vector<NPC
         double distY = ally->getY() - closestY;
         double distSq = distX * distX + distY * distY;
 
-        double safeRadius = std::max(0.6, shooter->getSize() * 0.4);
         if (distSq <= safeRadius * safeRadius) {
             return false;
         }
@@ -79,13 +76,13 @@ void GoToCombat::OnEnter(NPC* pn)
 {
     if (pn->getRole() != Role::Warrior)
     {
-        printf("[WARN] [%c] cannot start combat because role is not warrior.\n", pn->getSymbol());
+        LOG_WARN(State, "[%c] cannot start combat because role is not warrior.", pn->getSymbol());
         return;
     }
 
     pn->setIsEngaging(true);
-    combatStartTime = clock();
-    lastShotTime = 0;
+    Combat().combatStartTime = SimClock::Now();
+    Combat().lastShotTime = 0;
 
     int sx = (int)pn->getX();
     int sy = (int)pn->getY();
@@ -134,8 +131,7 @@ void GoToCombat::OnEnter(NPC* pn)
                     int nx = currentX + ox;
                     int ny = currentY + oy;
                     if (!Map::InBounds(nx, ny)) continue;
-                    Map::Cell c = Map::Get(nx, ny);
-                    if (c == Map::TREE || c == Map::ROCK || c == Map::WAREHOUSE) {
+                    if (Map::BlocksBullets(nx, ny)) {
                         hasNearbyCover = true;
                         break;
                     }
@@ -157,43 +153,44 @@ void GoToCombat::OnEnter(NPC* pn)
     if (bestAmdaX == -1) {
         bestAmdaX = targetX;
         bestAmdaY = targetY;
-        printf("[WARN] [%c] No ideal firing position found, targeting zone (%d,%d).\n", pn->getSymbol(), bestAmdaX, bestAmdaY);
+        LOG_WARN(State, "[%c] No ideal firing position found, targeting zone (%d,%d).", pn->getSymbol(), bestAmdaX, bestAmdaY);
     }
     else {
         double finalRisk = Map::GetSecurityValue(bestAmdaY, bestAmdaX, teamId);
-        printf("[INFO] [%c] Selected firing position (%d,%d) risk=%.2f\n", pn->getSymbol(), bestAmdaX, bestAmdaY, finalRisk);
+        LOG_INFO(State, "[%c] Selected firing position (%d,%d) risk=%.2f", pn->getSymbol(), bestAmdaX, bestAmdaY, finalRisk);
     }
 
-	// Plan path to the selected position
-    std::vector<std::pair<int, int>> path;
+    pn->clearOrderTarget();
 
-    if (Path::FindSafePath(sx, sy, bestAmdaX, bestAmdaY, teamId, path, 0.9, pn->GetId()))
-    {
-        pn->SetPath(path);
-        printf("[PATH] [%c] Safe path length=%zu\n", pn->getSymbol(), path.size());
-    }
-    else
-    {
-        printf("[WARN] [%c] Could not find strict safe path, relaxing weight.\n", pn->getSymbol());
-        if (Path::FindSafePath(sx, sy, bestAmdaX, bestAmdaY, teamId, path, 0.6, pn->GetId())) {
-            pn->SetPath(path);
-            printf("[PATH] [%c] Safe path (relaxed) length=%zu\n", pn->getSymbol(), path.size());
-        }
-        else if (Path::FindPath(sx, sy, bestAmdaX, bestAmdaY, path, pn->GetId())) {
-            pn->SetPath(path);
-            printf("[PATH] [%c] Using fallback A* path length=%zu\n", pn->getSymbol(), path.size());
+	// Plan path to the selected position
+    Path::Request request;
+    request.sx = sx;
+    request.sy = sy;
+    request.gx = bestAmdaX;
+    request.gy = bestAmdaY;
+    request.team = teamId;
+    request.ignoreNpcId = pn->GetId();
+    request.safeWeights = { 0.9, 0.6 };
+
+    Path::RequestPath(pn, request, [](NPC* npc, Path::Result& result) {
+        if (result.attempt != 0) {
+            LOG_WARN(State, "[%c] Could not find strict safe path, relaxing weight.", npc->getSymbol());
         }
-        else
-        {
-            printf("[ERROR] [%c] Could not find path to target. Switching to cover.\n", pn->getSymbol());
-            pn->clearOrderTarget();
-            pn->setCurrentState(new GoToCover());
-            pn->getCurrentState()->OnEnter(pn);
+        if (!result.Found()) {
+            LOG_ERROR(State, "[%c] Could not find path to target. Switching to cover.", npc->getSymbol());
+            npc->setCurrentState(npc->getStatePool().Acquire<GoToCover>());
+            npc->getCurrentState()->OnEnter(npc);
             return;
         }
-    }
 
-    pn->clearOrderTarget();
+        npc->SetPath(result.path);
+        if (result.attempt == 0)
+            LOG_DEBUG(Path, "[%c] Safe path length=%zu", npc->getSymbol(), result.path.size());
+        else if (result.attempt == 1)
+            LOG_DEBUG(Path, "[%c] Safe path (relaxed) length=%zu", npc->getSymbol(), result.path.size());
+        else
+            LOG_DEBUG(Path, "[%c] Using fallback A* path length=%zu", npc->getSymbol(), result.path.size());
+    });
 }
 
 // Combat loop
@@ -202,16 +199,23 @@ void GoToCombat::Transition(NPC* pn)
     if (pn->getRole() != Role::Warrior || !pn->IsAlive())
         return;
 
-    double now = clock() / CLOCKS_PER_SEC;
+    double now = SimClock::Now();
+    // Reports make the commander replan, which may replace this state or
+    // re-enter GoToCombat through the same pooled object, so compare epochs
+    const unsigned stateEpoch = pn->GetStateEpoch();
 
     //  1) Look for enemies and decide primary/secondary targets ===
-    std::vector<NPC*>& enemies =
-        (pn->getTeam() == TeamId::Orange) ? teamBlue : teamOrange;
-    const std::vector<NPC*>& allies =
-        (pn->getTeam() == TeamId::Orange) ? teamOrange : teamBlue;
+    World& world = World::Current();
+    const TeamId enemyTeam = EnemyOf(pn->getTeam());
 
     const double closeRange2 = 100.0;   // radius 10 cells
     const double dangerRange2 = 36.0;   // radius 6 cells
+
+    // Only enemies this close can be shot, grenaded or counted as close
+    const double scanRange = std::max({ world.params.fireRange, GRENADE_RANGE, std::sqrt(closeRange2) });
+    std::vector<NPC*> enemies;
+    world.npcGrid.QueryRadius(enemyTeam, pn->getX(), pn->getY(), scanRange, enemies);
+
     int enemiesClose = 0;
     int enemiesPressing = 0;
     double closestEnemyDist2 = 1e9;
@@ -228,7 +232,7 @@ void GoToCombat::Transition(NPC* pn)
         bool enemyIsCommander = (enemy->getRole() == Role::Commander);
         double dist2 = (enemy->getX() - pn->getX()) * (enemy->getX() - pn->getX()) +
             (enemy->getY() - pn->getY()) * (enemy->getY() - pn->getY());
-        bool inFireRange = pn->InRange(enemy, FIRE_RANGE);
+        bool inFireRange = pn->InRange(enemy, world.params.fireRange);
         bool visible = pn->CanSee(enemy);
 
         if (dist2 < closestEnemyDist2) {
@@ -242,6 +246,7 @@ void GoToCombat::Transition(NPC* pn)
             if (visible && inFireRange) {
                 primaryTarget = enemy;
                 pn->ReportEnemySpotted((int)enemy->getX(), (int)enemy->getY());
+                if (pn->GetStateEpoch() != stateEpoch) return;
                 break; // focus on the first warrior we can shoot
             }
             if (pn->getRole() == Role::Warrior && !grenadeTarget && dist2 <= GRENADE_RANGE * GRENADE_RANGE) {
@@ -258,11 +263,17 @@ void GoToCombat::Transition(NPC* pn)
         }
     }
 
+    if (!nearestEnemy) {
+        nearestEnemy = world.npcGrid.FindNearest(enemyTeam, pn->getX(), pn->getY());  // nothing in scan range
+    }
+
     if (!primaryTarget && fallbackTarget) {
         primaryTarget = fallbackTarget;  // no warrior/commander visible, shoot what we can
     }
 
     int alliesClose = 0;
+    std::vector<NPC*> allies;
+    world.npcGrid.QueryRadius(pn->getTeam(), pn->getX(), pn->getY(), std::sqrt(closeRange2), allies);
     for (NPC* ally : allies) {
         if (!ally || ally == pn || !ally->IsAlive()) continue;
         double dx = ally->getX() - pn->getX();
@@ -278,7 +289,7 @@ void GoToCombat::Transition(NPC* pn)
     bool recentlyRetreated = (now - pn->GetLastRetreatTime()) < 2.0;
     double currentRisk = Map::GetSecurityValue((int)pn->getY(), (int)pn->getX(), pn->getTeam());
     bool enemyWarriorsAlive = false;
-    for (NPC* enemy : enemies) {
+    for (NPC* enemy : world.Team(enemyTeam)) {
         if (enemy && enemy->IsAlive() && enemy->getRole() == Role::Warrior) {
             enemyWarriorsAlive = true;
             break;
@@ -287,12 +298,13 @@ void GoToCombat::Transition(NPC* pn)
 
     if (pn->getHP() <= CRITICAL_HP_THRESHOLD) {
         pn->ReportInjury();
+        if (pn->GetStateEpoch() != stateEpoch) return;
         pn->setIsMoving(false);
         if (!recentlyRetreated) {
-            printf("[COMBAT] [%c] critically injured (HP=%d). Ceasing fire and retreating for medic support.\n",
+            LOG_INFO(Combat, "[%c] critically injured (HP=%d). Ceasing fire and retreating for medic support.",
                 pn->getSymbol(), pn->getHP());
             ExitCombatState(pn);
-            pn->setCurrentState(new GoToCover());
+            pn->setCurrentState(pn->getStatePool().Acquire<GoToCover>());
             pn->MarkRetreat();
             pn->getCurrentState()->OnEnter(pn);
         }
@@ -301,13 +313,14 @@ void GoToCombat::Transition(NPC* pn)
 
     if (!recentlyRetreated && (lowHealth || overwhelmed)) {
         pn->ReportInjury();
-        printf("[COMBAT] [%c] retreating (HP=%d closeEnemies=%d allies=%d).\n",
+        if (pn->GetStateEpoch() != stateEpoch) return;
+        LOG_INFO(Combat, "[%c] retreating (HP=%d closeEnemies=%d allies=%d).",
             pn->getSymbol(), pn->getHP(), enemiesClose, alliesClose);
         State* current = pn->getCurrentState();
         bool alreadyCover = current && typeid(*current) == typeid(GoToCover);
         if (!alreadyCover) {
             ExitCombatState(pn);
-            pn->setCurrentState(new GoToCover());
+            pn->setCurrentState(pn->getStatePool().Acquire<GoToCover>());
             pn->MarkRetreat();
             pn->getCurrentState()->OnEnter(pn);
         }
@@ -315,10 +328,10 @@ void GoToCombat::Transition(NPC* pn)
     }
 
     if (!pn->getIsMoving() && !primaryTarget && currentRisk > 0.55 && enemyWarriorsAlive) {
-        printf("[COMBAT] [%c] area too dangerous (risk=%.2f). Seeking cover.\n",
+        LOG_INFO(Combat, "[%c] area too dangerous (risk=%.2f). Seeking cover.",
             pn->getSymbol(), currentRisk);
         OnExit(pn);
-        pn->setCurrentState(new GoToCover());
+        pn->setCurrentState(pn->getStatePool().Acquire<GoToCover>());
         pn->MarkRetreat();
         pn->getCurrentState()->OnEnter(pn);
         return;
@@ -331,47 +344,50 @@ void GoToCombat::Transition(NPC* pn)
             pn->setIsMoving(false);
         }
         // Fire every 0.7 seconds
-        if (now - lastShotTime > 0.45)
+        if (now - Combat().lastShotTime > 0.45)
         {
             if (pn->CanShoot())
             {
-                if (ClearAllyLineOfFire(pn, primaryTarget, allies)) {
+                if (ClearAllyLineOfFire(pn, primaryTarget)) {
                     pn->Shoot(primaryTarget);
-                    lastShotTime = now;
+                    // Shoot may report low ammo
+                    if (pn->GetStateEpoch() != stateEpoch) return;
+                    Combat().lastShotTime = now;
 
                     if (!primaryTarget->IsAlive())
                     {
-                        printf("[COMBAT] [%c] eliminated %c\n",
+                        LOG_INFO(Combat, "[%c] eliminated %c",
                             pn->getSymbol(), primaryTarget->getSymbol());
                     }
                 } else {
-                    printf("[COMBAT] [%c] holding fire to avoid friendly line-of-fire.\n", pn->getSymbol());
+                    LOG_INFO(Combat, "[%c] holding fire to avoid friendly line-of-fire.", pn->getSymbol());
                 }
             }
             else if (pn->getRole() == Role::Warrior)
             {
                 pn->setLowAmmo(true);
                 pn->ReportLowAmmo();
-                printf("[COMBAT] [%c] out of ammo, requesting supply.\n", pn->getSymbol());
+                if (pn->GetStateEpoch() != stateEpoch) return;
+                LOG_INFO(Combat, "[%c] out of ammo, requesting supply.", pn->getSymbol());
                 OnExit(pn);
-                pn->setCurrentState(new GoToSupply());
+                pn->setCurrentState(pn->getStatePool().Acquire<GoToSupply>());
                 pn->getCurrentState()->OnEnter(pn);
                 return;
             }
         }
     }
     // If no visible enemy but we have grenade target (behind cover), throw grenade
-    else if (grenadeTarget && pn->getRole() == Role::Warrior && pn->CanThrowGrenade() && now - lastShotTime > 1.5)
+    else if (grenadeTarget && pn->getRole() == Role::Warrior && pn->CanThrowGrenade() && now - Combat().lastShotTime > 1.5)
     {
         double gx = grenadeTarget->getX();
         double gy = grenadeTarget->getY();
-        const double allySafetyRadiusSq = 64.0; // radius 8 cells
+        const double allySafetyRadius = 8.0;
 
-        if (!AlliesWithinRadius(allies, pn, gx, gy, allySafetyRadiusSq)) {
-            lastThrowerRole = pn->getRole();
+        if (!AlliesWithinRadius(pn, gx, gy, allySafetyRadius)) {
+            Combat().lastThrowerRole = pn->getRole();
             pn->ThrowGrenade(gx, gy);
-            lastShotTime = now;
-            printf("[COMBAT] [%c] launched grenade at hidden enemy.\n", pn->getSymbol());
+            Combat().lastShotTime = now;
+            LOG_INFO(Combat, "[%c] launched grenade at hidden enemy.", pn->getSymbol());
         }
     }
     else
@@ -400,7 +416,8 @@ void GoToCombat::Transition(NPC* pn)
         else {
             // close but obstructed? try to reposition
             NPC* obstructed = nullptr;
-            double bestDist2 = FIRE_RANGE * FIRE_RANGE;
+            double bestDist2 = world.params.fireRange * world.params.fireRange;
+            world.npcGrid.QueryRadius(enemyTeam, pn->getX(), pn->getY(), world.params.fireRange, enemies);
             for (NPC* enemy : enemies) {
                 if (!enemy || !enemy->IsAlive()) continue;
                 double dx = enemy->getX() - pn->getX();
@@ -431,10 +448,11 @@ void GoToCombat::Transition(NPC* pn)
     if (!recentlyRetreated && pn->getHP() < INJURY_THRESHOLD)
     {
         pn->ReportInjury();
-        printf("[COMBAT] [%c] HP=%d, falling back to cover.\n",
+        if (pn->GetStateEpoch() != stateEpoch) return;
+        LOG_INFO(Combat, "[%c] HP=%d, falling back to cover.",
             pn->getSymbol(), pn->getHP());
         ExitCombatState(pn);
-        pn->setCurrentState(new GoToCover());
+        pn->setCurrentState(pn->getStatePool().Acquire<GoToCover>());
         pn->MarkRetreat();
         pn->getCurrentState()->OnEnter(pn);
         return;
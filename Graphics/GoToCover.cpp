@@ -1,15 +1,14 @@
 #include "GoToCover.h"
 #include "Map.h"
 #include "Pathfinding.h"
-#include <stdio.h>
+#include "PathService.h"
+#include "Log.h"
 #include <math.h>
 #include <algorithm> // for std::min
-#include <time.h>
+#include "SimClock.h"
 #include <vector>
 #include <cstdlib>
-
-extern std::vector<NPC*> teamOrange;
-extern std::vector<NPC*> teamBlue;
+#include "World.h"
 
 namespace {
     std::pair<int, int> GetDefensiveBandAnchor(TeamId team)
@@ -39,7 +38,7 @@ namespace {
         }
 
         for (size_t i = 0; i < candidates.size(); ++i) {
-            size_t j = i + (rand() % (candidates.size() - i));
+            size_t j = i + (World::Current().Random() % (candidates.size() - i));
             std::swap(candidates[i], candidates[j]);
         }
 
@@ -62,18 +61,18 @@ namespace {
 void GoToCover::OnEnter(NPC* pn) {
     if (pn->getIsMoving()) return;
 
-    printf("[STATE] %c searching for safe cover using BFS.\n", pn->getSymbol());
+    LOG_INFO(State, "%c searching for safe cover using BFS.", pn->getSymbol());
 
     int sx = (int)pn->getX();
     int sy = (int)pn->getY();
 
    
     int searchRadius = 30;
-    double now = clock() / (double)CLOCKS_PER_SEC;
+    double now = SimClock::Now();
 
     if ((now - pn->GetLastRetreatTime()) < 3.0) {
         searchRadius = 60; 
-        printf("[INFO] %c Forcing wider search radius (%d) due to recent thrashing/retreat.\n", pn->getSymbol(), searchRadius);
+        LOG_INFO(State, "%c Forcing wider search radius (%d) due to recent thrashing/retreat.", pn->getSymbol(), searchRadius);
     }
 
     if (pn->getHasOrderTarget()) {
@@ -84,12 +83,12 @@ void GoToCover::OnEnter(NPC* pn) {
             int adjustedX = targetX;
             int adjustedY = targetY;
             if (!FindUnoccupiedSpotNear(targetX, targetY, pn, adjustedX, adjustedY)) {
-                printf("[WARN] %c ordered anchor (%d,%d) occupied. Aborting cover move.\n",
+                LOG_WARN(State, "%c ordered anchor (%d,%d) occupied. Aborting cover move.",
                     pn->getSymbol(), targetX, targetY);
                 return;
             }
             if (adjustedX != targetX || adjustedY != targetY) {
-                printf("[INFO] %c adjusting ordered anchor to (%d,%d)\n",
+                LOG_INFO(State, "%c adjusting ordered anchor to (%d,%d)",
                     pn->getSymbol(), adjustedX, adjustedY);
                 targetX = adjustedX;
                 targetY = adjustedY;
@@ -107,51 +106,78 @@ void GoToCover::OnEnter(NPC* pn) {
                     }
                 }
             }
-            std::vector<std::pair<int, int>> path;
-            if (Path::FindSafePath(sx, sy, targetX, targetY, pn->getTeam(), path, 0.8, pn->GetId())) {
-                pn->SetPath(path);
-                printf("[INFO] %c moving to ordered cover (%d,%d)\n",
-                    pn->getSymbol(), targetX, targetY);
-                return;
-            }
+            Path::Request request;
+            request.sx = sx;
+            request.sy = sy;
+            request.gx = targetX;
+            request.gy = targetY;
+            request.team = pn->getTeam();
+            request.ignoreNpcId = pn->GetId();
+            request.safeWeights = { 0.8 };
+            request.plainFallback = false;
+
+            Path::RequestPath(pn, request, [this, sx, sy, searchRadius, targetX, targetY](NPC* npc, Path::Result& result) {
+                if (!result.Found()) {
+                    MoveToNearestCover(npc, sx, sy, searchRadius);
+                    return;
+                }
+                npc->SetPath(result.path);
+                LOG_INFO(State, "%c moving to ordered cover (%d,%d)",
+                    npc->getSymbol(), targetX, targetY);
+            });
+            return;
         }
     }
 
+    MoveToNearestCover(pn, sx, sy, searchRadius);
+}
+
+void GoToCover::MoveToNearestCover(NPC* pn, int sx, int sy, int searchRadius)
+{
     // BFS 
     std::pair<int, int> coverPoint;
 
     if (Path::FindNearestCover(sx, sy, searchRadius, pn->getTeam(), coverPoint)) 
     {
-        printf("[INFO] %c found safe cover at (%d,%d)\n",
+        LOG_INFO(State, "%c found safe cover at (%d,%d)",
             pn->getSymbol(), coverPoint.first, coverPoint.second);
 
         int adjustedX = coverPoint.first;
         int adjustedY = coverPoint.second;
         if (!FindUnoccupiedSpotNear(coverPoint.first, coverPoint.second, pn, adjustedX, adjustedY)) {
-            printf("[WARN] %c cover at (%d,%d) fully occupied. Staying put momentarily.\n",
+            LOG_WARN(State, "%c cover at (%d,%d) fully occupied. Staying put momentarily.",
                 pn->getSymbol(), coverPoint.first, coverPoint.second);
             return;
         }
         if (adjustedX != coverPoint.first || adjustedY != coverPoint.second) {
-            printf("[INFO] %c nudging cover target to free spot at (%d,%d)\n",
+            LOG_INFO(State, "%c nudging cover target to free spot at (%d,%d)",
                 pn->getSymbol(), adjustedX, adjustedY);
         }
 
 		// A* to cover point
-        std::vector<std::pair<int, int>> path;
-        if (Path::FindSafePath(sx, sy, adjustedX, adjustedY, pn->getTeam(), path, 0.7, pn->GetId()))
-        {
-            pn->SetPath(path);
-            printf("[PATH] %c safe path to cover length=%zu\n", pn->getSymbol(), path.size());
-        }
-        else
-        {
-            printf("[WARN] %c could not find safe path to cover. Remaining in place.\n", pn->getSymbol());
-        }
+        Path::Request request;
+        request.sx = sx;
+        request.sy = sy;
+        request.gx = adjustedX;
+        request.gy = adjustedY;
+        request.team = pn->getTeam();
+        request.ignoreNpcId = pn->GetId();
+        request.safeWeights = { 0.7 };
+        request.plainFallback = false;
+
+        Path::RequestPath(pn, request, [](NPC* npc, Path::Result& result) {
+            if (result.Found()) {
+                npc->SetPath(result.path);
+                LOG_DEBUG(Path, "%c safe path to cover length=%zu", npc->getSymbol(), result.path.size());
+            }
+            else {
+                LOG_WARN(State, "%c could not find safe path to cover. Remaining in place.", npc->getSymbol());
+            }
+        });
     }
     else
     {
-        printf("[WARN] %c found no safe cover within radius %d. Trying fallback.\n",
+        LOG_WARN(State, "%c found no safe cover within radius %d. Trying fallback.",
             pn->getSymbol(), searchRadius);
 
         std::vector<std::pair<int, int>> potentialCover = {
@@ -202,18 +228,18 @@ void GoToCover::OnEnter(NPC* pn) {
 
         if (bestX != -1)
         {
-            printf("[INFO] %c using fallback cover at (%d,%d)\n",
+            LOG_INFO(State, "%c using fallback cover at (%d,%d)",
                 pn->getSymbol(), bestX, bestY);
             int adjustedX = bestX;
             int adjustedY = bestY;
             if (!FindUnoccupiedSpotNear(bestX, bestY, pn, adjustedX, adjustedY)) {
-                printf("[ERROR] %c failed to find free spot near fallback cover. Remaining stationary.\n", pn->getSymbol());
+                LOG_ERROR(State, "%c failed to find free spot near fallback cover. Remaining stationary.", pn->getSymbol());
                 return;
             }
             pn->GoToGrid(adjustedX, adjustedY);
         }
         else {
-            printf("[ERROR] %c failed to find cover. Remaining stationary.\n", pn->getSymbol());
+            LOG_ERROR(State, "%c failed to find cover. Remaining stationary.", pn->getSymbol());
         }
     }
 }
@@ -233,13 +259,13 @@ void GoToCover::Transition(NPC* pn) {
 
     if (security > 0.6) {
   
-        printf("[WARN] %c cover position unsafe (security=%.2f). Seeking new cover.\n",
+        LOG_WARN(State, "%c cover position unsafe (security=%.2f). Seeking new cover.",
             pn->getSymbol(), security);
         pn->setIsResting(false);
         OnEnter(pn);  
     }
     else {
-        double now = clock() / (double)CLOCKS_PER_SEC;
+        double now = SimClock::Now();
         if (pn->getRole() == Role::Warrior &&
             pn->getPathSize() == 0 &&
             (now - pn->GetLastRetreatTime()) > 2.5 &&
@@ -267,5 +293,5 @@ void GoToCover::Transition(NPC* pn) {
 void GoToCover::OnExit(NPC* pn) {
     pn->setIsMoving(false);
     pn->setIsResting(false);
-    printf("[STATE] %c exited GoToCover state.\n", pn->getSymbol());
+    LOG_INFO(State, "%c exited GoToCover state.", pn->getSymbol());
 }
\ No newline at end of file
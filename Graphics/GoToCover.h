@@ -10,4 +10,8 @@ public:
     void OnEnter(NPC* pn);
     void Transition(NPC* pn);
     void OnExit(NPC* pn);
+
+private:
+    // Path to the closest safe cover within searchRadius of (sx,sy), or a fixed fallback spot
+    void MoveToNearestCover(NPC* pn, int sx, int sy, int searchRadius);
 };
@@ -1,26 +1,24 @@
 #include <limits>
 #include "GoToHeal.h"
+#include "StatePool.h"
 #include "NPC.h"
 #include "GoToCover.h"
 #include "GoToCombat.h"
 #include "GoToMedSupply.h"
 #include "Map.h"
-#include <stdio.h>
-#include <ctime>
+#include "Log.h"
+#include "SimClock.h"
 #include <cmath>
 #include "Pathfinding.h"
 #include "Definitions.h"
+#include "World.h"
 #include "ReturnToWarehouse.h"
 
-extern std::vector<NPC*> teamOrange;
-extern std::vector<NPC*> teamBlue;
-
 namespace {
 
 NPC* FindInjuredAlly(NPC* medic)
 {
-    const std::vector<NPC*>& myTeam =
-        (medic->getTeam() == TeamId::Orange) ? teamOrange : teamBlue;
+    const std::vector<NPC*>& myTeam = World::Current().Team(medic->getTeam());
 
     NPC* best = nullptr;
     int lowestHP = std::numeric_limits<int>::max();
@@ -70,7 +68,7 @@ bool BuildPathToTarget(NPC* medic, NPC* wounded)
     if (!success) return false;
 
     medic->SetPath(path);
-    printf("[PATH] Medic %c path to wounded length=%zu\n", medic->getSymbol(), path.size());
+    LOG_DEBUG(Path, "Medic %c path to wounded length=%zu", medic->getSymbol(), path.size());
     return true;
 }
 
@@ -85,16 +83,16 @@ double Distance(double ax, double ay, double bx, double by)
 
 void GoToHeal::OnEnter(NPC* pn)
 {
-    printf("[STATE] Medic %c entering GoToHeal.\n", pn->getSymbol());
+    LOG_INFO(State, "Medic %c entering GoToHeal.", pn->getSymbol());
     pn->setIsResting(false);
     healing = false;
     healStart = 0.0;
-    lastDistanceCheckTime = clock() / (double)CLOCKS_PER_SEC;
+    lastDistanceCheckTime = SimClock::Now();
     lastDistanceToTarget = std::numeric_limits<double>::max();
 
     if (pn->getSupply() == 0) {
-        printf("[WARN] Medic %c out of medkits, heading to medical supply.\n", pn->getSymbol());
-        pn->setCurrentState(new GoToMedSupply());
+        LOG_WARN(State, "Medic %c out of medkits, heading to medical supply.", pn->getSymbol());
+        pn->setCurrentState(pn->getStatePool().Acquire<GoToMedSupply>());
         pn->getCurrentState()->OnEnter(pn);
         return;
     }
@@ -109,8 +107,8 @@ void GoToHeal::OnEnter(NPC* pn)
     }
 
     if (!targetInjured) {
-        printf("[INFO] Medic %c: no injured allies.\n", pn->getSymbol());
-        pn->setCurrentState(new GoToMedSupply());
+        LOG_INFO(State, "Medic %c: no injured allies.", pn->getSymbol());
+        pn->setCurrentState(pn->getStatePool().Acquire<GoToMedSupply>());
         pn->getCurrentState()->OnEnter(pn);
         return;
     }
@@ -118,8 +116,8 @@ void GoToHeal::OnEnter(NPC* pn)
     pn->setTargetNPC(targetInjured);
 
     if (!BuildPathToTarget(pn, targetInjured)) {
-        printf("[WARN] Medic %c cannot reach wounded ally, moving to cover.\n", pn->getSymbol());
-        pn->setCurrentState(new GoToCover());
+        LOG_WARN(State, "Medic %c cannot reach wounded ally, moving to cover.", pn->getSymbol());
+        pn->setCurrentState(pn->getStatePool().Acquire<GoToCover>());
         pn->getCurrentState()->OnEnter(pn);
         return;
     }
@@ -130,12 +128,12 @@ void GoToHeal::Transition(NPC* pn)
     if (!pn) return;
 
     if (!targetInjured || !targetInjured->IsAlive()) {
-        printf("[WARN] Medic %c: target lost.\n", pn->getSymbol());
+        LOG_WARN(State, "Medic %c: target lost.", pn->getSymbol());
         targetInjured = FindInjuredAlly(pn);
         if (targetInjured && BuildPathToTarget(pn, targetInjured)) {
             pn->setTargetNPC(targetInjured);
         } else {
-            pn->setCurrentState(new GoToMedSupply());
+            pn->setCurrentState(pn->getStatePool().Acquire<GoToMedSupply>());
             pn->getCurrentState()->OnEnter(pn);
         }
         return;
@@ -146,14 +144,14 @@ void GoToHeal::Transition(NPC* pn)
     const double REPLAN_INTERVAL = 0.5;
 
     if (distance > HEAL_RADIUS) {
-        double now = clock() / (double)CLOCKS_PER_SEC;
+        double now = SimClock::Now();
         if (pn->getIsMoving()) {
             if ((now - lastDistanceCheckTime) > REPLAN_INTERVAL) {
                 if (distance >= lastDistanceToTarget - 0.2) {
-                    printf("[WARN] Medic %c progress stalled at distance %.2f. Replanning path to wounded.\n",
+                    LOG_WARN(State, "Medic %c progress stalled at distance %.2f. Replanning path to wounded.",
                         pn->getSymbol(), distance);
                     if (!BuildPathToTarget(pn, targetInjured)) {
-                        pn->setCurrentState(new GoToCover());
+                        pn->setCurrentState(pn->getStatePool().Acquire<GoToCover>());
                         pn->getCurrentState()->OnEnter(pn);
                         return;
                     }
@@ -164,7 +162,7 @@ void GoToHeal::Transition(NPC* pn)
         }
         else {
             if (!BuildPathToTarget(pn, targetInjured)) {
-                pn->setCurrentState(new GoToCover());
+                pn->setCurrentState(pn->getStatePool().Acquire<GoToCover>());
                 pn->getCurrentState()->OnEnter(pn);
             }
         }
@@ -178,13 +176,13 @@ void GoToHeal::Transition(NPC* pn)
     }
 
     if (targetInjured->getHP() >= 100) {
-        printf("[INFO] Medic %c: ally already at full health.\n", pn->getSymbol());
+        LOG_INFO(State, "Medic %c: ally already at full health.", pn->getSymbol());
         targetInjured = FindInjuredAlly(pn);
         if (targetInjured && BuildPathToTarget(pn, targetInjured)) {
             pn->setTargetNPC(targetInjured);
         } else {
             OnExit(pn);
-            pn->setCurrentState(new GoToMedSupply());
+            pn->setCurrentState(pn->getStatePool().Acquire<GoToMedSupply>());
             pn->getCurrentState()->OnEnter(pn);
         }
         return;
@@ -192,34 +190,34 @@ void GoToHeal::Transition(NPC* pn)
 
     if (!healing) {
         healing = true;
-        healStart = static_cast<double>(std::clock());
-        printf("[STATE] Medic %c treating ally %c.\n",
+        healStart = SimClock::Now();
+        LOG_INFO(State, "Medic %c treating ally %c.",
             pn->getSymbol(), targetInjured->getSymbol());
         return;
     }
 
-    double elapsed = (static_cast<double>(std::clock()) - healStart) / static_cast<double>(CLOCKS_PER_SEC);
+    double elapsed = SimClock::Now() - healStart;
     if (elapsed < 0.6) return;
 
     int newHP = std::min(100, targetInjured->getHP() + MEDIC_HEAL_AMOUNT);
     targetInjured->setHP(newHP);
-    printf("[HEAL] Medic %c healed ally %c to %d HP.\n",
+    LOG_INFO(State, "Medic %c healed ally %c to %d HP.",
         pn->getSymbol(), targetInjured->getSymbol(), targetInjured->getHP());
 
     pn->consumeSupply(1);
     pn->RegisterAssistCompletion();
     if (!pn->CanTakeAssist()) {
-        printf("[INFO] Medic %c reached assist limit (%d/%d).\n",
+        LOG_INFO(State, "Medic %c reached assist limit (%d/%d).",
             pn->getSymbol(), pn->GetAssistsDone(), NPC::ASSIST_LIMIT);
     }
-    targetInjured->setCurrentState(new GoToCombat());
+    targetInjured->setCurrentState(targetInjured->getStatePool().Acquire<GoToCombat>());
     targetInjured->getCurrentState()->OnEnter(targetInjured);
 
     double patientX = targetInjured->getX();
     double patientY = targetInjured->getY();
     OnExit(pn);
     Map::WarehouseInfo wh = Map::GetWarehouseForTeam(pn->getTeam());
-    pn->setCurrentState(new ReturnToWarehouse(wh.medX, wh.medY, 4.0, patientX, patientY));
+    pn->setCurrentState(pn->getStatePool().Acquire<ReturnToWarehouse>(wh.medX, wh.medY, 4.0, patientX, patientY));
     pn->getCurrentState()->OnEnter(pn);
 }
 
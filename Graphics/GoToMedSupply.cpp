@@ -1,21 +1,61 @@
 ﻿#include "GoToMedSupply.h"
+#include "StatePool.h"
 #include "NPC.h"
 #include "Map.h"
 #include "GoToCover.h"
-#include <stdio.h>
-#include <time.h>
+#include "Log.h"
+#include "SimClock.h"
 #include "Pathfinding.h"
+#include "FlowField.h"
+#include "PathService.h"
 #include "Definitions.h"
+#include "World.h"
 
-static double arrivalTime = 0;
-static bool waitingAtMed = false;
+// Resupply wait timer lives in the current world
+static World::WaitState& MedSupplyWait() { return World::Current().medSupplyWait; }
+
+static void GiveUpMedSupplyRun(NPC* pn)
+{
+    LOG_ERROR(State, "[%c] no path to medical warehouse. Staying put.", pn->getSymbol());
+    pn->setCurrentState(pn->getStatePool().Acquire<GoToCover>());
+    pn->getCurrentState()->OnEnter(pn);
+}
+
+// No route to the depot: head for safe cover next to it, or give up on the run
+static void RouteToCoverNearMedDepot(NPC* pn, int sx, int sy, int targetX, int targetY)
+{
+    std::pair<int, int> fallbackCover;
+    if (!Path::FindNearestCover(targetX, targetY, 14, pn->getTeam(), fallbackCover)) {
+        GiveUpMedSupplyRun(pn);
+        return;
+    }
+
+    Path::Request request;
+    request.sx = sx;
+    request.sy = sy;
+    request.gx = fallbackCover.first;
+    request.gy = fallbackCover.second;
+    request.team = pn->getTeam();
+    request.ignoreNpcId = pn->GetId();
+    request.safeWeights = { 0.4 };
+
+    Path::RequestPath(pn, request, [fallbackCover](NPC* npc, Path::Result& result) {
+        if (!result.Found()) {
+            GiveUpMedSupplyRun(npc);
+            return;
+        }
+        npc->SetPath(result.path);
+        LOG_DEBUG(Path, "[%c] rerouted to safe cover near med depot (%d,%d).",
+            npc->getSymbol(), fallbackCover.first, fallbackCover.second);
+    });
+}
 
 // When Medic gets the order to go to *lower* medical warehouse
 void GoToMedSupply::OnEnter(NPC* pn)
 {
-    printf("[STATE] [%c] heading to medical warehouse (bottom side).\n", pn->getSymbol());
-    waitingAtMed = false;
-    arrivalTime = 0;
+    LOG_INFO(State, "[%c] heading to medical warehouse (bottom side).", pn->getSymbol());
+    MedSupplyWait().waiting = false;
+    MedSupplyWait().arrivalTime = 0;
     pn->setIsResting(false);
 
     //  get team-specific warehouse info 
@@ -34,7 +74,7 @@ void GoToMedSupply::OnEnter(NPC* pn)
         targetY = 15;   // bottom-right
     }
 
-    printf("[PATH] [%c] target medical warehouse (%d,%d)\n", pn->getSymbol(), targetX, targetY);
+    LOG_DEBUG(Path, "[%c] target medical warehouse (%d,%d)", pn->getSymbol(), targetX, targetY);
 
     //  if tile not walkable, find nearby free tile 
     if (!Map::IsWalkable(targetX, targetY)) {
@@ -53,8 +93,8 @@ void GoToMedSupply::OnEnter(NPC* pn)
         }
 
         if (!found) {
-            printf("[WARN] [%c] no walkable tile near medical warehouse.\n", pn->getSymbol());
-            pn->setCurrentState(new GoToCover());
+            LOG_WARN(State, "[%c] no walkable tile near medical warehouse.", pn->getSymbol());
+            pn->setCurrentState(pn->getStatePool().Acquire<GoToCover>());
             pn->getCurrentState()->OnEnter(pn);
             return;
         }
@@ -65,37 +105,34 @@ void GoToMedSupply::OnEnter(NPC* pn)
     int sx = (int)pn->getX();
     int sy = (int)pn->getY();
 
-    if (Path::FindSafePath(sx, sy, targetX, targetY, pn->getTeam(), path, 0.6, pn->GetId())) {
-        printf("[PATH] [%c] safe path to medical warehouse length=%zu\n", pn->getSymbol(), path.size());
+    // The medical depot is shared by the whole team: read the route from its flow field
+    if (Path::FindFlowPath(sx, sy, targetX, targetY, pn->getTeam(), path, 0.6)) {
+        LOG_DEBUG(Path, "[%c] safe path to medical warehouse length=%zu", pn->getSymbol(), path.size());
         pn->SetPath(path);
     }
     else {
-        printf("[WARN] [%c] strict safe path failed, relaxing weight.\n", pn->getSymbol());
-        if (Path::FindSafePath(sx, sy, targetX, targetY, pn->getTeam(), path, 0.3, pn->GetId())) {
-            pn->SetPath(path);
-            printf("[PATH] [%c] relaxed safe path length=%zu\n", pn->getSymbol(), path.size());
-        }
-        else if (Path::FindPath(sx, sy, targetX, targetY, path, pn->GetId())) {
-            pn->SetPath(path);
-            printf("[PATH] [%c] fallback path length=%zu\n", pn->getSymbol(), path.size());
-        }
-        else {
-            std::pair<int, int> fallbackCover;
-            if (Path::FindNearestCover(targetX, targetY, 14, pn->getTeam(), fallbackCover) &&
-                (Path::FindSafePath(sx, sy, fallbackCover.first, fallbackCover.second, pn->getTeam(), path, 0.4, pn->GetId()) ||
-                    Path::FindPath(sx, sy, fallbackCover.first, fallbackCover.second, path, pn->GetId())))
-            {
-                pn->SetPath(path);
-                printf("[PATH] [%c] rerouted to safe cover near med depot (%d,%d).\n",
-                    pn->getSymbol(), fallbackCover.first, fallbackCover.second);
-            }
-            else {
-                printf("[ERROR] [%c] no path to medical warehouse. Staying put.\n", pn->getSymbol());
-                pn->setCurrentState(new GoToCover());
-                pn->getCurrentState()->OnEnter(pn);
+        LOG_WARN(State, "[%c] strict safe path failed, relaxing weight.", pn->getSymbol());
+
+        Path::Request request;
+        request.sx = sx;
+        request.sy = sy;
+        request.gx = targetX;
+        request.gy = targetY;
+        request.team = pn->getTeam();
+        request.ignoreNpcId = pn->GetId();
+        request.safeWeights = { 0.3 };
+
+        Path::RequestPath(pn, request, [sx, sy, targetX, targetY](NPC* npc, Path::Result& result) {
+            if (result.Found()) {
+                npc->SetPath(result.path);
+                if (result.attempt == 0)
+                    LOG_DEBUG(Path, "[%c] relaxed safe path length=%zu", npc->getSymbol(), result.path.size());
+                else
+                    LOG_DEBUG(Path, "[%c] fallback path length=%zu", npc->getSymbol(), result.path.size());
                 return;
             }
-        }
+            RouteToCoverNearMedDepot(npc, sx, sy, targetX, targetY);
+        });
     }
 }
 
@@ -113,15 +150,15 @@ void GoToMedSupply::Transition(NPC* pn) {
     if (dist2 > 4.0) return; // not close enough yet
 
     //  start waiting once arrived 
-    if (!waitingAtMed) {
-        waitingAtMed = true;
-        arrivalTime = clock();
-        printf("[STATE] [%c] waiting at medical warehouse.\n", pn->getSymbol());
+    if (!MedSupplyWait().waiting) {
+        MedSupplyWait().waiting = true;
+        MedSupplyWait().arrivalTime = SimClock::Now();
+        LOG_INFO(State, "[%c] waiting at medical warehouse.", pn->getSymbol());
         return;
     }
 
     //  simulate waiting for resupply (~2s) 
-    double elapsed = (clock() - arrivalTime) / CLOCKS_PER_SEC;
+    double elapsed = SimClock::Now() - MedSupplyWait().arrivalTime;
     if (elapsed < 2.0) return;
 
     //  finished collecting supplies 
@@ -129,7 +166,7 @@ void GoToMedSupply::Transition(NPC* pn) {
     pn->ResetAssistCounter();
     pn->setIsMoving(false);
     pn->setIsResting(true);
-    printf("[STATE] [%c] stocked medical supplies and is holding position.\n", pn->getSymbol());
+    LOG_INFO(State, "[%c] stocked medical supplies and is holding position.", pn->getSymbol());
 }
 
 // Exit from state
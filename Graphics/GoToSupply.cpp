@@ -1,17 +1,18 @@
 ﻿#include "GoToSupply.h"
+#include "StatePool.h"
 #include "NPC.h"
 #include "GoToCover.h"
 #include "Map.h"
 #include "Pathfinding.h"
-#include <stdio.h>
-#include <time.h>
+#include "FlowField.h"
+#include "PathService.h"
+#include "Log.h"
+#include "SimClock.h"
 #include "Definitions.h"
+#include "World.h"
 
-extern std::vector<NPC*> teamOrange;
-extern std::vector<NPC*> teamBlue;
-
-static double arrivalTime = 0;
-static bool waitingAtSupply = false;
+// Refill wait timer lives in the current world
+static World::WaitState& SupplyWait() { return World::Current().supplyWait; }
 
 const std::vector<std::pair<int, int>> ORANGE_EXIT_CORRIDOR = {
     {26, 82}, {28, 80}, {30, 77}, {32, 73}
@@ -112,10 +113,60 @@ static void PrependDepotExit(NPC* pn, std::vector<std::pair<int, int>>& path)
     path.swap(expanded);
 }
 
+static void GiveUpSupplyRun(NPC* pn)
+{
+    LOG_ERROR(State, "[%c] no safe route to supply warehouse. Falling back to cover.", pn->getSymbol());
+    pn->setCurrentState(pn->getStatePool().Acquire<GoToCover>());
+    pn->getCurrentState()->OnEnter(pn);
+}
+
+// No route to the supply node: head for cover next to it, or give up on the run
+static void RouteToCoverNearSupply(NPC* pn, int sx, int sy, int targetX, int targetY)
+{
+    std::pair<int, int> fallbackCover;
+    if (Path::FindNearestCover(targetX, targetY, 12, pn->getTeam(), fallbackCover)) {
+        if (!Map::IsWalkable(fallbackCover.first, fallbackCover.second)) {
+            const int DX[4] = {1,-1,0,0};
+            const int DY[4] = {0,0,1,-1};
+            for (int i = 0; i < 4; ++i) {
+                int nx = fallbackCover.first + DX[i];
+                int ny = fallbackCover.second + DY[i];
+                if (Map::InBounds(nx, ny) && Map::IsWalkable(nx, ny)) {
+                    fallbackCover = { nx, ny };
+                    break;
+                }
+            }
+        }
+
+        Path::Request request;
+        request.sx = sx;
+        request.sy = sy;
+        request.gx = fallbackCover.first;
+        request.gy = fallbackCover.second;
+        request.team = pn->getTeam();
+        request.ignoreNpcId = pn->GetId();
+        request.safeWeights = { 0.4 };
+
+        Path::RequestPath(pn, request, [fallbackCover](NPC* npc, Path::Result& result) {
+            if (!result.Found()) {
+                GiveUpSupplyRun(npc);
+                return;
+            }
+            PrependDepotExit(npc, result.path);
+            LOG_DEBUG(Path, "[%c] rerouted to nearby cover (%d,%d).",
+                npc->getSymbol(), fallbackCover.first, fallbackCover.second);
+            npc->SetPath(result.path);
+        });
+        return;
+    }
+
+    GiveUpSupplyRun(pn);
+}
+
 // When the porter gets an order to resupply
 void GoToSupply::OnEnter(NPC* pn)
 {
-    printf("[STATE] [%c] heading to ammo supply warehouse.\n", pn->getSymbol());
+    LOG_INFO(State, "[%c] heading to ammo supply warehouse.", pn->getSymbol());
 
     //  Get team warehouse location 
     pn->setIsResting(false);
@@ -145,10 +196,10 @@ void GoToSupply::OnEnter(NPC* pn)
         }
 
         if (!found)
-            printf("[WARN] [%c] could not find walkable tile near warehouse.\n", pn->getSymbol());
+            LOG_WARN(State, "[%c] could not find walkable tile near warehouse.", pn->getSymbol());
     }
 
-    printf("[PATH] [%c] target supply node (%d,%d) walkable=%d\n",
+    LOG_DEBUG(Path, "[%c] target supply node (%d,%d) walkable=%d",
         pn->getSymbol(), targetX, targetY, Map::IsWalkable(targetX, targetY));
 
     //  Compute safe A* path (prefer safer routes) 
@@ -170,7 +221,7 @@ void GoToSupply::OnEnter(NPC* pn)
             }
         }
         if (!foundAdjacent) {
-            printf("[ERROR] [%c] start position blocked; searching for nearby cover.\n", pn->getSymbol());
+            LOG_ERROR(State, "[%c] start position blocked; searching for nearby cover.", pn->getSymbol());
             std::pair<int, int> altCover;
             if (Path::FindNearestCover((int)startX, (int)startY, 8, pn->getTeam(), altCover)) {
                 pn->GoToGrid(altCover.first, altCover.second);
@@ -178,68 +229,44 @@ void GoToSupply::OnEnter(NPC* pn)
             else {
                 pn->setIsMoving(false);
             }
-            waitingAtSupply = false;
-            arrivalTime = 0;
+            SupplyWait().waiting = false;
+            SupplyWait().arrivalTime = 0;
             return;
         }
     }
 
-    bool foundPath = false;
+    SupplyWait().waiting = false;
+    SupplyWait().arrivalTime = 0;
 
-    if (Path::FindSafePath(sx, sy, targetX, targetY, pn->getTeam(), path, 0.5, pn->GetId())) {
+    // The supply node is shared by the whole team: read the route from its flow field
+    if (Path::FindFlowPath(sx, sy, targetX, targetY, pn->getTeam(), path, 0.5)) {
         PrependDepotExit(pn, path);
-        foundPath = true;
-        printf("[PATH] [%c] safe path length=%zu\n", pn->getSymbol(), path.size());
-    }
-    else if (Path::FindSafePath(sx, sy, targetX, targetY, pn->getTeam(), path, 0.2, pn->GetId())) {
-        PrependDepotExit(pn, path);
-        foundPath = true;
-        printf("[PATH] [%c] relaxed safe path length=%zu\n", pn->getSymbol(), path.size());
-    }
-    else if (Path::FindPath(sx, sy, targetX, targetY, path, pn->GetId())) {
-        PrependDepotExit(pn, path);
-        foundPath = true;
-        printf("[PATH] [%c] fallback A* path length=%zu\n", pn->getSymbol(), path.size());
-    }
-    else {
-        std::pair<int, int> fallbackCover;
-        if (Path::FindNearestCover(targetX, targetY, 12, pn->getTeam(), fallbackCover)) {
-            if (!Map::IsWalkable(fallbackCover.first, fallbackCover.second)) {
-                const int DX[4] = {1,-1,0,0};
-                const int DY[4] = {0,0,1,-1};
-                for (int i = 0; i < 4; ++i) {
-                    int nx = fallbackCover.first + DX[i];
-                    int ny = fallbackCover.second + DY[i];
-                    if (Map::InBounds(nx, ny) && Map::IsWalkable(nx, ny)) {
-                        fallbackCover = { nx, ny };
-                        break;
-                    }
-                }
-            }
-            if (Path::FindSafePath(sx, sy, fallbackCover.first, fallbackCover.second, pn->getTeam(), path, 0.4, pn->GetId()) ||
-                Path::FindPath(sx, sy, fallbackCover.first, fallbackCover.second, path, pn->GetId())) {
-                PrependDepotExit(pn, path);
-                foundPath = true;
-                printf("[PATH] [%c] rerouted to nearby cover (%d,%d).\n",
-                    pn->getSymbol(), fallbackCover.first, fallbackCover.second);
-            }
-        }
-    }
-
-    if (foundPath) {
+        LOG_DEBUG(Path, "[%c] safe path length=%zu", pn->getSymbol(), path.size());
         pn->SetPath(path);
-    }
-    else {
-        printf("[ERROR] [%c] no safe route to supply warehouse. Falling back to cover.\n", pn->getSymbol());
-        pn->setCurrentState(new GoToCover());
-        pn->getCurrentState()->OnEnter(pn);
-        waitingAtSupply = false;
-        arrivalTime = 0;
         return;
     }
 
-    waitingAtSupply = false;
-    arrivalTime = 0;
+    Path::Request request;
+    request.sx = sx;
+    request.sy = sy;
+    request.gx = targetX;
+    request.gy = targetY;
+    request.team = pn->getTeam();
+    request.ignoreNpcId = pn->GetId();
+    request.safeWeights = { 0.2 };
+
+    Path::RequestPath(pn, request, [sx, sy, targetX, targetY](NPC* npc, Path::Result& result) {
+        if (result.Found()) {
+            PrependDepotExit(npc, result.path);
+            if (result.attempt == 0)
+                LOG_DEBUG(Path, "[%c] relaxed safe path length=%zu", npc->getSymbol(), result.path.size());
+            else
+                LOG_DEBUG(Path, "[%c] fallback A* path length=%zu", npc->getSymbol(), result.path.size());
+            npc->SetPath(result.path);
+            return;
+        }
+        RouteToCoverNearSupply(npc, sx, sy, targetX, targetY);
+    });
 }
 
 // While moving or waiting at supply
@@ -260,15 +287,15 @@ void GoToSupply::Transition(NPC* pn)
 
     if (dist2 > 9.0) return; // not close enough yet (3 cells radius)
 
-    if (!waitingAtSupply) {
-        waitingAtSupply = true;
-        arrivalTime = clock();
-        printf("[STATE] [%c] refilling ammo at warehouse.\n", pn->getSymbol());
+    if (!SupplyWait().waiting) {
+        SupplyWait().waiting = true;
+        SupplyWait().arrivalTime = SimClock::Now();
+        LOG_INFO(State, "[%c] refilling ammo at warehouse.", pn->getSymbol());
         return;
     }
 
     //  Wait ~1 second 
-    double elapsed = (clock() - arrivalTime) / CLOCKS_PER_SEC;
+    double elapsed = SimClock::Now() - SupplyWait().arrivalTime;
     if (elapsed < 1.0) return;
 
     //  Done refilling 
@@ -277,7 +304,7 @@ void GoToSupply::Transition(NPC* pn)
     pn->ResetAssistCounter();
     pn->setIsMoving(false);
     pn->setIsResting(true);
-    printf("[STATE] [%c] refilled supply crates and is standing by.\n", pn->getSymbol());
+    LOG_INFO(State, "[%c] refilled supply crates and is standing by.", pn->getSymbol());
 }
 
 // OnExit
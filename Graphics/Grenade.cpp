@@ -1,7 +1,6 @@
 #include "Grenade.h"
-#include "glut.h"
 #include <math.h>
-#include <time.h>
+#include "SimClock.h"
 #include <algorithm>
 
 Grenade::Grenade(double posX, double posY)
@@ -28,14 +27,6 @@ Grenade::~Grenade()
     }
 }
 
-void Grenade::Show() const
-{
-    int i;
-    for (i = 0; i < NUM_BULLETS; i++)
-        if (bullets[i]->GetIsMoving())
-            bullets[i]->Show();
-}
-
 void Grenade::Explode()
 {
     int i;
@@ -48,7 +39,7 @@ void Grenade::SetIsExploding(bool value)
     isExploding = value;
     int i;
     if (value) {
-        explosionStartTime = clock() / (double)CLOCKS_PER_SEC;
+        explosionStartTime = SimClock::Now();
     }
     for (i = 0; i < NUM_BULLETS; i++)
         bullets[i]->SetIsMoving(value);
@@ -15,7 +15,6 @@ public:
     Grenade(double posX, double posY);
     ~Grenade();
     
-    void Show() const;
     void Explode();
     void SetIsExploding(bool value);
     void CreateSecurityMap();
@@ -24,6 +23,7 @@ public:
     double GetX() const { return x; }
     double GetY() const { return y; }
     double GetExplosionStartTime() const { return explosionStartTime; }
+    const Bullet* GetBullet(int i) const { return bullets[i]; }
 };
 
 
@@ -0,0 +1,166 @@
+#include <cmath>
+#include <limits>
+#include "GunshotTable.h"
+#include "World.h"
+#include "NPC.h"
+#include "Map.h"
+#include "SimClock.h"
+
+namespace
+{
+    const double NO_HIT = std::numeric_limits<double>::infinity();
+
+    // Fraction of the segment (x0,y0)-(x0+dx,y0+dy) at which it first enters
+    // a cell that is off the map or stops bullets; NO_HIT if it never does.
+    // Cell c covers [c - 0.5, c + 0.5), as (int)(v + 0.5) elsewhere. The
+    // start cell counts too (t = 0): a shot spawned inside a rock or tree
+    // next to its shooter stops there.
+    double TerrainHit(double x0, double y0, double dx, double dy)
+    {
+        double ux = x0 + 0.5;
+        double uy = y0 + 0.5;
+        int cx = (int)std::floor(ux);
+        int cy = (int)std::floor(uy);
+        const int endX = (int)std::floor(ux + dx);
+        const int endY = (int)std::floor(uy + dy);
+        if (!Map::InBounds(cx, cy) || Map::BlocksBullets(cx, cy)) return 0.0;
+
+        const int stepX = dx > 0.0 ? 1 : -1;
+        const int stepY = dy > 0.0 ? 1 : -1;
+        const double deltaX = dx != 0.0 ? 1.0 / std::fabs(dx) : NO_HIT;
+        const double deltaY = dy != 0.0 ? 1.0 / std::fabs(dy) : NO_HIT;
+        double nextX = dx != 0.0 ? (dx > 0.0 ? cx + 1 - ux : ux - cx) * deltaX : NO_HIT;
+        double nextY = dy != 0.0 ? (dy > 0.0 ? cy + 1 - uy : uy - cy) * deltaY : NO_HIT;
+
+        int cellsLeft = std::abs(endX - cx) + std::abs(endY - cy);
+        while (cellsLeft-- > 0) {
+            double t;
+            if (nextX < nextY) {
+                cx += stepX;
+                t = nextX;
+                nextX += deltaX;
+            }
+            else {
+                cy += stepY;
+                t = nextY;
+                nextY += deltaY;
+            }
+            if (!Map::InBounds(cx, cy) || Map::BlocksBullets(cx, cy)) return t;
+        }
+        return NO_HIT;
+    }
+
+    // Fraction of the segment at which it first comes within 'radius' of
+    // (ex,ey); NO_HIT if it stays outside
+    double CircleHit(double x0, double y0, double dx, double dy, double ex, double ey, double radius)
+    {
+        double fx = x0 - ex;
+        double fy = y0 - ey;
+        double c = fx * fx + fy * fy - radius * radius;
+        if (c <= 0.0) return 0.0;   // already inside
+
+        double a = dx * dx + dy * dy;
+        if (a <= 0.0) return NO_HIT;
+        double b = 2.0 * (fx * dx + fy * dy);
+        double disc = b * b - 4.0 * a * c;
+        if (disc < 0.0) return NO_HIT;
+
+        double t = (-b - std::sqrt(disc)) / (2.0 * a);
+        return (t >= 0.0 && t <= 1.0) ? t : NO_HIT;
+    }
+}
+
+void GunshotTable::Spawn(double px, double py, double dx, double dy, double v, double range,
+    TeamId t, int dmg)
+{
+    x.push_back(px);
+    y.push_back(py);
+    dirX.push_back(dx);
+    dirY.push_back(dy);
+    speed.push_back(v);
+    remaining.push_back(range);
+    team.push_back(t);
+    damage.push_back(dmg);
+}
+
+void GunshotTable::Clear()
+{
+    Resize(0);
+}
+
+void GunshotTable::Move(int from, int to)
+{
+    x[to] = x[from];
+    y[to] = y[from];
+    dirX[to] = dirX[from];
+    dirY[to] = dirY[from];
+    speed[to] = speed[from];
+    remaining[to] = remaining[from];
+    team[to] = team[from];
+    damage[to] = damage[from];
+}
+
+void GunshotTable::Resize(int count)
+{
+    x.resize(count);
+    y.resize(count);
+    dirX.resize(count);
+    dirY.resize(count);
+    speed.resize(count);
+    remaining.resize(count);
+    team.resize(count);
+    damage.resize(count);
+}
+
+void GunshotTable::Update()
+{
+    World& world = World::Current();
+    const double dt = SimClock::Dt();
+
+    // Shots fired while this runs (a state change that shoots) are
+    // appended, and moved in this pass as well
+    int kept = 0;
+    for (int i = 0; i < Count(); ++i)
+    {
+        const double step = speed[i] * dt;
+        const double x0 = x[i];
+        const double y0 = y[i];
+        const double dx = dirX[i] * step;
+        const double dy = dirY[i] * step;
+        x[i] = x0 + dx;
+        y[i] = y0 + dy;
+        remaining[i] -= step;
+
+        const double wallT = TerrainHit(x0, y0, dx, dy);
+        if (wallT == NO_HIT) {
+            Map::AddFireRiskAt((int)(x[i] + 0.5), (int)(y[i] + 0.5), team[i], 0.002);
+        }
+
+        // Every enemy the swept capsule can touch is within this circle;
+        // the first one along the segment is hit, ties to the lowest id
+        const double reach = HIT_RADIUS + 0.5 * step;
+        world.npcGrid.QueryRadius(EnemyOf(team[i]), x0 + 0.5 * dx, y0 + 0.5 * dy, reach, candidates);
+        NPC* hit = nullptr;
+        double hitT = NO_HIT;
+        for (NPC* enemy : candidates) {
+            double t = CircleHit(x0, y0, dx, dy, enemy->getX(), enemy->getY(), HIT_RADIUS);
+            if (t < hitT) {
+                hit = enemy;
+                hitT = t;
+            }
+        }
+        if (hitT > wallT) hit = nullptr;    // the wall is reached first
+
+        bool removeShot = wallT != NO_HIT || remaining[i] <= 0.0;
+        if (hit) {
+            hit->TakeDamage(damage[i]);
+            removeShot = true;
+        }
+
+        if (!removeShot) {
+            if (kept != i) Move(i, kept);
+            kept++;
+        }
+    }
+    Resize(kept);
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <vector>
+#include "Roles.h"
+
+class NPC;
+
+// ---------------------------------------------------------
+// GunshotTable - the bullets in flight of one world, as structure of arrays
+// Update moves every shot one tick along its direction and tests the whole
+// segment it swept, not just its end point: terrain by walking the cells
+// the segment crosses (DDA), enemies by a swept circle test against the
+// candidates SpatialHash returns around the segment. A shot stops at the
+// first of the two along its path. Finished shots are compacted away in
+// the same pass, so removal is O(1) each and the survivors keep their
+// firing order, which decides who is hit first.
+// ---------------------------------------------------------
+class GunshotTable {
+public:
+    static constexpr double HIT_RADIUS = 1.0;     // cells from an NPC's centre
+
+    void Spawn(double x, double y, double dirX, double dirY, double speed, double range,
+        TeamId team, int damage);
+    // Moves, hit-tests and retires every shot (operates on World::Current())
+    void Update();
+    void Clear();
+
+    int Count() const { return (int)x.size(); }
+
+    std::vector<double> x, y;
+    std::vector<double> dirX, dirY;         // unit direction
+    std::vector<double> speed;              // cells per second
+    std::vector<double> remaining;          // distance left before the shot fades
+    std::vector<TeamId> team;
+    std::vector<int> damage;
+
+private:
+    void Move(int from, int to);
+    void Resize(int count);
+
+    std::vector<NPC*> candidates;           // scratch for enemy queries
+};
@@ -0,0 +1,423 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include "Simulation.h"
+#include "SimClock.h"
+#include "World.h"
+#include "BatchRunner.h"
+#include "Log.h"
+#include "MapKernels.h"
+#include "NPC.h"
+#include "StatePool.h"
+
+// ---------------------------------------------------------
+// Headless driver - runs the simulation core without a window
+// Usage: Headless [--ticks N] [--seed S] [--fov rays|shadow] [--path astar|jps|hpa]
+//                 [--path-workers N] [--path-cache] [--profile FILE] [--log SPEC]
+//        Headless --bench
+//        Headless --selftest
+//        Headless --batch N [--threads T] [--seed S] [--max-seconds X]
+//                 [--fire-range a,b,...] [--grenade-damage a,b,...]
+// Ticks are fixed SimClock steps, so the run is as fast as the CPU allows.
+// ---------------------------------------------------------
+
+static void PrintUsage(const char* exe)
+{
+    printf("Usage: %s [--ticks N] [--seed S] [--fov rays|shadow] [--path astar|jps|hpa]\n", exe);
+    printf("          [--path-workers N] [--path-cache] [--profile FILE] [--log SPEC]\n");
+    printf("       %s --bench\n", exe);
+    printf("       %s --selftest\n", exe);
+    printf("       %s --batch N [--threads T] [--seed S] [--max-seconds X]\n", exe);
+    printf("          [--fire-range a,b,...] [--grenade-damage a,b,...]\n");
+    printf("  --ticks N            number of simulation ticks to run (default 10000)\n");
+    printf("  --seed S             random seed (default: time-based; batch default 1)\n");
+    printf("  --fov B              visibility backend: rays (default) or shadow (shadowcasting)\n");
+    printf("  --path P             path search: astar (default), jps (jump point search) or hpa (hierarchical)\n");
+    printf("  --path-workers N     search FSM path requests on N threads, one tick late (default 0: inline)\n");
+    printf("  --path-cache         reuse recent FindSafePath routes until the map changes along them\n");
+    printf("  --profile FILE       write stage timings and path search counts of every tick as CSV\n");
+    printf("  --log SPEC           log filter, e.g. warn or info,path=debug,combat=off (default info)\n");
+    printf("  --bench              time the map grid kernels (scalar vs SSE2/AVX) and exit\n");
+    printf("  --selftest           run the simulation core consistency checks and exit\n");
+    printf("  --batch N            play N matches per parameter combination and report win rates\n");
+    printf("  --threads T          batch worker threads (default: hardware threads)\n");
+    printf("  --max-seconds X      batch time limit per match in sim seconds (default 600)\n");
+    printf("  --fire-range L       comma separated fire ranges to sweep\n");
+    printf("  --grenade-damage L   comma separated grenade damages to sweep\n");
+}
+
+static std::vector<double> ParseList(const char* text)
+{
+    std::vector<double> values;
+    const char* p = text;
+    while (*p) {
+        char* end = nullptr;
+        double v = strtod(p, &end);
+        if (end == p) break;
+        values.push_back(v);
+        p = (*end == ',') ? end + 1 : end;
+    }
+    return values;
+}
+
+// Times one pass over a map-sized grid; the refill from 'source' is part of
+// every pass, so it is measured alone and subtracted
+template <typename T, typename Pass>
+static double TimePass(std::vector<T>& grid, const std::vector<T>& source, int reps, Pass pass)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < reps; ++r) {
+        memcpy(grid.data(), source.data(), sizeof(T) * grid.size());
+        pass(grid.data(), (int)grid.size());
+    }
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / reps;
+}
+
+// Decay of one cell type with every instruction set this CPU has
+template <typename T>
+static void BenchDecay(const char* type, const std::vector<T>& source, int reps)
+{
+    using Map::Kernels::Isa;
+    const int cells = (int)source.size();
+    std::vector<T> grid(cells), expected = source;
+    Map::Kernels::DecayScalar(expected.data(), cells, (T)0.96, (T)0.01);
+
+    double refill = TimePass(grid, source, reps, [](T*, int) {});
+    double scalar = 0.0;
+    const Isa isas[] = { Isa::Scalar, Isa::SSE2, Isa::AVX };
+    for (Isa isa : isas) {
+        if (isa > Map::Kernels::Detected()) continue;
+        double us = TimePass(grid, source, reps, [isa](T* v, int n) {
+            Map::Kernels::Decay(v, n, (T)0.96, (T)0.01, isa);
+        }) - refill;
+        if (isa == Isa::Scalar) scalar = us;
+        bool same = memcmp(grid.data(), expected.data(), sizeof(T) * cells) == 0;
+        printf("Decay %-6s %-7s %8.2f us/pass  %5.2fx  %s\n", type, Map::Kernels::IsaName(isa), us,
+            us > 0.0 ? scalar / us : 0.0, same ? "matches scalar" : "DIFFERS FROM SCALAR");
+    }
+}
+
+static int RunKernelBench()
+{
+    const int cells = Map::W * Map::H;
+    const int reps = 20000;
+
+    // Dynamic costs as they look mid-match: mostly zero, some hot cells, some near the floor
+    std::vector<double> source(cells);
+    unsigned int state = 12345;
+    for (double& v : source) {
+        state = state * 1103515245u + 12345u;
+        unsigned int roll = (state >> 16) % 100;
+        v = roll < 70 ? 0.0 : (roll < 85 ? 0.005 + roll * 0.0002 : roll * 0.5);
+    }
+
+    printf("=== MAP KERNEL BENCH (%d cells, %d passes, detected %s) ===\n", cells, reps,
+        Map::Kernels::IsaName(Map::Kernels::Detected()));
+    BenchDecay("double", source, reps);
+    BenchDecay("float", std::vector<float>(source.begin(), source.end()), reps);
+
+    // Clearing: the old per-cell loop against the memset kernel
+    std::vector<double> grid(cells);
+    double refill = TimePass(grid, source, reps, [](double*, int) {});
+    double loop = TimePass(grid, source, reps, [](double* v, int n) {
+        for (int i = 0; i < n; ++i) v[i] = 0.0;
+    }) - refill;
+    double zero = TimePass(grid, source, reps, [](double* v, int n) {
+        Map::Kernels::Zero(v, n);
+    }) - refill;
+    printf("Clear loop    %8.2f us/pass\n", loop);
+    printf("Clear memset  %8.2f us/pass  %5.2fx\n", zero, zero > 0.0 ? loop / zero : 0.0);
+
+    size_t heatmaps = sizeof(Map::Layers::securityMaps) + sizeof(Map::Layers::visibilityMap) +
+        sizeof(Map::Layers::dynamicCost);
+    printf("Heatmap layers per world: %zu bytes (MAP_COMPACT_LAYERS=%d)\n", heatmaps, MAP_COMPACT_LAYERS);
+    return 0;
+}
+
+// Submits one off-tick path request for the first Orange warrior, optionally
+// re-enters the warrior's current state type while the request is in flight,
+// and reports whether the callback ran
+static bool PathResultDelivered(bool reenterState)
+{
+    MatchParams params;
+    params.seed = 1;
+    std::unique_ptr<World> world(new World(params));
+    WorldScope worldScope(world.get());
+    Simulation::Setup();
+    world->pathRequests.SetWorkers(1);
+
+    NPC* warrior = nullptr;
+    for (NPC* npc : world->Team(TeamId::Orange)) {
+        if (npc->getRole() == Role::Warrior) {
+            warrior = npc;
+            break;
+        }
+    }
+
+    bool delivered = false;
+    Path::Request request;
+    request.sx = (int)warrior->getX();
+    request.sy = (int)warrior->getY();
+    request.gx = request.sx;
+    request.gy = request.sy;
+    request.team = warrior->getTeam();
+    request.ignoreNpcId = warrior->GetId();
+    world->pathRequests.Submit(warrior, request, [&delivered](NPC*, Path::Result&) { delivered = true; });
+
+    world->pathRequests.Update();      // hands the request to the worker
+    if (reenterState) {
+        // Same state type, so the pool hands back the same object. OnEnter is
+        // skipped: its own request would cancel the one under test.
+        warrior->setCurrentState(warrior->getStatePool().Acquire<GoToCombat>());
+    }
+    world->pathRequests.Update();      // delivers it
+
+    world->pathRequests.SetWorkers(0);
+    Simulation::Cleanup();
+    return delivered;
+}
+
+static int RunSelfTest()
+{
+    Log::SetLevel(Log::Level::Off);
+    int failures = 0;
+    auto check = [&failures](const char* name, bool ok) {
+        printf("%-60s %s\n", name, ok ? "ok" : "FAILED");
+        if (!ok) failures++;
+    };
+
+    check("PathService delivers an off-tick result", PathResultDelivered(false));
+    check("PathService drops a result after the state is re-entered", !PathResultDelivered(true));
+
+    printf("%d check(s) failed\n", failures);
+    return failures == 0 ? 0 : 1;
+}
+
+static void WriteProfileHeader(FILE* csv)
+{
+    fprintf(csv, "tick");
+    for (int s = 0; s < Profile::STAGE_COUNT; ++s) fprintf(csv, ",%s_us", Profile::StageName((Profile::Stage)s));
+    fprintf(csv, ",searches,expanded\n");
+}
+
+static void WriteProfileRow(FILE* csv, long long tick, const TickProfiler::Row& row)
+{
+    fprintf(csv, "%lld", tick);
+    for (int s = 0; s < Profile::STAGE_COUNT; ++s) fprintf(csv, ",%.1f", row.us[s]);
+    fprintf(csv, ",%lld,%lld\n", row.searches, row.expanded);
+}
+
+// Rolling statistics over the last TickProfiler::WINDOW ticks
+static void PrintProfileSummary(const TickProfiler& profiler)
+{
+    printf("Stage timings over the last %d ticks (us):\n", profiler.Count());
+    printf("  %-14s %9s %9s %9s\n", "stage", "min", "avg", "p99");
+    for (int s = 0; s < Profile::STAGE_COUNT; ++s) {
+        TickProfiler::Stats st = profiler.StageStats((Profile::Stage)s);
+        printf("  %-14s %9.1f %9.1f %9.1f\n", Profile::StageName((Profile::Stage)s), st.min, st.avg, st.p99);
+    }
+    TickProfiler::Stats searches = profiler.SearchStats();
+    TickProfiler::Stats expanded = profiler.ExpandedStats();
+    printf("  %-14s %9.0f %9.2f %9.0f\n", "searches", searches.min, searches.avg, searches.p99);
+    printf("  %-14s %9.0f %9.1f %9.0f\n", "expanded", expanded.min, expanded.avg, expanded.p99);
+}
+
+static int RunBatch(BatchConfig config, bool keepLog)
+{
+    // The simulation logs every decision; keep the report readable
+    if (!keepLog) Log::SetLevel(Log::Level::Off);
+
+    auto wallStart = std::chrono::steady_clock::now();
+    std::vector<BatchResult> results = BatchRunner::Run(config);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+    int totalMatches = 0;
+    fprintf(stderr, "=== BATCH RUN COMPLETE ===\n");
+    fprintf(stderr, "%10s %8s %8s %8s %8s %8s %8s %10s %10s %10s\n",
+        "fireRange", "grenade", "matches", "orange", "blue", "draw", "timeout",
+        "avgDur", "minDur", "maxDur");
+    for (const BatchResult& r : results) {
+        totalMatches += r.matches;
+        fprintf(stderr, "%10.2f %8d %8d %7.1f%% %7.1f%% %7.1f%% %7.1f%% %10.1f %10.1f %10.1f\n",
+            r.params.fireRange, r.params.grenadeDamage, r.matches,
+            100.0 * r.Rate(r.orangeWins), 100.0 * r.Rate(r.blueWins),
+            100.0 * r.Rate(r.draws), 100.0 * r.Rate(r.timeouts),
+            r.AverageDuration(), r.minDuration, r.maxDuration);
+    }
+    fprintf(stderr, "Matches: %d  Seeds: %u..%u  Wall time: %.3f s  Matches/sec: %.2f\n",
+        totalMatches, config.baseSeed, config.baseSeed + config.matchesPerSetting - 1, seconds,
+        seconds > 0.0 ? totalMatches / seconds : 0.0);
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    long long ticks = 10000;
+    bool hasSeed = false;
+    unsigned int seed = 0;
+    int batch = 0;
+    int pathWorkers = 0;
+    bool pathCache = false;
+    const char* profilePath = nullptr;
+    const char* logSpec = nullptr;
+    BatchConfig config;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) {
+            ticks = atoll(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = (unsigned int)strtoul(argv[++i], nullptr, 10);
+            hasSeed = true;
+        }
+        else if (strcmp(argv[i], "--fov") == 0 && i + 1 < argc) {
+            const char* name = argv[++i];
+            if (strcmp(name, "rays") == 0) config.visibility = Map::VisibilityBackend::Rays;
+            else if (strcmp(name, "shadow") == 0) config.visibility = Map::VisibilityBackend::Shadowcast;
+            else {
+                PrintUsage(argv[0]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--path") == 0 && i + 1 < argc) {
+            const char* name = argv[++i];
+            if (strcmp(name, "astar") == 0) config.pathSearch = Path::SearchMode::AStar;
+            else if (strcmp(name, "jps") == 0) config.pathSearch = Path::SearchMode::JumpPoint;
+            else if (strcmp(name, "hpa") == 0) config.pathSearch = Path::SearchMode::Hierarchical;
+            else {
+                PrintUsage(argv[0]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--path-workers") == 0 && i + 1 < argc) {
+            pathWorkers = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--path-cache") == 0) {
+            pathCache = true;
+        }
+        else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+            profilePath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--log") == 0 && i + 1 < argc) {
+            logSpec = argv[++i];
+            if (!Log::Configure(logSpec)) {
+                PrintUsage(argv[0]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--bench") == 0) {
+            return RunKernelBench();
+        }
+        else if (strcmp(argv[i], "--selftest") == 0) {
+            return RunSelfTest();
+        }
+        else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            batch = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            config.threads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--max-seconds") == 0 && i + 1 < argc) {
+            config.maxMatchSeconds = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--fire-range") == 0 && i + 1 < argc) {
+            config.fireRanges = ParseList(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--grenade-damage") == 0 && i + 1 < argc) {
+            for (double v : ParseList(argv[++i])) config.grenadeDamages.push_back((int)v);
+        }
+        else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (batch > 0) {
+        if (config.maxMatchSeconds <= 0.0) {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+        config.matchesPerSetting = batch;
+        config.baseSeed = hasSeed ? seed : 1;
+        return RunBatch(config, logSpec != nullptr);
+    }
+
+    if (ticks <= 0) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    MatchParams params;
+    params.seed = hasSeed ? seed : (unsigned int)time(nullptr);
+    LOG_INFO(General, "Random seed = %u", params.seed);
+
+    // Heap allocated: the map layers alone are several hundred KB
+    std::unique_ptr<World> world(new World(params));
+    WorldScope worldScope(world.get());
+    Map::SetVisibilityBackend(config.visibility);
+    Path::SetSearchMode(config.pathSearch);
+    world->pathRequests.SetWorkers(pathWorkers);
+    world->pathCache.SetEnabled(pathCache);
+
+    FILE* profileCsv = nullptr;
+    if (profilePath) {
+        profileCsv = fopen(profilePath, "w");
+        if (!profileCsv) {
+            fprintf(stderr, "Cannot write %s\n", profilePath);
+            return 1;
+        }
+        WriteProfileHeader(profileCsv);
+    }
+
+    Simulation::Setup();
+
+    int matchesFinished = 0;
+    double simSeconds = 0.0;
+    auto wallStart = std::chrono::steady_clock::now();
+
+    for (long long tick = 0; tick < ticks; ++tick) {
+        Simulation::Step();
+        simSeconds += SimClock::FIXED_DT;
+        if (profileCsv) WriteProfileRow(profileCsv, tick + 1, world->profiler.Last());
+
+        if (Simulation::GetMatchState() != MatchState::Running) {
+            matchesFinished++;
+            LOG_INFO(General, "Match %d finished after %.1f s (state %d)",
+                matchesFinished, Simulation::GetMatchDuration(), (int)Simulation::GetMatchState());
+            Simulation::Reset();
+        }
+    }
+
+    auto wallEnd = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(wallEnd - wallStart).count();
+
+    Simulation::Cleanup();
+    Log::Flush();
+    if (profileCsv) fclose(profileCsv);
+
+    printf("=== HEADLESS RUN COMPLETE ===\n");
+    printf("Ticks: %lld  Simulated: %.1f s  Matches finished: %d\n", ticks, simSeconds, matchesFinished);
+    printf("Wall time: %.3f s  Ticks/sec: %.1f  Speedup: %.1fx\n", seconds,
+        seconds > 0.0 ? ticks / seconds : 0.0,
+        seconds > 0.0 ? simSeconds / seconds : 0.0);
+    if (profileCsv) {
+        PrintProfileSummary(world->profiler);
+    }
+    if (pathWorkers > 0) {
+        printf("Path requests: %llu  Off-tick: %llu  Dropped: %llu\n", world->pathRequests.Requests(),
+            world->pathRequests.Deferred(), world->pathRequests.Dropped());
+    }
+    if (pathCache) {
+        const PathCache& cache = world->pathCache;
+        printf("Path cache: %llu hits (%llu suffix)  %llu misses  %llu retired\n",
+            cache.Hits(), cache.SuffixHits(), cache.Misses(), cache.Retired());
+    }
+    if (Log::DroppedCount() > 0) {
+        printf("Log messages dropped: %llu\n", Log::DroppedCount());
+    }
+    return 0;
+}
@@ -0,0 +1,293 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "IncrementalPath.h"
+#include "Map.h"
+#include "Log.h"
+
+namespace Path
+{
+    namespace {
+        const double INF = std::numeric_limits<double>::infinity();
+        const int DX[4] = { +1, -1, 0, 0 };
+        const int DY[4] = { 0, 0, +1, -1 };
+    }
+
+    IncrementalPlanner::Vertex* IncrementalPlanner::Find(int cell)
+    {
+        int i = slot[cell];
+        return i < 0 ? nullptr : &vertices[i];
+    }
+
+    IncrementalPlanner::Vertex& IncrementalPlanner::At(int cell)
+    {
+        int& i = slot[cell];
+        if (i < 0) {
+            i = (int)vertices.size();
+            Vertex v;
+            v.cell = cell;
+            v.g = INF;
+            v.rhs = INF;
+            v.cost = INF;
+            vertices.push_back(v);
+        }
+        return vertices[i];
+    }
+
+    // Cost of stepping into the cell; the same sum FindSafePath uses
+    double IncrementalPlanner::ReadCost(int cell) const
+    {
+        int x = cell % Map::W;
+        int y = cell / Map::W;
+        if (!Map::IsWalkable(x, y)) return INF;
+        double security = Map::GetSecurityValue(y, x, team);
+        return 1.0 + securityWeight * security * 10.0 +
+            Map::GetOccupancyPenalty(x, y, ignoreNpcId) + Map::GetDynamicCost(x, y);
+    }
+
+    double IncrementalPlanner::Cost(int cell)
+    {
+        Vertex& v = At(cell);
+        if (!v.costKnown) {
+            v.cost = ReadCost(cell);
+            v.costKnown = true;
+        }
+        return v.cost;
+    }
+
+    // Distance from the NPC's cell, the search runs toward it
+    double IncrementalPlanner::Heuristic(int cell) const
+    {
+        return std::abs(cell % Map::W - start % Map::W) + std::abs(cell / Map::W - start / Map::W);
+    }
+
+    IncrementalPlanner::Key IncrementalPlanner::CalculateKey(int cell)
+    {
+        Vertex& v = At(cell);
+        double best = std::min(v.g, v.rhs);
+        return { best + Heuristic(cell) + km, best };
+    }
+
+    void IncrementalPlanner::UpdateVertex(int cell)
+    {
+        Vertex& v = At(cell);
+        if (cell != goal) {
+            // rhs = cheapest step into a neighbour plus that neighbour's distance to the goal
+            int x = cell % Map::W;
+            int y = cell / Map::W;
+            double rhs = INF;
+            for (int k = 0; k < 4; ++k) {
+                int nx = x + DX[k];
+                int ny = y + DY[k];
+                if (!Map::InBounds(nx, ny)) continue;
+                int n = ny * Map::W + nx;
+                Vertex* nv = Find(n);
+                if (!nv || nv->g == INF) continue;
+                rhs = std::min(rhs, Cost(n) + nv->g);
+            }
+            v.rhs = rhs;
+        }
+
+        ++v.version;
+        v.open = v.g != v.rhs;
+        if (v.open) {
+            open.push_back({ CalculateKey(cell), cell, v.version });
+            std::push_heap(open.begin(), open.end());
+        }
+    }
+
+    void IncrementalPlanner::ComputeShortestPath()
+    {
+        for (;;) {
+            // Drop entries of vertices that were updated or closed since they were queued
+            while (!open.empty()) {
+                const Entry& top = open.front();
+                const Vertex* v = Find(top.cell);
+                if (v && v->open && v->version == top.version) break;
+                std::pop_heap(open.begin(), open.end());
+                open.pop_back();
+            }
+            if (open.empty()) return;
+
+            Entry top = open.front();
+            Vertex& s = At(start);
+            if (!(top.key < CalculateKey(start)) && s.rhs == s.g) return;
+
+            std::pop_heap(open.begin(), open.end());
+            open.pop_back();
+            ++expanded;
+
+            int cell = top.cell;
+            Key now = CalculateKey(cell);
+            if (top.key < now) {
+                Vertex& v = At(cell);
+                ++v.version;
+                open.push_back({ now, cell, v.version });
+                std::push_heap(open.begin(), open.end());
+                continue;
+            }
+
+            Vertex& v = At(cell);
+            v.open = false;
+            ++v.version;
+            bool raised = v.g <= v.rhs;     // underconsistent: g has to go back up
+            v.g = raised ? INF : v.rhs;
+
+            int x = cell % Map::W;
+            int y = cell / Map::W;
+            for (int k = 0; k < 4; ++k) {
+                int nx = x + DX[k];
+                int ny = y + DY[k];
+                if (!Map::InBounds(nx, ny) || !Map::IsWalkable(nx, ny)) continue;
+                UpdateVertex(ny * Map::W + nx);
+            }
+            if (raised) UpdateVertex(cell);
+        }
+    }
+
+    void IncrementalPlanner::Refresh(int cell)
+    {
+        Vertex* v = Find(cell);
+        if (!v || !v->costKnown) return;
+
+        double cost = ReadCost(cell);
+        if (cost == v->cost) return;
+        v->cost = cost;
+
+        // Entering 'cell' got cheaper or dearer for each of its neighbours
+        int x = cell % Map::W;
+        int y = cell / Map::W;
+        for (int k = 0; k < 4; ++k) {
+            int nx = x + DX[k];
+            int ny = y + DY[k];
+            if (!Map::InBounds(nx, ny) || !Map::IsWalkable(nx, ny)) continue;
+            UpdateVertex(ny * Map::W + nx);
+        }
+    }
+
+    bool IncrementalPlanner::Extract(std::vector<Cell>& out)
+    {
+        out.clear();
+        route.clear();
+        int cell = start;
+        out.emplace_back(cell % Map::W, cell / Map::W);
+        route.push_back(cell);
+
+        const int limit = Map::W * Map::H;
+        while (cell != goal) {
+            int x = cell % Map::W;
+            int y = cell / Map::W;
+            int next = -1;
+            double best = INF;
+            for (int k = 0; k < 4; ++k) {
+                int nx = x + DX[k];
+                int ny = y + DY[k];
+                if (!Map::InBounds(nx, ny)) continue;
+                int n = ny * Map::W + nx;
+                Vertex* nv = Find(n);
+                if (!nv || nv->g == INF) continue;
+                double total = Cost(n) + nv->g;
+                if (total < best) {
+                    best = total;
+                    next = n;
+                }
+            }
+            if (next == -1 || (int)route.size() > limit) return false;
+            cell = next;
+            out.emplace_back(cell % Map::W, cell / Map::W);
+            route.push_back(cell);
+        }
+        return true;
+    }
+
+    bool IncrementalPlanner::Plan(int sx, int sy, int gx, int gy, TeamId team, double securityWeight, int ignoreNpcId,
+        std::vector<Cell>& out)
+    {
+        // Blocks apply to this request only, even if it is rejected below
+        std::vector<int> requestBlocks;
+        requestBlocks.swap(pendingBlocks);
+
+        if (!Map::InBounds(sx, sy) || !Map::InBounds(gx, gy)) return false;
+        if (!Map::IsWalkable(sx, sy) || !Map::IsWalkable(gx, gy)) return false;
+
+        if (slot.empty()) slot.assign(Map::W * Map::H, -1);
+
+        int s = sy * Map::W + sx;
+        int g = gy * Map::W + gx;
+        bool reuse = active && g == goal && team == this->team && securityWeight == this->securityWeight &&
+            ignoreNpcId == this->ignoreNpcId && Map::GetTerrainHash() == terrainHash;
+
+        if (reuse) {
+            // The keys already queued were computed from the old start
+            km += std::abs(sx - start % Map::W) + std::abs(sy - start / Map::W);
+            start = s;
+            std::vector<int> stale;
+            stale.swap(route);
+            for (int cell : stale) Refresh(cell);
+            for (int cell : blocked) Refresh(cell);
+            ++repairs;
+        }
+        else {
+            Reset();
+            active = true;
+            goal = g;
+            start = s;
+            this->team = team;
+            this->securityWeight = securityWeight;
+            this->ignoreNpcId = ignoreNpcId;
+            terrainHash = Map::GetTerrainHash();
+
+            Vertex& v = At(goal);
+            v.rhs = 0.0;
+            v.open = true;
+            open.push_back({ CalculateKey(goal), goal, v.version });
+            ++searches;
+        }
+
+        // Cells blocked for this request stay impassable until the next one
+        blocked.clear();
+        for (int cell : requestBlocks) {
+            if (cell == goal || cell == start) continue;
+            Vertex& v = At(cell);
+            v.cost = INF;
+            v.costKnown = true;
+            blocked.push_back(cell);
+            int x = cell % Map::W;
+            int y = cell / Map::W;
+            for (int k = 0; k < 4; ++k) {
+                int nx = x + DX[k];
+                int ny = y + DY[k];
+                if (!Map::InBounds(nx, ny) || !Map::IsWalkable(nx, ny)) continue;
+                UpdateVertex(ny * Map::W + nx);
+            }
+        }
+
+        ComputeShortestPath();
+        if (At(start).g == INF) {
+            route.clear();
+            return false;
+        }
+        if (!Extract(out)) {
+            LOG_WARN(Path, "Incremental plan: route from (%d,%d) to (%d,%d) broke off", sx, sy, gx, gy);
+            Reset();
+            return false;
+        }
+        return true;
+    }
+
+    void IncrementalPlanner::Block(int x, int y)
+    {
+        if (Map::InBounds(x, y)) pendingBlocks.push_back(y * Map::W + x);
+    }
+
+    void IncrementalPlanner::Reset()
+    {
+        active = false;
+        km = 0.0;
+        for (const Vertex& v : vertices) slot[v.cell] = -1;
+        vertices.clear();
+        open.clear();
+        route.clear();
+        blocked.clear();
+    }
+}
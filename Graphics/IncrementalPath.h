@@ -0,0 +1,104 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "Roles.h"
+#include "Pathfinding.h"
+
+namespace Path
+{
+    // ---------------------------------------------------------
+    // IncrementalPlanner - D* Lite search owned by one NPC
+    // The search runs backward from the goal, so after the NPC has moved
+    // the stored g/rhs values are still valid and a new request only
+    // repairs them. Before repairing, the step costs of the last route and
+    // of blocked cells are read again, and only the cells whose cost
+    // changed (occupancy, dynamic cost, security) are updated. Costs the
+    // search cached away from the route are kept until the plan restarts.
+    // The plan restarts when the goal, team, weight or terrain changes.
+    // Step costs are the same as in FindSafePath.
+    // ---------------------------------------------------------
+    class IncrementalPlanner
+    {
+    public:
+        // Route from (sx,sy) to (gx,gy), start cell first (same layout as FindSafePath).
+        // Returns false if the goal is not walkable or cannot be reached.
+        bool Plan(int sx, int sy, int gx, int gy, TeamId team, double securityWeight, int ignoreNpcId,
+            std::vector<Cell>& out);
+
+        // Treats (x,y) as impassable for the next Plan only
+        void Block(int x, int y);
+
+        // Forgets the search; the next Plan starts from scratch
+        void Reset();
+
+        // Counters for profiling
+        unsigned long long Searches() const { return searches; }   // plans started from scratch
+        unsigned long long Repairs() const { return repairs; }     // plans that reused the search
+        unsigned long long Expanded() const { return expanded; }   // vertices popped so far
+
+    private:
+        struct Key {
+            double k1, k2;
+            bool operator<(const Key& other) const
+            {
+                if (k1 != other.k1) return k1 < other.k1;
+                return k2 < other.k2;
+            }
+        };
+
+        struct Vertex {
+            int cell;
+            double g;
+            double rhs;
+            double cost;                // step cost of entering this cell as last read
+            unsigned int version = 0;   // queue entries with another version are stale
+            bool open = false;
+            bool costKnown = false;
+        };
+
+        struct Entry {
+            Key key;
+            int cell;
+            unsigned int version;
+            // Min-heap on key, then cell index, so equal keys pop in a fixed order
+            bool operator<(const Entry& other) const
+            {
+                if (key < other.key) return false;
+                if (other.key < key) return true;
+                return cell > other.cell;
+            }
+        };
+
+        Vertex& At(int cell);
+        // Vertex of the cell if the search has reached it, otherwise nullptr
+        Vertex* Find(int cell);
+        double Cost(int cell);
+        double ReadCost(int cell) const;
+        double Heuristic(int cell) const;
+        Key CalculateKey(int cell);
+        void UpdateVertex(int cell);
+        void Refresh(int cell);
+        void ComputeShortestPath();
+        bool Extract(std::vector<Cell>& out);
+
+        bool active = false;
+        int goal = -1;
+        int start = -1;
+        double km = 0.0;
+        TeamId team = TeamId::Orange;
+        double securityWeight = 0.0;
+        int ignoreNpcId = -1;
+        uint64_t terrainHash = 0;
+
+        std::vector<Vertex> vertices;               // only the cells the search reached
+        std::vector<int> slot;                      // cell index -> position in 'vertices', -1 = none
+        std::vector<Entry> open;                    // binary heap with lazy removal
+        std::vector<int> route;                     // cells of the last extracted route
+        std::vector<int> blocked;                   // cells the last Plan treated as impassable
+        std::vector<int> pendingBlocks;             // Block calls since the last Plan
+
+        unsigned long long searches = 0;
+        unsigned long long repairs = 0;
+        unsigned long long expanded = 0;
+    };
+}
@@ -0,0 +1,277 @@
+#include <stdarg.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "Log.h"
+#include "SimClock.h"
+#include "World.h"
+
+namespace Log
+{
+    namespace detail {
+        std::atomic<unsigned char> minLevel[(int)Category::Count] = {
+            { LOG_LEVEL_INFO }, { LOG_LEVEL_INFO }, { LOG_LEVEL_INFO }, { LOG_LEVEL_INFO }, { LOG_LEVEL_INFO }
+        };
+    }
+
+    namespace {
+        const int RING_SIZE = 4096;             // power of two
+        const int MESSAGE_SIZE = 240;           // longer messages are truncated
+
+        struct Record {
+            std::atomic<size_t> sequence;       // Vyukov bounded queue turn counter
+            long long tick;                     // SimClock tick of the logging world, -1 = none
+            Level level;
+            Category category;
+            char text[MESSAGE_SIZE];
+        };
+
+        // Multi-producer ring drained by one writer thread. A producer claims
+        // a slot by advancing 'head'; the slot's sequence tells both sides
+        // whose turn it is, so neither side ever takes a lock.
+        class Writer {
+        public:
+            Writer()
+                : head(0), tail(0), written(0), dropped(0), output(stdout), running(true)
+            {
+                for (size_t i = 0; i < (size_t)RING_SIZE; ++i) {
+                    ring[i].sequence.store(i, std::memory_order_relaxed);
+                }
+                thread = std::thread(&Writer::Run, this);
+            }
+
+            ~Writer()
+            {
+                running.store(false, std::memory_order_release);
+                thread.join();
+            }
+
+            Record* Claim(size_t& position)
+            {
+                size_t pos = head.load(std::memory_order_relaxed);
+                for (;;) {
+                    Record& r = ring[pos & (RING_SIZE - 1)];
+                    size_t seq = r.sequence.load(std::memory_order_acquire);
+                    intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+                    if (diff == 0) {
+                        if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                            position = pos;
+                            return &r;
+                        }
+                    }
+                    else if (diff < 0) {
+                        dropped.fetch_add(1, std::memory_order_relaxed);
+                        return nullptr;         // full: the writer is a whole ring behind
+                    }
+                    else {
+                        pos = head.load(std::memory_order_relaxed);
+                    }
+                }
+            }
+
+            void Publish(Record* r, size_t position)
+            {
+                r->sequence.store(position + 1, std::memory_order_release);
+            }
+
+            void Flush()
+            {
+                size_t target = head.load(std::memory_order_acquire);
+                while (written.load(std::memory_order_acquire) < target) {
+                    std::this_thread::sleep_for(std::chrono::microseconds(200));
+                }
+            }
+
+            std::atomic<size_t> head;           // next slot producers claim
+            size_t tail;                        // next slot the writer reads (writer thread only)
+            std::atomic<size_t> written;        // slots fully written out
+            std::atomic<unsigned long long> dropped;
+            std::atomic<FILE*> output;
+
+        private:
+            // Writes every published record; returns false if the ring was empty
+            bool Drain()
+            {
+                bool any = false;
+                FILE* out = output.load(std::memory_order_acquire);
+                for (;;) {
+                    Record& r = ring[tail & (RING_SIZE - 1)];
+                    if (r.sequence.load(std::memory_order_acquire) != tail + 1) break;
+
+                    if (out) {
+                        if (r.tick >= 0) fprintf(out, "%7lld ", r.tick);
+                        else fputs("      - ", out);
+                        fprintf(out, "%-5s %-9s %s\n", LevelName(r.level), CategoryName(r.category), r.text);
+                    }
+                    r.sequence.store(tail + RING_SIZE, std::memory_order_release);
+                    ++tail;
+                    written.store(tail, std::memory_order_release);
+                    any = true;
+                }
+                if (any && out) fflush(out);
+                return any;
+            }
+
+            void Run()
+            {
+                while (running.load(std::memory_order_acquire)) {
+                    if (!Drain()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+                Drain();
+            }
+
+            Record ring[RING_SIZE];
+            std::atomic<bool> running;
+            std::thread thread;
+        };
+
+        Writer& Instance()
+        {
+            static Writer writer;   // started on first use, drained and joined at exit
+            return writer;
+        }
+
+        bool NameEquals(const char* candidate, const char* name, size_t length)
+        {
+            if (strlen(candidate) != length) return false;
+            for (size_t i = 0; i < length; ++i) {
+                if (tolower((unsigned char)name[i]) != candidate[i]) return false;
+            }
+            return true;
+        }
+
+        bool ParseLevel(const char* name, size_t length, Level& out)
+        {
+            static const Level LEVELS[] = { Level::Debug, Level::Info, Level::Warn, Level::Error, Level::Off };
+            for (Level level : LEVELS) {
+                if (NameEquals(LevelName(level), name, length)) {
+                    out = level;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool ParseCategory(const char* name, size_t length, Category& out)
+        {
+            for (int c = 0; c < (int)Category::Count; ++c) {
+                if (NameEquals(CategoryName((Category)c), name, length)) {
+                    out = (Category)c;
+                    return true;
+                }
+            }
+            return false;
+        }
+    }
+
+    void SetLevel(Level level)
+    {
+        for (auto& minLevel : detail::minLevel) {
+            minLevel.store((unsigned char)level, std::memory_order_relaxed);
+        }
+    }
+
+    void SetLevel(Category category, Level level)
+    {
+        detail::minLevel[(int)category].store((unsigned char)level, std::memory_order_relaxed);
+    }
+
+    Level GetLevel(Category category)
+    {
+        return (Level)detail::minLevel[(int)category].load(std::memory_order_relaxed);
+    }
+
+    bool Configure(const char* spec)
+    {
+        // Parse everything first so a bad spec leaves the filter untouched
+        Level levels[(int)Category::Count];
+        for (int c = 0; c < (int)Category::Count; ++c) levels[c] = GetLevel((Category)c);
+
+        const char* p = spec;
+        while (*p) {
+            const char* end = strchr(p, ',');
+            size_t length = end ? (size_t)(end - p) : strlen(p);
+            const char* eq = (const char*)memchr(p, '=', length);
+
+            Level level;
+            if (eq) {
+                Category category;
+                if (!ParseCategory(p, eq - p, category)) return false;
+                if (!ParseLevel(eq + 1, length - (eq + 1 - p), level)) return false;
+                levels[(int)category] = level;
+            }
+            else {
+                if (!ParseLevel(p, length, level)) return false;
+                for (Level& l : levels) l = level;
+            }
+            p = end ? end + 1 : p + length;
+        }
+
+        for (int c = 0; c < (int)Category::Count; ++c) SetLevel((Category)c, levels[c]);
+        return true;
+    }
+
+    void Write(Level level, Category category, const char* fmt, ...)
+    {
+        Writer& writer = Instance();
+        size_t position = 0;
+        Record* r = writer.Claim(position);
+        if (!r) return;
+
+        r->tick = World::HasCurrent() ? SimClock::Ticks() : -1;
+        r->level = level;
+        r->category = category;
+
+        va_list args;
+        va_start(args, fmt);
+        vsnprintf(r->text, MESSAGE_SIZE, fmt, args);
+        va_end(args);
+
+        writer.Publish(r, position);
+    }
+
+    void SetOutput(FILE* out)
+    {
+        Writer& writer = Instance();
+        writer.Flush();
+        writer.output.store(out, std::memory_order_release);
+    }
+
+    void Flush()
+    {
+        Instance().Flush();
+    }
+
+    unsigned long long DroppedCount()
+    {
+        return Instance().dropped.load(std::memory_order_relaxed);
+    }
+
+    const char* LevelName(Level level)
+    {
+        switch (level) {
+        case Level::Debug: return "debug";
+        case Level::Info:  return "info";
+        case Level::Warn:  return "warn";
+        case Level::Error: return "error";
+        case Level::Off:   return "off";
+        }
+        return "?";
+    }
+
+    const char* CategoryName(Category category)
+    {
+        switch (category) {
+        case Category::General:   return "general";
+        case Category::Path:      return "path";
+        case Category::Combat:    return "combat";
+        case Category::Commander: return "commander";
+        case Category::State:     return "state";
+        default: break;
+        }
+        return "?";
+    }
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include <stdio.h>
+#include <atomic>
+
+// ---------------------------------------------------------
+// Log - levelled, per-category logging for the simulation core
+// Use the LOG_* macros. A macro below LOG_COMPILE_LEVEL expands to
+// nothing (its arguments are not evaluated); one below the runtime level
+// of its category costs a single relaxed load. Enabled messages are
+// formatted into a lock-free ring buffer and written by a background
+// thread, so logging never waits on stdout. When the ring is full the
+// message is dropped and counted instead of blocking the simulation.
+// ---------------------------------------------------------
+
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO  1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_ERROR 3
+#define LOG_LEVEL_OFF   4
+
+// Lowest level compiled in; Release builds drop Debug messages entirely
+#ifndef LOG_COMPILE_LEVEL
+#ifdef NDEBUG
+#define LOG_COMPILE_LEVEL LOG_LEVEL_INFO
+#else
+#define LOG_COMPILE_LEVEL LOG_LEVEL_DEBUG
+#endif
+#endif
+
+namespace Log
+{
+    enum class Level : unsigned char {
+        Debug = LOG_LEVEL_DEBUG,
+        Info = LOG_LEVEL_INFO,
+        Warn = LOG_LEVEL_WARN,
+        Error = LOG_LEVEL_ERROR,
+        Off = LOG_LEVEL_OFF
+    };
+
+    enum class Category : unsigned char {
+        General,    // setup, drivers, frontend
+        Path,       // path requests, replans, movement blocks
+        Combat,     // shots, grenades, damage, ammo
+        Commander,  // commander planning and order assignment
+        State,      // FSM state entry/exit and progress
+        Count
+    };
+
+    namespace detail {
+        extern std::atomic<unsigned char> minLevel[(int)Category::Count];
+    }
+
+    // Runtime filter (default Info for every category)
+    inline bool IsEnabled(Category category, Level level)
+    {
+        return (unsigned char)level >= detail::minLevel[(int)category].load(std::memory_order_relaxed);
+    }
+    void SetLevel(Level level);                     // every category
+    void SetLevel(Category category, Level level);
+    Level GetLevel(Category category);
+
+    // Applies a filter spec such as "warn" or "info,path=debug,combat=off".
+    // Returns false (and changes nothing) if the spec does not parse.
+    bool Configure(const char* spec);
+
+    // Formats one message (printf style, no trailing newline) and queues it
+    void Write(Level level, Category category, const char* fmt, ...);
+
+    // Destination of the writer thread (default stdout); nullptr discards
+    void SetOutput(FILE* out);
+    // Blocks until every message queued so far has been written
+    void Flush();
+    // Messages lost because the ring was full
+    unsigned long long DroppedCount();
+
+    const char* LevelName(Level level);
+    const char* CategoryName(Category category);
+}
+
+#define LOG_AT(level, category, ...) \
+    do { \
+        if (Log::IsEnabled(Log::Category::category, level)) \
+            Log::Write(level, Log::Category::category, __VA_ARGS__); \
+    } while (0)
+
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(category, ...) LOG_AT(Log::Level::Debug, category, __VA_ARGS__)
+#else
+#define LOG_DEBUG(category, ...) ((void)0)
+#endif
+
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(category, ...) LOG_AT(Log::Level::Info, category, __VA_ARGS__)
+#else
+#define LOG_INFO(category, ...) ((void)0)
+#endif
+
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_WARN
+#define LOG_WARN(category, ...) LOG_AT(Log::Level::Warn, category, __VA_ARGS__)
+#else
+#define LOG_WARN(category, ...) ((void)0)
+#endif
+
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_ERROR
+#define LOG_ERROR(category, ...) LOG_AT(Log::Level::Error, category, __VA_ARGS__)
+#else
+#define LOG_ERROR(category, ...) ((void)0)
+#endif
@@ -3,37 +3,43 @@
 #include <algorithm>
 #include <vector>
 #include <queue>
-#include "glut.h"
 #include "NPC.h"
 #include "Definitions.h"
-
-extern std::vector<NPC*> teamOrange;
-extern std::vector<NPC*> teamBlue;
+#include "World.h"
+#include "RayTable.h"
+#include "MapFov.h"
+#include "MapKernels.h"
 
 namespace Map {
 
-    // Internal storage
-    static std::vector<Cell> grid;                  // terrain grid
-    static std::vector<int> occupancy;              // dynamic occupancy per cell (NPC id)
-    static double securityMaps[2][H][W] = { 0.0 };  // danger heatmap per team (0=Orange,1=Blue)
-    static double visibilityMap[H][W] = { 0.0 };    // visibility (optional)
-    static double dynamicCost[H][W] = { 0.0 };      // temporary inflated costs
+    // Internal storage lives in the current world
+    static inline Layers& CurrentLayers() { return World::Current().map; }
 
     static inline int idx(int x, int y) { return y * W + x; }
 
     // Basic operations
     void Init() {
-        grid.assign(W * H, FREE);
-        occupancy.assign(W * H, 0);
-        // reset maps too
-        for (int y = 0; y < H; ++y) {
-            for (int x = 0; x < W; ++x) {
-                securityMaps[0][y][x] = 0.0;
-                securityMaps[1][y][x] = 0.0;
-                visibilityMap[y][x] = 0.0;
-                dynamicCost[y][x] = 0.0;
-            }
+        Layers& layers = CurrentLayers();
+        layers.grid.assign(W * H, FREE);
+        layers.occupancy.assign(W * H, 0);
+        layers.planes.Rebuild(layers.grid);
+        layers.terrainHash = 0;     // all FREE
+        for (auto& row : layers.regionHash) {
+            std::fill(std::begin(row), std::end(row), 0ull);
         }
+        // reset maps too
+        ResetSecurityMaps();
+        RayTable::Standard();   // build the shared ray table up front
+        layers.visibilityMap.Clear();
+        Kernels::Zero(&layers.dynamicCost[0][0], W * H);
+    }
+
+    void VisibilityGrid::Clear() {
+#if MAP_COMPACT_LAYERS
+        Kernels::Zero(bits, (W * H + 63) / 64);
+#else
+        Kernels::Zero(&cells[0][0], W * H);
+#endif
     }
 
     static inline size_t TeamIndex(TeamId team)
@@ -45,33 +51,126 @@ namespace Map {
         return (x >= 0 && x < W && y >= 0 && y < H);
     }
 
+    // Padded range covered by TerrainPlanes
+    static inline bool InPlanes(int x, int y) {
+        return (x >= -1 && x <= W && y >= -1 && y <= H);
+    }
+
+    static inline void SetBit(uint64_t* plane, int x, int y, bool on) {
+        uint64_t& word = plane[TerrainPlanes::Word(x, y)];
+        if (on) word |= TerrainPlanes::Bit(x);
+        else word &= ~TerrainPlanes::Bit(x);
+    }
+
+    void TerrainPlanes::Update(int x, int y, Cell c) {
+        bool blocks = (c == ROCK || c == TREE || c == WAREHOUSE);
+        SetBit(walkable, x, y, c == FREE || c == TREE);
+        SetBit(blocksSight, x, y, blocks);
+        SetBit(blocksBullets, x, y, blocks);
+    }
+
+    void TerrainPlanes::Rebuild(const std::vector<Cell>& grid) {
+        // Border (and the unused tail bits) read as solid rock
+        for (int i = 0; i < WORDS; ++i) {
+            walkable[i] = 0;
+            blocksSight[i] = ~0ull;
+            blocksBullets[i] = ~0ull;
+        }
+        for (int y = 0; y < H; ++y)
+            for (int x = 0; x < W; ++x)
+                Update(x, y, grid[idx(x, y)]);
+    }
+
+    const TerrainPlanes& Planes() {
+        return CurrentLayers().planes;
+    }
+
+    bool BlocksSight(int x, int y) {
+        if (!InPlanes(x, y)) return true;
+        return CurrentLayers().planes.BlocksSight(x, y);
+    }
+
+    bool BlocksBullets(int x, int y) {
+        if (!InPlanes(x, y)) return true;
+        return CurrentLayers().planes.BlocksBullets(x, y);
+    }
+
+    // Zobrist key of a cell holding terrain c (splitmix64 of the pair); FREE adds nothing
+    static inline uint64_t TerrainKey(int i, Cell c) {
+        if (c == FREE) return 0;
+        uint64_t z = (((uint64_t)i << 3) | c) + 0x9E3779B97F4A7C15ull;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
     Cell Get(int x, int y) {
         if (!InBounds(x, y)) return ROCK; // treat out-of-bounds as solid
-        return grid[idx(x, y)];
+        return CurrentLayers().grid[idx(x, y)];
     }
 
     void Set(int x, int y, Cell c) {
-        if (InBounds(x, y)) grid[idx(x, y)] = c;
+        if (!InBounds(x, y)) return;
+        Layers& layers = CurrentLayers();
+        int i = idx(x, y);
+        Cell& cell = layers.grid[i];
+        if (cell == c) return;
+
+        // Remember the original terrain so BuildSecurityMap can recast rays through it
+        for (int t = 0; t < 2; ++t) {
+            if (layers.shooters[t].empty()) continue;
+            std::vector<std::pair<int, Cell>>& changes = layers.terrainChanges[t];
+            bool known = false;
+            for (const auto& change : changes) {
+                if (change.first == i) { known = true; break; }
+            }
+            if (!known) changes.push_back({ i, cell });
+        }
+        uint64_t change = TerrainKey(i, cell) ^ TerrainKey(i, c);
+        layers.terrainHash ^= change;
+        layers.regionHash[y / REGION_SIZE][x / REGION_SIZE] ^= change;
+        ++layers.regionVersion[0][y / REGION_SIZE][x / REGION_SIZE];
+        ++layers.regionVersion[1][y / REGION_SIZE][x / REGION_SIZE];
+        cell = c;
+        layers.planes.Update(x, y, c);
+    }
+
+    uint64_t GetTerrainHash() {
+        return CurrentLayers().terrainHash;
+    }
+
+    uint64_t GetRegionHash(int rx, int ry) {
+        return CurrentLayers().regionHash[ry][rx];
+    }
+
+    unsigned int GetRegionVersion(int rx, int ry, TeamId team) {
+        return CurrentLayers().regionVersion[TeamIndex(team)][ry][rx];
+    }
+
+    unsigned int GetSecurityVersion(TeamId team) {
+        return CurrentLayers().securityVersion[TeamIndex(team)];
     }
 
     // Characters can walk through FREE or TREE (per your spec),
     // cannot walk through ROCK, WATER, WAREHOUSE.
     bool IsWalkable(int x, int y) {
-        Cell c = Get(x, y);
-        return (c == FREE || c == TREE);
+        if (!InPlanes(x, y)) return false;
+        return CurrentLayers().planes.Walkable(x, y);
     }
 
     bool IsOccupied(int x, int y, int ignoreNpcId) {
+        Layers& layers = CurrentLayers();
         if (!InBounds(x, y)) return false;
-        int occ = occupancy[idx(x, y)];
+        int occ = layers.occupancy[idx(x, y)];
         if (occ == 0) return false;
         if (ignoreNpcId >= 0 && occ == ignoreNpcId) return false;
         return true;
     }
 
     void SetOccupied(int x, int y, int byNpcId) {
+        Layers& layers = CurrentLayers();
         if (!InBounds(x, y) || byNpcId <= 0) return;
-        int& occ = occupancy[idx(x, y)];
+        int& occ = layers.occupancy[idx(x, y)];
         if (occ == byNpcId) return;
         if (occ == 0) {
             occ = byNpcId;
@@ -79,8 +178,9 @@ namespace Map {
     }
 
     void ClearOccupied(int x, int y, int byNpcId) {
+        Layers& layers = CurrentLayers();
         if (!InBounds(x, y) || byNpcId <= 0) return;
-        int& occ = occupancy[idx(x, y)];
+        int& occ = layers.occupancy[idx(x, y)];
         if (occ == byNpcId) {
             occ = 0;
         }
@@ -92,10 +192,11 @@ namespace Map {
 
     double GetDynamicCost(int x, int y) {
         if (!InBounds(x, y)) return 0.0;
-        return dynamicCost[y][x];
+        return (double)CurrentLayers().dynamicCost[y][x];
     }
 
     void AddDynamicCost(int centerX, int centerY, int radius, double extra) {
+        Layers& layers = CurrentLayers();
         if (radius <= 0 || extra <= 0.0) return;
         for (int dy = -radius; dy <= radius; ++dy) {
             for (int dx = -radius; dx <= radius; ++dx) {
@@ -104,20 +205,38 @@ namespace Map {
                 if (!InBounds(nx, ny)) continue;
                 double dist2 = static_cast<double>(dx * dx + dy * dy);
                 if (dist2 > (radius * radius)) continue;
-                dynamicCost[ny][nx] = std::min(20.0, dynamicCost[ny][nx] + extra);
+                layers.dynamicCost[ny][nx] = (CostCell)std::min(20.0, layers.dynamicCost[ny][nx] + extra);
+            }
+        }
+
+        int rx0 = std::max(0, centerX - radius) / REGION_SIZE;
+        int rx1 = std::min(W - 1, centerX + radius) / REGION_SIZE;
+        int ry0 = std::max(0, centerY - radius) / REGION_SIZE;
+        int ry1 = std::min(H - 1, centerY + radius) / REGION_SIZE;
+        for (int ry = ry0; ry <= ry1; ++ry) {
+            for (int rx = rx0; rx <= rx1; ++rx) {
+                ++layers.regionVersion[0][ry][rx];
+                ++layers.regionVersion[1][ry][rx];
             }
         }
     }
 
     void DecayDynamicCosts(double decayFactor) {
+        Layers& layers = CurrentLayers();
         if (decayFactor < 0.0) decayFactor = 0.0;
         if (decayFactor > 1.0) decayFactor = 1.0;
+        Kernels::Decay(&layers.dynamicCost[0][0], W * H, (CostCell)decayFactor, (CostCell)0.01);
+    }
+
+    void MarkCostlyCells(uint64_t* plane, int ignoreNpcId, const TeamId* team) {
+        Layers& layers = CurrentLayers();
         for (int y = 0; y < H; ++y) {
             for (int x = 0; x < W; ++x) {
-                dynamicCost[y][x] *= decayFactor;
-                if (dynamicCost[y][x] < 0.01) {
-                    dynamicCost[y][x] = 0.0;
-                }
+                int occ = layers.occupancy[idx(x, y)];
+                bool occupied = occ != 0 && !(ignoreNpcId >= 0 && occ == ignoreNpcId);
+                bool costly = occupied || layers.dynamicCost[y][x] != 0.0 ||
+                    (team && layers.securityMaps[TeamIndex(*team)][y][x] != 0.0);
+                if (costly) SetBit(plane, x, y, true);
             }
         }
     }
@@ -146,6 +265,7 @@ namespace Map {
         std::vector<char> visited(W * H, 0);
         auto indexOf = [](int px, int py) { return py * W + px; };
 
+        const TerrainPlanes& planes = CurrentLayers().planes;
         q.push({ x, y, 0 });
         visited[indexOf(x, y)] = 1;
 
@@ -160,7 +280,7 @@ namespace Map {
 
             if (cur.dist > radius) continue;
 
-            if (IsWalkable(cur.x, cur.y) &&
+            if (planes.Walkable(cur.x, cur.y) &&
                 !IsOccupied(cur.x, cur.y, self ? self->GetId() : -1)) {
                 outX = cur.x;
                 outY = cur.y;
@@ -271,14 +391,18 @@ namespace Map {
 
     // Trees, Rocks, Warehouses block; Water does NOT block.
     bool IsLineOfSightClear(int x1, int y1, int x2, int y2) {
+        // The line moves one cell per step and the padded border blocks,
+        // so it can never leave the planes once it starts inside them
+        if (!InPlanes(x1, y1)) return false;
+        const TerrainPlanes& planes = CurrentLayers().planes;
+
         int dx = std::abs(x2 - x1), dy = std::abs(y2 - y1);
         int sx = (x1 < x2) ? 1 : -1;
         int sy = (y1 < y2) ? 1 : -1;
         int err = dx - dy;
 
         while (true) {
-            Cell c = Get(x1, y1);
-            if (c == ROCK || c == TREE || c == WAREHOUSE) return false;
+            if (planes.BlocksSight(x1, y1)) return false;
             if (x1 == x2 && y1 == y2) break;
             int e2 = 2 * err;
             if (e2 > -dy) { err -= dy; x1 += sx; }
@@ -289,154 +413,203 @@ namespace Map {
 
     // Security map (danger heatmap)
     void ResetSecurityMaps() {
-        for (int t = 0; t < 2; ++t)
-            for (int y = 0; y < H; ++y)
-                for (int x = 0; x < W; ++x)
-                    securityMaps[t][y][x] = 0.0;
+        Layers& layers = CurrentLayers();
+        for (int t = 0; t < 2; ++t) {
+            Kernels::Zero(&layers.securityMaps[t][0][0], W * H);
+            Kernels::Zero(&layers.securityUnits[t][0][0], W * H);
+            layers.shooters[t].clear();
+            layers.transientRisk[t].clear();
+            layers.terrainChanges[t].clear();
+            ++layers.securityVersion[t];
+            for (int ry = 0; ry < REGIONS_Y; ++ry) {
+                for (int rx = 0; rx < REGIONS_X; ++rx) {
+                    ++layers.regionVersion[t][ry][rx];
+                    layers.securityDrift[t][ry][rx] = 0;
+                }
+            }
+        }
     }
 
-    // Casts multiple rays from an enemy and accumulates danger values.
-    static void AddRaycastFromShooterInternal(int sx, int sy, int numRays, int fireRange, double increment,
-        double(*securityMapTeam)[W])
-    {
-        double startX = sx + 0.5;
-        double startY = sy + 0.5;
+    // Danger units per ray hit: 2 = open ground, 3 = tree/warehouse, 4 = rock (x SECURITY_UNIT)
+    static const int RISK_UNITS_OPEN = 2;
+    static const int RISK_UNITS_SOFT_COVER = 3;
+    static const int RISK_UNITS_HARD_COVER = 4;
+    static const int SHOOTER_RANGE = 35;   // tweakable; rays come from RayTable::Standard()
 
-        for (int r = 0; r < numRays; ++r) {
-            double ang = (2.0 * M_PI * r) / (double)numRays;
-            double dx = std::cos(ang);
-            double dy = std::sin(ang);
+    // Casts the table rays from a shooter and records the cells they hit.
+    static void CastShooterFootprint(int sx, int sy, const RayTable& rays, int fireRange, ShooterFootprint& fp)
+    {
+        const std::vector<Cell>& grid = CurrentLayers().grid;
+        fp.cellX = sx;
+        fp.cellY = sy;
+        fp.cells.clear();
 
-            double fx = startX;
-            double fy = startY;
+        for (int r = 0; r < rays.NumRays(); ++r) {
+            const unsigned char* cols = rays.Columns(sx, r);
+            const unsigned char* rows = rays.Rows(sy, r);
+            int steps = std::min(fireRange, rays.StepsInBounds(sx, sy, r));
 
-            for (int step = 0; step < fireRange; ++step) {
-                fx += dx;
-                fy += dy;
-                int tx = (int)std::floor(fx);
-                int ty = (int)std::floor(fy);
-                if (!InBounds(tx, ty)) break;
+            for (int step = 0; step < steps; ++step) {
+                int tx = cols[step];
+                int ty = rows[step];
 
-                Cell c = Get(tx, ty);
+                Cell c = grid[idx(tx, ty)];
 
                 // ROCK: stop ray; mark strong danger on that cell
                 if (c == ROCK) {
-                    securityMapTeam[ty][tx] = std::min(1.0, securityMapTeam[ty][tx] + increment * 2.0);
+                    fp.cells.push_back({ idx(tx, ty), RISK_UNITS_HARD_COVER });
                     break;
                 }
 
                 // TREE or WAREHOUSE: stop ray; mark medium danger
                 if (c == TREE || c == WAREHOUSE) {
-                    securityMapTeam[ty][tx] = std::min(1.0, securityMapTeam[ty][tx] + increment * 1.5);
+                    fp.cells.push_back({ idx(tx, ty), RISK_UNITS_SOFT_COVER });
                     break;
                 }
 
                 // WATER & FREE: bullets pass; accumulate normal danger
-                securityMapTeam[ty][tx] = std::min(1.0, securityMapTeam[ty][tx] + increment);
+                fp.cells.push_back({ idx(tx, ty), RISK_UNITS_OPEN });
             }
         }
     }
 
-    // Public API: keep your header signature.
-    void AddFireRiskFromEnemy(int ex, int ey, int fireRange, TeamId targetTeam) {
-        // reasonable defaults aligned with the lecturer's demo feel
-        const int numRays = 72;
-        const double increment = 0.02;
-        if (!InBounds(ex, ey)) return;
-        double(*teamMap)[W] = securityMaps[TeamIndex(targetTeam)];
-        AddRaycastFromShooterInternal(ex, ey, numRays, fireRange, increment, teamMap);
+    // Danger value <-> stored heatmap cell
+#if MAP_COMPACT_LAYERS
+    static inline double SecurityValue(SecurityCell cell)
+    {
+        return cell * (1.0 / SECURITY_FIXED_ONE);
+    }
+
+    static inline SecurityCell ToSecurityCell(double danger)
+    {
+        return (SecurityCell)std::lround(std::min(1.0, std::max(0.0, danger)) * SECURITY_FIXED_ONE);
+    }
+#else
+    static inline double SecurityValue(SecurityCell cell) { return cell; }
+    static inline SecurityCell ToSecurityCell(double danger) { return std::min(1.0, danger); }
+#endif
+
+    static inline void RefreshSecurityCell(Layers& layers, size_t team, int i)
+    {
+        int x = i % W;
+        int y = i / W;
+        layers.securityMaps[team][y][x] = ToSecurityCell(layers.securityUnits[team][y][x] * SECURITY_UNIT);
+    }
+
+    // Adds (sign = +1) or removes (sign = -1) a cached footprint from a team's map
+    static void ApplyFootprint(Layers& layers, size_t team, const ShooterFootprint& fp, int sign)
+    {
+        for (const auto& cell : fp.cells) {
+            int x = cell.first % W;
+            int y = cell.first / W;
+            layers.securityUnits[team][y][x] += sign * cell.second;
+            RefreshSecurityCell(layers, team, cell.first);
+
+            int& drift = layers.securityDrift[team][y / REGION_SIZE][x / REGION_SIZE];
+            drift += cell.second;
+            if (drift >= SECURITY_DRIFT_UNITS) {
+                drift = 0;
+                ++layers.regionVersion[team][y / REGION_SIZE][x / REGION_SIZE];
+            }
+        }
     }
 
     void AddFireRiskAt(int ex, int ey, TeamId targetTeam, double increment) {
+        Layers& layers = CurrentLayers();
         if (!InBounds(ex, ey)) return;
-        double(*teamMap)[W] = securityMaps[TeamIndex(targetTeam)];
-        teamMap[ey][ex] = std::min(1.0, teamMap[ey][ex] + increment);
+        size_t team = TeamIndex(targetTeam);
+        SecurityCell& cell = layers.securityMaps[team][ey][ex];
+        cell = ToSecurityCell(SecurityValue(cell) + increment);
+        layers.transientRisk[team].push_back(idx(ex, ey));
     }
 
     void BuildSecurityMap(const std::vector<NPC*>& enemies, TeamId targetTeam) {
-        const int defaultRange = 35; // tweakable
+        Layers& layers = CurrentLayers();
+        size_t team = TeamIndex(targetTeam);
+        std::vector<ShooterFootprint>& shooters = layers.shooters[team];
+
+        // Transient bullet risk only lasts until the next build
+        for (int i : layers.transientRisk[team]) {
+            RefreshSecurityCell(layers, team, i);
+        }
+        layers.transientRisk[team].clear();
+
+        // Terrain that really differs from what the cached rays saw
+        std::vector<int> changedCells;
+        for (const auto& change : layers.terrainChanges[team]) {
+            if (layers.grid[change.first] != change.second) changedCells.push_back(change.first);
+        }
+        layers.terrainChanges[team].clear();
+
+        // Enemies by AgentTable slot, so each footprint finds its shooter directly
+        std::vector<NPC*> bySlot;
+        for (NPC* e : enemies) {
+            if (!e) continue;
+            if (e->GetSlot() >= (int)bySlot.size()) bySlot.resize(e->GetSlot() + 1, nullptr);
+            bySlot[e->GetSlot()] = e;
+        }
+        std::vector<char> hasFootprint(bySlot.size(), 0);
+
+        auto findShooter = [&bySlot](const ShooterFootprint& fp) -> NPC* {
+            if (fp.slot < 0 || fp.slot >= (int)bySlot.size()) return nullptr;
+            NPC* e = bySlot[fp.slot];
+            return (e && e->GetId() == fp.npcId) ? e : nullptr;
+        };
+        auto crossesChangedTerrain = [&changedCells](const ShooterFootprint& fp) {
+            for (int i : changedCells) {
+                if (std::abs(i % W - fp.cellX) <= SHOOTER_RANGE + 1 &&
+                    std::abs(i / W - fp.cellY) <= SHOOTER_RANGE + 1) return true;
+            }
+            return false;
+        };
+
+        // Drop footprints of shooters that moved, died or see different terrain
+        for (size_t k = 0; k < shooters.size();) {
+            ShooterFootprint& fp = shooters[k];
+            NPC* e = findShooter(fp);
+            bool valid = e && e->IsAlive() && e->getRole() == Role::Warrior &&
+                (int)std::floor(e->getX()) == fp.cellX &&
+                (int)std::floor(e->getY()) == fp.cellY &&
+                !crossesChangedTerrain(fp);
+            if (valid) {
+                hasFootprint[fp.slot] = 1;
+                ++k;
+                continue;
+            }
+            ApplyFootprint(layers, team, fp, -1);
+            ++layers.securityVersion[team];
+            shooters[k] = std::move(shooters.back());
+            shooters.pop_back();
+        }
+
+        // Cast footprints for shooters that have none
         for (auto e : enemies) {
             if (!e || !e->IsAlive()) continue;
             if (e->getRole() != Role::Warrior) continue;
             int sx = (int)std::floor(e->getX());
             int sy = (int)std::floor(e->getY());
             if (!InBounds(sx, sy)) continue;
-            AddFireRiskFromEnemy(sx, sy, defaultRange, targetTeam);
-        }
-    }
-
-    // White = safe (0.0), Black = dangerous (>=1.0), terrain colors preserved.
-    void DrawSecurityMap(TeamId team) {
-        double(*teamMap)[W] = securityMaps[TeamIndex(team)];
-        TeamId otherTeam = (team == TeamId::Orange) ? TeamId::Blue : TeamId::Orange;
-        double(*otherMap)[W] = securityMaps[TeamIndex(otherTeam)];
-        for (int y = 0; y < H; ++y) {
-            for (int x = 0; x < W; ++x) {
 
-                Cell c = Get(x, y);
-                if (c == ROCK) {
-                    glColor3d(1.0, 0.0, 1.0); // purple for rocks
-                }
-                else if (c == TREE) {
-                    glColor3d(0.0, 0.5, 0.0); // green for trees
-                }
-                else if (c == WATER) {
-                    glColor3d(0.3, 0.6, 0.9); // blue for water
-                }
-                else if (c == WAREHOUSE) {
-                    glColor3d(1.0, 1.0, 0.0); // yellow for warehouse
-                }
-                else {
-                    double dangerPrimary = std::min(1.0, std::max(0.0, teamMap[y][x]));
-                    double dangerSecondary = std::min(1.0, std::max(0.0, otherMap[y][x]));
-                    double combined = std::max(dangerPrimary, dangerSecondary);
-
-                    double r = 1.0 - combined;
-                    double g = 1.0 - combined;
-                    double b = 1.0 - combined;
-
-                    const double eps = 1e-5;
-                    if (dangerPrimary > dangerSecondary + eps) {
-                        if (team == TeamId::Orange) {
-                            g = std::max(0.0, g - dangerPrimary * 0.12);
-                            b = std::max(0.0, b - dangerPrimary * 0.20);
-                        }
-                        else {
-                            r = std::max(0.0, r - dangerPrimary * 0.18);
-                        }
-                    }
-                    else if (dangerSecondary > dangerPrimary + eps) {
-                        if (team == TeamId::Orange) {
-                            r = std::max(0.0, r - dangerSecondary * 0.18);
-                        }
-                        else {
-                            g = std::max(0.0, g - dangerSecondary * 0.12);
-                            b = std::max(0.0, b - dangerSecondary * 0.20);
-                        }
-                    }
-
-                    glColor3d(r, g, b);
-                }
+            if (hasFootprint[e->GetSlot()]) continue;
 
-                glBegin(GL_POLYGON);
-                glVertex2d(x, y);
-                glVertex2d(x, y + 1);
-                glVertex2d(x + 1, y + 1);
-                glVertex2d(x + 1, y);
-                glEnd();
-            }
+            ShooterFootprint fp;
+            fp.npcId = e->GetId();
+            fp.slot = e->GetSlot();
+            CastShooterFootprint(sx, sy, RayTable::Standard(), SHOOTER_RANGE, fp);
+            ApplyFootprint(layers, team, fp, +1);
+            ++layers.securityVersion[team];
+            shooters.push_back(std::move(fp));
         }
     }
 
     // Visibility map 
     void UpdateVisibilityMap(const std::vector<NPC*>& team) {
+        Layers& layers = CurrentLayers();
         // reset visibility
-        for (int y = 0; y < H; ++y)
-            for (int x = 0; x < W; ++x)
-                visibilityMap[y][x] = 0.0;
+        layers.visibilityMap.Clear();
 
         // cast short rays from each teammate
-        const int numRays = 72;
+        const RayTable& rays = RayTable::Standard();
         const int maxRange = 30;
         for (auto a : team) {
             if (!a || !a->IsAlive()) continue;
@@ -444,58 +617,44 @@ namespace Map {
             int sy = (int)std::floor(a->getY());
             if (!InBounds(sx, sy)) continue;
 
-            double startX = sx + 0.5;
-            double startY = sy + 0.5;
-
-            for (int r = 0; r < numRays; ++r) {
-                double ang = (2.0 * M_PI * r) / (double)numRays;
-                double dx = std::cos(ang);
-                double dy = std::sin(ang);
+            if (layers.visibilityBackend == VisibilityBackend::Shadowcast) {
+                CastShadowcastFov(layers.planes, sx, sy, maxRange, layers.visibilityMap);
+                continue;
+            }
 
-                double fx = startX;
-                double fy = startY;
+            for (int r = 0; r < rays.NumRays(); ++r) {
+                const unsigned char* cols = rays.Columns(sx, r);
+                const unsigned char* rows = rays.Rows(sy, r);
+                int steps = std::min(maxRange, rays.StepsInBounds(sx, sy, r));
 
-                for (int step = 0; step < maxRange; ++step) {
-                    fx += dx;
-                    fy += dy;
-                    int tx = (int)std::floor(fx);
-                    int ty = (int)std::floor(fy);
-                    if (!InBounds(tx, ty)) break;
+                for (int step = 0; step < steps; ++step) {
+                    int tx = cols[step];
+                    int ty = rows[step];
 
-                    Cell c = Get(tx, ty);
-                    visibilityMap[ty][tx] = 1.0; // mark visible
+                    layers.visibilityMap.Mark(tx, ty);
 
-                    if (c == ROCK || c == TREE || c == WAREHOUSE) break; // stop at blockers
+                    if (layers.planes.BlocksSight(tx, ty)) break; // stop at blockers
                 }
             }
         }
     }
 
-    void DrawVisibilityMap() {
-        for (int y = 0; y < H; ++y) {
-            for (int x = 0; x < W; ++x) {
-                double vis = std::min(1.0, std::max(0.0, visibilityMap[y][x]));
-                // dim background according to visibility (0=dark, 1=bright)
-                glColor3d(0.15 + 0.85 * vis, 0.15 + 0.85 * vis, 0.15 + 0.85 * vis);
-
-                glBegin(GL_POLYGON);
-                glVertex2d(x, y);
-                glVertex2d(x, y + 1);
-                glVertex2d(x + 1, y + 1);
-                glVertex2d(x + 1, y);
-                glEnd();
-            }
-        }
+    void SetVisibilityBackend(VisibilityBackend backend) {
+        CurrentLayers().visibilityBackend = backend;
+    }
+
+    VisibilityBackend GetVisibilityBackend() {
+        return CurrentLayers().visibilityBackend;
     }
 
     // Small helper if you need raw values elsewhere
     double GetSecurityValue(int y, int x, TeamId team) {
         if (!InBounds(x, y)) return 0.0;
-        return securityMaps[TeamIndex(team)][y][x];
+        return SecurityValue(CurrentLayers().securityMaps[TeamIndex(team)][y][x]);
     }
 
     double GetVisibilityValue(int y, int x) {
         if (!InBounds(x, y)) return 0.0;
-        return visibilityMap[y][x];
+        return CurrentLayers().visibilityMap.Value(x, y);
     }
 }
@@ -1,8 +1,19 @@
 #pragma once
 #include <vector>
+#include <utility>
+#include <cstdint>
 #include "Roles.h"
 
+// Compact heatmap storage: security as uint16 fixed point, visibility as a
+// bitset and dynamic cost as float (about a quarter of the memory per
+// World). Values read through the Map API keep their meaning but are
+// rounded, so a seed does not replay the same match in both modes.
+#ifndef MAP_COMPACT_LAYERS
+#define MAP_COMPACT_LAYERS 0
+#endif
+
 class NPC; // forward declaration
+struct FrameSnapshot;
 
 namespace Map {
 
@@ -20,6 +31,114 @@ namespace Map {
     static const int W = 200;
     static const int H = 100;
 
+    // Square blocks of cells with their own terrain hash (GetRegionHash)
+    static const int REGION_SIZE = 10;
+    static const int REGIONS_X = (W + REGION_SIZE - 1) / REGION_SIZE;
+    static const int REGIONS_Y = (H + REGION_SIZE - 1) / REGION_SIZE;
+
+    // Danger is accumulated in integer units so cached contributions can be
+    // subtracted exactly; the heatmap value is min(1, units * SECURITY_UNIT).
+    static const double SECURITY_UNIT = 0.01;
+
+    // Stored value of danger 1.0 with MAP_COMPACT_LAYERS (steps of 0.001)
+    static const int SECURITY_FIXED_ONE = 1000;
+
+    // Danger units a region's cells may gain or lose in total before its
+    // path version is bumped (see GetRegionVersion)
+    static const int SECURITY_DRIFT_UNITS = 20;
+
+    // Terrain property bit planes, one bit per cell, packed in 64-bit words per row.
+    // A one-cell border around the map reads as not walkable and blocking, so
+    // queries for x in [-1, W] and y in [-1, H] need no bounds check.
+    // Kept in sync with the grid by Map::Set.
+    struct TerrainPlanes {
+        static const int STRIDE = (W + 2 + 63) / 64;    // words per padded row
+        static const int WORDS = (H + 2) * STRIDE;
+
+        uint64_t walkable[WORDS] = {};        // FREE, TREE
+        uint64_t blocksSight[WORDS] = {};     // ROCK, TREE, WAREHOUSE (and the border)
+        uint64_t blocksBullets[WORDS] = {};   // ROCK, TREE, WAREHOUSE (and the border)
+
+        static int Word(int x, int y) { return (y + 1) * STRIDE + ((x + 1) >> 6); }
+        static uint64_t Bit(int x) { return 1ull << ((x + 1) & 63); }
+
+        bool Walkable(int x, int y) const { return (walkable[Word(x, y)] & Bit(x)) != 0; }
+        bool BlocksSight(int x, int y) const { return (blocksSight[Word(x, y)] & Bit(x)) != 0; }
+        bool BlocksBullets(int x, int y) const { return (blocksBullets[Word(x, y)] & Bit(x)) != 0; }
+
+        // Padded row y (y in [-1, H]); bit (x + 1) of the row is cell x
+        const uint64_t* WalkableRow(int y) const { return &walkable[(y + 1) * STRIDE]; }
+
+        // Recomputes every bit from the grid (including the border)
+        void Rebuild(const std::vector<Cell>& grid);
+        // Updates the bits of one in-bounds cell
+        void Update(int x, int y, Cell c);
+    };
+
+    // How UpdateVisibilityMap computes line of sight
+    enum class VisibilityBackend {
+        Rays,           // 72 fixed-angle rays (RayTable)
+        Shadowcast      // exact symmetric shadowcasting (MapFov.h)
+    };
+
+    // Cached danger rays of one shooter, valid while it stays on its cell
+    struct ShooterFootprint {
+        int npcId = 0;
+        int slot = -1;                          // shooter's AgentTable slot
+        int cellX = 0, cellY = 0;
+        std::vector<std::pair<int, int>> cells; // {cell index, danger units}
+    };
+
+    // Heatmap cell types (see MAP_COMPACT_LAYERS)
+#if MAP_COMPACT_LAYERS
+    typedef uint16_t SecurityCell;              // danger * SECURITY_FIXED_ONE
+    typedef float CostCell;
+#else
+    typedef double SecurityCell;
+    typedef double CostCell;
+#endif
+
+    // Cells seen by a team: one bit per cell with MAP_COMPACT_LAYERS, else 0.0 / 1.0
+    struct VisibilityGrid {
+#if MAP_COMPACT_LAYERS
+        uint64_t bits[(W * H + 63) / 64] = {};
+
+        void Mark(int x, int y) { int i = y * W + x; bits[i >> 6] |= 1ull << (i & 63); }
+        double Value(int x, int y) const { int i = y * W + x; return (double)((bits[i >> 6] >> (i & 63)) & 1); }
+#else
+        double cells[H][W] = {};
+
+        void Mark(int x, int y) { cells[y][x] = 1.0; }
+        double Value(int x, int y) const { return cells[y][x]; }
+#endif
+        void Clear();
+    };
+
+    // Storage behind the Map API; each World owns one instance
+    struct Layers {
+        std::vector<Cell> grid;                 // terrain grid
+        std::vector<int> occupancy;             // dynamic occupancy per cell (NPC id)
+        TerrainPlanes planes;                   // bit planes derived from grid
+        SecurityCell securityMaps[2][H][W] = {};    // danger heatmap per team (0=Orange,1=Blue)
+        VisibilityGrid visibilityMap;               // visibility (optional)
+        CostCell dynamicCost[H][W] = {};            // temporary inflated costs
+
+        // Incremental security map state (see BuildSecurityMap)
+        int securityUnits[2][H][W] = {};                        // sum of cached footprints
+        std::vector<ShooterFootprint> shooters[2];              // footprints per target team
+        std::vector<int> transientRisk[2];                      // cells raised by AddFireRiskAt
+        std::vector<std::pair<int, Cell>> terrainChanges[2];    // {cell index, previous cell} since last build
+
+        VisibilityBackend visibilityBackend = VisibilityBackend::Rays;  // kept across Init
+
+        // Change tracking for caches derived from the map (flow fields)
+        uint64_t terrainHash = 0;               // Zobrist hash of grid, kept by Init and Set
+        uint64_t regionHash[REGIONS_Y][REGIONS_X] = {};     // the same hash over each region
+        unsigned int securityVersion[2] = {};   // bumped when a team's footprints change
+        unsigned int regionVersion[2][REGIONS_Y][REGIONS_X] = {};   // path costs per team and region, see GetRegionVersion
+        int securityDrift[2][REGIONS_Y][REGIONS_X] = {};            // danger units changed since the last bump
+    };
+
     // Basic map operations
     void Init();
     Cell Get(int x, int y);
@@ -27,6 +146,10 @@ namespace Map {
     bool InBounds(int x, int y);
     bool IsWalkable(int x, int y);
     bool IsLineOfSightClear(int x1, int y1, int x2, int y2);
+    // Bit planes of the current map, for hot loops that test many cells
+    const TerrainPlanes& Planes();
+    bool BlocksSight(int x, int y);
+    bool BlocksBullets(int x, int y);
 
     // Drawing / shape helpers
     void StampSquare(double cx, double cy, double size, Cell c);
@@ -35,6 +158,18 @@ namespace Map {
     // Logical map builder
     void BuildLogicalMapLikeYourDrawField();
 
+    // Change tracking: equal values mean the layer has not changed since.
+    // The terrain hash follows the grid contents, so a Set that is undone
+    // later (temporary obstacles) restores the previous value.
+    uint64_t GetTerrainHash();
+    uint64_t GetRegionHash(int rx, int ry);     // region (x / REGION_SIZE, y / REGION_SIZE)
+    unsigned int GetSecurityVersion(TeamId team);
+    // Bumped when step costs inside the region may have changed for the
+    // team: terrain (Set), AddDynamicCost, a security rebuild that moved at
+    // least SECURITY_DRIFT_UNITS of danger there, or ResetSecurityMaps.
+    // Occupancy, decay and transient fire risk leave it alone.
+    unsigned int GetRegionVersion(int rx, int ry, TeamId team);
+
     // Warehouses
     struct WarehouseInfo { int ammoX, ammoY; int medX, medY; };
     WarehouseInfo GetWarehouseForTeam(TeamId t);
@@ -49,21 +184,30 @@ namespace Map {
     double GetDynamicCost(int x, int y);
     void AddDynamicCost(int centerX, int centerY, int radius, double extra);
     void DecayDynamicCosts(double decayFactor);
+    // Sets the bit (TerrainPlanes layout) of every cell a path step pays
+    // extra for: occupied by an NPC other than ignoreNpcId, raised dynamic
+    // cost, or danger on the team's security map when a team is given.
+    // Other bits of 'plane' are left as they are.
+    void MarkCostlyCells(uint64_t* plane, int ignoreNpcId, const TeamId* team = nullptr);
 
     // Security map (danger heatmap)
+    // Clears both heatmaps and drops every cached shooter footprint.
     void ResetSecurityMaps();
-    // Adds danger around a single enemy using raycasts; fireRange is in cells
-    void AddFireRiskFromEnemy(int ex, int ey, int fireRange, TeamId targetTeam);
-    // Adds small danger value at a specific cell (for bullets/grenades)
+    // Adds small danger value at a specific cell (for bullets/grenades); lasts until the next BuildSecurityMap
     void AddFireRiskAt(int ex, int ey, TeamId targetTeam, double increment = 0.001);
-    // Builds the whole security map from a list of enemies (or shooters)
+    // Brings the team's security map up to date with a list of enemies (or shooters).
+    // Only shooters that changed cell, died, or whose rays may cross changed terrain are recast.
     void BuildSecurityMap(const std::vector<NPC*>& enemies, TeamId targetTeam);
-    // Draws terrain + grayscale danger (white=safe, black=danger)
-    void DrawSecurityMap(TeamId team = TeamId::Orange);
+    // Draws terrain + grayscale danger (white=safe, black=danger) from a snapshot
+    // captured with SnapshotOptions::security; nothing otherwise
+    void DrawSecurityMap(const FrameSnapshot& snapshot, TeamId team = TeamId::Orange);
 
     // Visibility map (line of sight)
     void UpdateVisibilityMap(const std::vector<NPC*>& team);
-    void DrawVisibilityMap();
+    // Selects the algorithm used by UpdateVisibilityMap (takes effect on its next call)
+    void SetVisibilityBackend(VisibilityBackend backend);
+    VisibilityBackend GetVisibilityBackend();
+    void DrawVisibilityMap(const FrameSnapshot& snapshot);     // needs SnapshotOptions::visibility
     // Get visibility value at a cell (0.0 = not visible, 1.0 = visible)
     double GetVisibilityValue(int y, int x);
 
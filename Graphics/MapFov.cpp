@@ -0,0 +1,111 @@
+#include "MapFov.h"
+
+// Map half of the field-of-view engine: the shadowcasting backend of UpdateVisibilityMap
+
+namespace Map {
+
+    namespace {
+
+        // Slope col/depth as an exact fraction (den > 0)
+        struct Slope {
+            int num, den;
+        };
+
+        inline int FloorDiv(int a, int b)   // b > 0
+        {
+            return (a >= 0) ? a / b : -((-a + b - 1) / b);
+        }
+
+        // floor(depth * s + 1/2)
+        inline int RoundTiesUp(int depth, Slope s)
+        {
+            return FloorDiv(2 * depth * s.num + s.den, 2 * s.den);
+        }
+
+        // ceil(depth * s - 1/2)
+        inline int RoundTiesDown(int depth, Slope s)
+        {
+            return -FloorDiv(-(2 * depth * s.num - s.den), 2 * s.den);
+        }
+
+        // Slope through the left edge of tile (depth, col)
+        inline Slope TileSlope(int depth, int col)
+        {
+            return { 2 * col - 1, 2 * depth };
+        }
+
+        inline bool OnMap(int x, int y)
+        {
+            return (unsigned)x < (unsigned)W && (unsigned)y < (unsigned)H;
+        }
+
+        // One of the four cardinal quadrants (each covers two octants):
+        // cell (depth, col) maps to origin + depth * row axis + col * column axis
+        struct Quadrant {
+            int rowDx, rowDy;
+            int colDx, colDy;
+        };
+
+        static const Quadrant QUADRANTS[4] = {
+            { 0, -1, 1, 0 },    // north
+            { 1, 0, 0, 1 },     // east
+            { 0, 1, 1, 0 },     // south
+            { -1, 0, 0, 1 }     // west
+        };
+
+        struct FovScan {
+            const TerrainPlanes& planes;
+            int ox, oy;
+            Quadrant q;
+            int radius;
+            VisibilityGrid& visible;
+
+            void Scan(int depth, Slope start, Slope end) const
+            {
+                if (depth > radius) return;
+
+                int minCol = RoundTiesUp(depth, start);
+                int maxCol = RoundTiesDown(depth, end);
+                int prev = 0;   // 0 = no tile, 1 = floor, 2 = wall
+
+                int x = ox + depth * q.rowDx + minCol * q.colDx;
+                int y = oy + depth * q.rowDy + minCol * q.colDy;
+                for (int col = minCol; col <= maxCol; ++col, x += q.colDx, y += q.colDy) {
+                    bool onMap = OnMap(x, y);
+                    int tile = (!onMap || planes.BlocksSight(x, y)) ? 2 : 1;   // the map edge blocks like ROCK
+
+                    // Floor tiles are only revealed when inside the sector, which keeps sight symmetric
+                    bool symmetric =
+                        (long long)col * start.den >= (long long)depth * start.num &&
+                        (long long)col * end.den <= (long long)depth * end.num;
+                    if ((tile == 2 || symmetric) && onMap && col * col + depth * depth <= radius * radius) {
+                        visible.Mark(x, y);
+                    }
+
+                    if (prev == 2 && tile == 1) {
+                        start = TileSlope(depth, col);
+                    }
+                    if (prev == 1 && tile == 2) {
+                        Scan(depth + 1, start, TileSlope(depth, col));
+                    }
+                    prev = tile;
+                }
+
+                if (prev == 1) {
+                    Scan(depth + 1, start, end);
+                }
+            }
+        };
+    }
+
+    void CastShadowcastFov(const TerrainPlanes& planes, int ox, int oy, int radius, VisibilityGrid& visible)
+    {
+        if (!OnMap(ox, oy)) return;
+        visible.Mark(ox, oy);
+
+        for (int dir = 0; dir < 4; ++dir) {
+            FovScan scan{ planes, ox, oy, QUADRANTS[dir], radius, visible };
+            scan.Scan(1, { -1, 1 }, { 1, 1 });
+        }
+    }
+}
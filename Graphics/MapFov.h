@@ -0,0 +1,13 @@
+#pragma once
+#include "Map.h"
+
+namespace Map {
+
+    // Symmetric shadowcasting field of view (A. Ford, "Symmetric Shadowcasting").
+    // Marks every cell within 'radius' of (ox,oy) that is visible from it in 'visible'.
+    // ROCK, TREE and WAREHOUSE block sight and are marked when seen; WATER does not block.
+    // Each visible cell is visited once per quadrant, and sight is symmetric:
+    // if A sees B then B sees A.
+    // 'planes' are the terrain bit planes of the map being scanned.
+    void CastShadowcastFov(const TerrainPlanes& planes, int ox, int oy, int radius, VisibilityGrid& visible);
+}
@@ -0,0 +1,169 @@
+#include "MapKernels.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define MAP_KERNELS_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define MAP_TARGET_AVX
+#else
+#include <cpuid.h>
+#define MAP_TARGET_AVX __attribute__((target("avx")))
+#endif
+#endif
+
+namespace Map {
+namespace Kernels {
+
+#ifdef MAP_KERNELS_X86
+    static Isa DetectIsa()
+    {
+        unsigned int ecx;
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 1);
+        ecx = (unsigned int)info[2];
+#else
+        unsigned int eax, ebx, edx;
+        if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return Isa::SSE2;
+#endif
+        // AVX needs CPU support and an OS that saves the YMM registers
+        bool osxsave = (ecx & (1u << 27)) != 0;
+        bool avx = (ecx & (1u << 28)) != 0;
+        if (osxsave && avx) {
+#ifdef _MSC_VER
+            unsigned long long xcr0 = _xgetbv(0);
+#else
+            unsigned int lo, hi;
+            __asm__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+            unsigned long long xcr0 = ((unsigned long long)hi << 32) | lo;
+#endif
+            if ((xcr0 & 6) == 6) return Isa::AVX;
+        }
+        return Isa::SSE2;
+    }
+
+    static void DecaySSE2(double* values, int count, double factor, double floor)
+    {
+        const __m128d f = _mm_set1_pd(factor);
+        const __m128d lo = _mm_set1_pd(floor);
+        int i = 0;
+        for (; i + 2 <= count; i += 2) {
+            __m128d v = _mm_mul_pd(_mm_loadu_pd(values + i), f);
+            // Clear the lanes below the floor; NaN compares false and is kept
+            v = _mm_andnot_pd(_mm_cmplt_pd(v, lo), v);
+            _mm_storeu_pd(values + i, v);
+        }
+        DecayScalar(values + i, count - i, factor, floor);
+    }
+
+    static void DecaySSE2(float* values, int count, float factor, float floor)
+    {
+        const __m128 f = _mm_set1_ps(factor);
+        const __m128 lo = _mm_set1_ps(floor);
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            __m128 v = _mm_mul_ps(_mm_loadu_ps(values + i), f);
+            v = _mm_andnot_ps(_mm_cmplt_ps(v, lo), v);
+            _mm_storeu_ps(values + i, v);
+        }
+        DecayScalar(values + i, count - i, factor, floor);
+    }
+
+    MAP_TARGET_AVX static void DecayAVX(double* values, int count, double factor, double floor)
+    {
+        const __m256d f = _mm256_set1_pd(factor);
+        const __m256d lo = _mm256_set1_pd(floor);
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            __m256d v = _mm256_mul_pd(_mm256_loadu_pd(values + i), f);
+            v = _mm256_andnot_pd(_mm256_cmp_pd(v, lo, _CMP_LT_OQ), v);
+            _mm256_storeu_pd(values + i, v);
+        }
+        _mm256_zeroupper();
+        DecayScalar(values + i, count - i, factor, floor);
+    }
+
+    MAP_TARGET_AVX static void DecayAVX(float* values, int count, float factor, float floor)
+    {
+        const __m256 f = _mm256_set1_ps(factor);
+        const __m256 lo = _mm256_set1_ps(floor);
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m256 v = _mm256_mul_ps(_mm256_loadu_ps(values + i), f);
+            v = _mm256_andnot_ps(_mm256_cmp_ps(v, lo, _CMP_LT_OQ), v);
+            _mm256_storeu_ps(values + i, v);
+        }
+        _mm256_zeroupper();
+        DecayScalar(values + i, count - i, factor, floor);
+    }
+#endif
+
+    Isa Detected()
+    {
+#ifdef MAP_KERNELS_X86
+        static const Isa isa = DetectIsa();
+        return isa;
+#else
+        return Isa::Scalar;
+#endif
+    }
+
+    const char* IsaName(Isa isa)
+    {
+        switch (isa) {
+        case Isa::SSE2: return "sse2";
+        case Isa::AVX: return "avx";
+        default: return "scalar";
+        }
+    }
+
+    void DecayScalar(double* values, int count, double factor, double floor)
+    {
+        for (int i = 0; i < count; ++i) {
+            values[i] *= factor;
+            if (values[i] < floor) {
+                values[i] = 0.0;
+            }
+        }
+    }
+
+    void DecayScalar(float* values, int count, float factor, float floor)
+    {
+        for (int i = 0; i < count; ++i) {
+            values[i] *= factor;
+            if (values[i] < floor) {
+                values[i] = 0.0f;
+            }
+        }
+    }
+
+    template <typename T>
+    static void DecayWith(T* values, int count, T factor, T floor, Isa isa)
+    {
+#ifdef MAP_KERNELS_X86
+        if (isa == Isa::AVX && Detected() == Isa::AVX) {
+            DecayAVX(values, count, factor, floor);
+            return;
+        }
+        if (isa != Isa::Scalar) {
+            DecaySSE2(values, count, factor, floor);
+            return;
+        }
+#else
+        (void)isa;
+#endif
+        DecayScalar(values, count, factor, floor);
+    }
+
+    void Decay(double* values, int count, double factor, double floor, Isa isa)
+    {
+        DecayWith(values, count, factor, floor, isa);
+    }
+
+    void Decay(float* values, int count, float factor, float floor, Isa isa)
+    {
+        DecayWith(values, count, factor, floor, isa);
+    }
+}
+}
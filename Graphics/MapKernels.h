@@ -0,0 +1,41 @@
+#pragma once
+#include <cstring>
+
+namespace Map {
+
+    // ---------------------------------------------------------
+    // Kernels - passes over whole Layers grids (dynamic costs, heatmaps)
+    // Decay has SSE2 and AVX versions picked at run time from the CPU; all
+    // versions give bit-identical results, so the choice never changes a
+    // match. Clearing is a memset of the contiguous array.
+    // ---------------------------------------------------------
+    namespace Kernels {
+
+        enum class Isa { Scalar, SSE2, AVX };
+
+        // Widest instruction set this CPU and OS support (checked once)
+        Isa Detected();
+        const char* IsaName(Isa isa);
+
+        // values[i] *= factor, then values below 'floor' become 0 (NaN is kept)
+        void DecayScalar(double* values, int count, double factor, double floor);
+        void DecayScalar(float* values, int count, float factor, float floor);
+        void Decay(double* values, int count, double factor, double floor, Isa isa);
+        void Decay(float* values, int count, float factor, float floor, Isa isa);
+        inline void Decay(double* values, int count, double factor, double floor)
+        {
+            Decay(values, count, factor, floor, Detected());
+        }
+        inline void Decay(float* values, int count, float factor, float floor)
+        {
+            Decay(values, count, factor, floor, Detected());
+        }
+
+        // Sets 'count' values to zero (all-zero bits are 0 for every cell type)
+        template <typename T>
+        void Zero(T* values, int count)
+        {
+            std::memset(values, 0, sizeof(T) * count);
+        }
+    }
+}
@@ -0,0 +1,147 @@
+#include "Map.h"
+#include "Snapshot.h"
+#include <algorithm>
+#include "glut.h"
+#include "Definitions.h"
+
+// Rendering half of Map - only linked into the GLUT frontend
+
+namespace Map {
+
+    // A W x H RGB image drawn over the map as one textured quad. The
+    // texture is 256 x 128 (power of two sizes for OpenGL 1.1) and only its
+    // lower-left W x H texels are used; the image is re-uploaded each draw.
+    class GridOverlay {
+    public:
+        static const int TEX_W = 256;
+        static const int TEX_H = 128;
+        static_assert(W <= TEX_W && H <= TEX_H, "map does not fit the overlay texture");
+
+        void SetPixel(int x, int y, double r, double g, double b)
+        {
+            unsigned char* p = &pixels[(y * W + x) * 3];
+            p[0] = ToByte(r);
+            p[1] = ToByte(g);
+            p[2] = ToByte(b);
+        }
+
+        void Draw()
+        {
+            glEnable(GL_TEXTURE_2D);
+            if (texture == 0) {
+                glGenTextures(1, &texture);
+                glBindTexture(GL_TEXTURE_2D, texture);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, TEX_W, TEX_H, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+            }
+            else {
+                glBindTexture(GL_TEXTURE_2D, texture);
+            }
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, W, H, GL_RGB, GL_UNSIGNED_BYTE, pixels);
+
+            // Texel (x,y) covers cell (x,y): [x, x+1] x [y, y+1]
+            const double s = (double)W / TEX_W;
+            const double t = (double)H / TEX_H;
+            glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+            glBegin(GL_QUADS);
+            glTexCoord2d(0.0, 0.0); glVertex2d(0, 0);
+            glTexCoord2d(0.0, t);   glVertex2d(0, H);
+            glTexCoord2d(s, t);     glVertex2d(W, H);
+            glTexCoord2d(s, 0.0);   glVertex2d(W, 0);
+            glEnd();
+            glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+
+            glBindTexture(GL_TEXTURE_2D, 0);
+            glDisable(GL_TEXTURE_2D);
+        }
+
+    private:
+        static unsigned char ToByte(double v)
+        {
+            return (unsigned char)(std::min(1.0, std::max(0.0, v)) * 255.0 + 0.5);
+        }
+
+        GLuint texture = 0;
+        unsigned char pixels[W * H * 3] = {};
+    };
+
+    static GridOverlay securityOverlay;
+    static GridOverlay visibilityOverlay;
+
+    // White = safe (0.0), Black = dangerous (>=1.0), terrain colors preserved.
+    void DrawSecurityMap(const FrameSnapshot& snapshot, TeamId team) {
+        TeamId otherTeam = (team == TeamId::Orange) ? TeamId::Blue : TeamId::Orange;
+        const std::vector<float>& primary = snapshot.security[(int)team];
+        const std::vector<float>& secondary = snapshot.security[(int)otherTeam];
+        if (primary.empty() || secondary.empty() || snapshot.terrain.empty()) return;
+
+        for (int y = 0; y < H; ++y) {
+            for (int x = 0; x < W; ++x) {
+
+                Cell c = snapshot.Terrain(x, y);
+                if (c == ROCK) {
+                    securityOverlay.SetPixel(x, y, 1.0, 0.0, 1.0); // purple for rocks
+                }
+                else if (c == TREE) {
+                    securityOverlay.SetPixel(x, y, 0.0, 0.5, 0.0); // green for trees
+                }
+                else if (c == WATER) {
+                    securityOverlay.SetPixel(x, y, 0.3, 0.6, 0.9); // blue for water
+                }
+                else if (c == WAREHOUSE) {
+                    securityOverlay.SetPixel(x, y, 1.0, 1.0, 0.0); // yellow for warehouse
+                }
+                else {
+                    double dangerPrimary = std::min(1.0, std::max(0.0, (double)primary[y * W + x]));
+                    double dangerSecondary = std::min(1.0, std::max(0.0, (double)secondary[y * W + x]));
+                    double combined = std::max(dangerPrimary, dangerSecondary);
+
+                    double r = 1.0 - combined;
+                    double g = 1.0 - combined;
+                    double b = 1.0 - combined;
+
+                    const double eps = 1e-5;
+                    if (dangerPrimary > dangerSecondary + eps) {
+                        if (team == TeamId::Orange) {
+                            g = std::max(0.0, g - dangerPrimary * 0.12);
+                            b = std::max(0.0, b - dangerPrimary * 0.20);
+                        }
+                        else {
+                            r = std::max(0.0, r - dangerPrimary * 0.18);
+                        }
+                    }
+                    else if (dangerSecondary > dangerPrimary + eps) {
+                        if (team == TeamId::Orange) {
+                            r = std::max(0.0, r - dangerSecondary * 0.18);
+                        }
+                        else {
+                            g = std::max(0.0, g - dangerSecondary * 0.12);
+                            b = std::max(0.0, b - dangerSecondary * 0.20);
+                        }
+                    }
+
+                    securityOverlay.SetPixel(x, y, r, g, b);
+                }
+            }
+        }
+        securityOverlay.Draw();
+    }
+
+    void DrawVisibilityMap(const FrameSnapshot& snapshot) {
+        if (snapshot.visibility.empty()) return;
+
+        for (int y = 0; y < H; ++y) {
+            for (int x = 0; x < W; ++x) {
+                double vis = snapshot.visibility[y * W + x];
+                // dim background according to visibility (0=dark, 1=bright)
+                double level = 0.15 + 0.85 * vis;
+                visibilityOverlay.SetPixel(x, y, level, level, level);
+            }
+        }
+        visibilityOverlay.Draw();
+    }
+}
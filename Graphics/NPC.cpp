@@ -1,15 +1,16 @@
 ﻿#include "NPC.h"
-#include "glut.h"
 #include <math.h>
 #include <cmath>
-#include <stdio.h>
-#include <time.h>
+#include "Log.h"
+#include "SimClock.h"
+#include "World.h"
 #include <queue>
 #include "Map.h"
 #include "Pathfinding.h"
 #include <algorithm>
 #include "Roles.h"
-#include "GoToCover.h"
+#include "StatePool.h"
+#include "IncrementalPath.h"
 #include "GoToCombat.h"
 #include "GoToHeal.h"
 #include "GoDeliverAmmo.h"
@@ -21,26 +22,6 @@
 #include <algorithm>
 #include <limits>
 
-int NPC::nextId = 1;
-
-extern std::vector<NPC*> teamOrange;
-extern std::vector<NPC*> teamBlue;
-
-// Global list of active grenades (defined in NPC.cpp, declared in main.cpp)
-std::vector<Grenade*> activeGrenades;
-
-// Gunshot projectile handling
-struct Gunshot
-{
-    double x, y;
-    double dirX, dirY;
-    double speed;
-    double remainingDistance;
-    TeamId team;
-    int damage;
-    NPC* shooter;
-};
-
 namespace {
     inline double ClampDouble(double value, double minVal, double maxVal)
     {
@@ -50,8 +31,6 @@ namespace {
     }
 }
 
-static std::vector<Gunshot> activeGunshots;
-
 static void SpawnGunshot(NPC* shooter, NPC* target)
 {
     if (!shooter || !target) return;
@@ -62,17 +41,12 @@ static void SpawnGunshot(NPC* shooter, NPC* target)
     double dist = sqrt(dx * dx + dy * dy);
     if (dist < 1e-4) return;
 
-    Gunshot shot;
-    shot.dirX = dx / dist;
-    shot.dirY = dy / dist;
-    shot.x = shooter->getX() + shot.dirX * 0.5;
-    shot.y = shooter->getY() + shot.dirY * 0.5;
-    shot.speed = 0.8;
-    shot.remainingDistance = FIRE_RANGE;
-    shot.team = shooter->getTeam();
-    shot.damage = BULLET_DAMAGE;
-    shot.shooter = shooter;
-    activeGunshots.push_back(shot);
+    World& world = World::Current();
+    double dirX = dx / dist;
+    double dirY = dy / dist;
+    world.gunshots.Spawn(shooter->getX() + dirX * 0.5, shooter->getY() + dirY * 0.5, dirX, dirY,
+        48.0, // cells per second
+        world.params.fireRange, shooter->getTeam(), world.params.bulletDamage);
 }
 
 
@@ -80,21 +54,20 @@ static void SpawnGunshot(NPC* shooter, NPC* target)
 // Decide initial FSM state based on role
 void NPC::AssignInitialStateByRole()
 {
-    if (pCurrentState) delete pCurrentState;
 
-    switch (role)
+    switch (getRole())
     {
     case Role::Commander:
-        pCurrentState = new GoToCover();
+        pCurrentState = statePool->Acquire<GoToCover>();
         break;
     case Role::Warrior:
-        pCurrentState = new GoToCombat();
+        pCurrentState = statePool->Acquire<GoToCombat>();
         break;
     case Role::Medic:
-        pCurrentState = new GoToMedSupply();
+        pCurrentState = statePool->Acquire<GoToMedSupply>();
         break;
     case Role::Porter:
-        pCurrentState = new GoToSupply();
+        pCurrentState = statePool->Acquire<GoToSupply>();
         break;
     default:
         pCurrentState = nullptr;
@@ -102,6 +75,7 @@ void NPC::AssignInitialStateByRole()
     }
 
     pInterruptedState = nullptr;
+    ++stateEpoch;
     if (pCurrentState)
         pCurrentState->OnEnter(this);
 }
@@ -109,18 +83,19 @@ void NPC::AssignInitialStateByRole()
 
 // Constructor
 NPC::NPC(double posX, double posY, TeamId t, Role r, double sz)
-    : x(posX), y(posY),
-    targetX(posX), targetY(posY),
-    dirX(0), dirY(0),
-    isMoving(false), isEngaging(false), isDelivering(false),
+    : agents(World::Current().agents), slot(agents.Add(this, posX, posY, t, r)),
+    isEngaging(false), isDelivering(false),
     isResting(false), isLowAmmo(false),
-    id(nextId++), occupiedCellX(-1), occupiedCellY(-1), hasOccupancy(false),
+    id(World::Current().nextNpcId++),
     waitTicks(0), stuckTicks(0), lastProgressX(posX), lastProgressY(posY),
     pendingFullReplan(false), blockCounter(0),
-    team(t), role(r), size(sz)
+    size(sz)
 {
+    statePool = new StatePool();
+    planner = new Path::IncrementalPlanner();
     pCurrentState = nullptr;
     pInterruptedState = nullptr;
+    stateEpoch = 0;
     pathIndex = -1;
     ammo = 0;
     grenades = 0;
@@ -132,7 +107,6 @@ NPC::NPC(double posX, double posY, TeamId t, Role r, double sz)
     hasOrderTarget = false;
     orderTargetX = posX;
     orderTargetY = posY;
-    hp = 100;
     blockedSinceTime = 0.0;
     blockedCellX = -1;
     blockedCellY = -1;
@@ -146,7 +120,7 @@ NPC::NPC(double posX, double posY, TeamId t, Role r, double sz)
     lastEnemyReportTime = 0.0;
     UpdateOccupancy();
 
-    switch (role)
+    switch (r)
     {
     case Role::Warrior:
         maxAmmo = MAX_AMMO;
@@ -187,107 +161,78 @@ NPC::NPC(double posX, double posY, TeamId t, Role r, double sz)
 
 NPC::~NPC()
 {
-    if (hasOccupancy) {
-        Map::ClearOccupied(occupiedCellX, occupiedCellY, id);
-        hasOccupancy = false;
-    }
-    State* current = pCurrentState;
-    State* interrupted = pInterruptedState;
-    if (current) {
-        delete current;
-    }
-    if (interrupted && interrupted != current) {
-        delete interrupted;
+    World::Current().npcGrid.Remove(this);
+    World::Current().pathRequests.Cancel(this);
+    if (agents.cellX[slot] >= 0) {
+        Map::ClearOccupied(agents.cellX[slot], agents.cellY[slot], id);
+        agents.cellX[slot] = agents.cellY[slot] = -1;
     }
     pCurrentState = nullptr;
     pInterruptedState = nullptr;
-}
-
-// Draw as colored square with centered role letter
-void NPC::DrawAsSquareWithLetter() const
-{
-    TeamColor c = GetTeamColor(team);
-    glColor3d(c.r, c.g, c.b);
-    double h = size * 0.5;
-
-    // Fill
-    glBegin(GL_POLYGON);
-    glVertex2d(x - h, y - h);
-    glVertex2d(x + h, y - h);
-    glVertex2d(x + h, y + h);
-    glVertex2d(x - h, y + h);
-    glEnd();
-
-    // Outline
-    glColor3d(0, 0, 0);
-    glBegin(GL_LINE_LOOP);
-    glVertex2d(x - h, y - h);
-    glVertex2d(x + h, y - h);
-    glVertex2d(x + h, y + h);
-    glVertex2d(x - h, y + h);
-    glEnd();
-
-    // Role symbol
-    void* font = GLUT_BITMAP_HELVETICA_12;
-    double px = x - 0.5;
-    double py = y - 0.5;
-    glRasterPos2d(px, py);
-    glutBitmapCharacter(font, getSymbol());
+    delete statePool;
+    delete planner;
 }
 
 // Assign existing path for following
 void NPC::SetPath(const std::vector<std::pair<int, int>>& p)
 {
+    // A path set directly wins over any route still being searched
+    World::Current().pathRequests.Cancel(this);
     path = p;
     if (!path.empty()) {
         pathIndex = 0;
-        targetX = (double)path[pathIndex].first;
-        targetY = (double)path[pathIndex].second;
+        agents.targetX[slot] = (double)path[pathIndex].first;
+        agents.targetY[slot] = (double)path[pathIndex].second;
         setDirection();
-        isMoving = true;
+        agents.moving[slot] = true;
     }
     else {
         pathIndex = -1;
-        isMoving = false;
+        agents.moving[slot] = false;
     }
     ClearPathBlocking();
     pendingFullReplan = false;
 }
 
+bool NPC::IsAwaitingPath() const
+{
+    return World::Current().pathRequests.IsPending(this);
+}
+
 bool NPC::isBusy() const
 {
-    return isMoving || isEngaging || isDelivering;
+    return agents.moving[slot] || isEngaging || isDelivering;
 }
 
 // Compute A* path and start moving
 // Now uses FindSafePath (A* with security map)
 void NPC::GoToGrid(int gx, int gy)
 {
-    int sx = (int)(x + 0.5);
-    int sy = (int)(y + 0.5);
+    int sx = (int)(agents.x[slot] + 0.5);
+    int sy = (int)(agents.y[slot] + 0.5);
     if (sx == gx && sy == gy) {
-        printf("[INFO] [%c] already at (%d,%d), skipping path request.\n",
+        LOG_DEBUG(Path, "[%c] already at (%d,%d), skipping path request.",
             getSymbol(), gx, gy);
         path.clear();
         pathIndex = -1;
-        isMoving = false;
+        agents.moving[slot] = false;
         return;
     }
     std::vector<std::pair<int, int>> p;
 
-    printf(" [%c] Safe path request: (%d,%d) -> (%d,%d)\n", getSymbol(), sx, sy, gx, gy);
+    LOG_DEBUG(Path, "[%c] Safe path request: (%d,%d) -> (%d,%d)", getSymbol(), sx, sy, gx, gy);
 
-    if (Path::FindSafePath(sx, sy, gx, gy, team, p, 0.8, id)) {
-        printf(" [%c] SAFE path found! length = %zu\n", getSymbol(), p.size());
+    if (Path::FindSafePath(sx, sy, gx, gy, getTeam(), p, 0.8, id)) {
+        LOG_DEBUG(Path, "[%c] SAFE path found! length = %zu", getSymbol(), p.size());
         SetPath(p);
     }
     else {
-        printf("[WARN] [%c] no safe path found. Trying regular path.\n", getSymbol());
+        LOG_DEBUG(Path, "[%c] no safe path found. Trying regular path.", getSymbol());
         if (Path::FindPath(sx, sy, gx, gy, p, id)) {
             SetPath(p);
         }
         else {
-            isMoving = false;
+            agents.moving[slot] = false;
                     path.clear();
                     pathIndex = -1;
         }
@@ -297,23 +242,25 @@ void NPC::GoToGrid(int gx, int gy)
 bool NPC::TryPlanAroundOccupiedCell(int blockedX, int blockedY, int goalX, int goalY)
 {
     if (goalX == -1 || goalY == -1) return false;
-    Map::Cell original = Map::Get(blockedX, blockedY);
-    bool modifiedCell = false;
-    if (Map::IsWalkable(blockedX, blockedY)) {
-        Map::Set(blockedX, blockedY, Map::ROCK);
-        modifiedCell = true;
-    }
 
     std::vector<std::pair<int, int>> newPath;
-    int sx = (int)(x + 0.5);
-    int sy = (int)(y + 0.5);
-    bool success =
-        Path::FindSafePath(sx, sy, goalX, goalY, team, newPath, 0.8, id) ||
-        Path::FindSafePath(sx, sy, goalX, goalY, team, newPath, 0.5, id) ||
-        Path::FindPath(sx, sy, goalX, goalY, newPath, id);
-
-    if (modifiedCell) {
-        Map::Set(blockedX, blockedY, original);
+    int sx = (int)(agents.x[slot] + 0.5);
+    int sy = (int)(agents.y[slot] + 0.5);
+    planner->Block(blockedX, blockedY);
+    bool success = planner->Plan(sx, sy, goalX, goalY, getTeam(), 0.8, id, newPath);
+
+    if (!success) {
+        // Unreachable goal: FindPath settles for a cell next to it
+        Map::Cell original = Map::Get(blockedX, blockedY);
+        bool modifiedCell = false;
+        if (Map::IsWalkable(blockedX, blockedY)) {
+            Map::Set(blockedX, blockedY, Map::ROCK);
+            modifiedCell = true;
+        }
+        success = Path::FindPath(sx, sy, goalX, goalY, newPath, id);
+        if (modifiedCell) {
+            Map::Set(blockedX, blockedY, original);
+        }
     }
 
     if (success && !newPath.empty()) {
@@ -325,8 +272,8 @@ bool NPC::TryPlanAroundOccupiedCell(int blockedX, int blockedY, int goalX, int g
 
 bool NPC::PlanShortDetour(int searchRadius)
 {
-    int startX = static_cast<int>(std::round(x));
-    int startY = static_cast<int>(std::round(y));
+    int startX = static_cast<int>(std::round(agents.x[slot]));
+    int startY = static_cast<int>(std::round(agents.y[slot]));
     if (!Map::InBounds(startX, startY))
         return false;
 
@@ -403,7 +350,7 @@ bool NPC::PlanShortDetour(int searchRadius)
         return false;
 
     NPC* commanderNPC = nullptr;
-    const std::vector<NPC*>& allies = (team == TeamId::Orange) ? teamOrange : teamBlue;
+    const std::vector<NPC*>& allies = World::Current().Team(getTeam());
     for (NPC* ally : allies) {
         if (ally && ally->IsAlive() && ally->getRole() == Role::Commander) {
             commanderNPC = ally;
@@ -444,7 +391,7 @@ bool NPC::PlanShortDetour(int searchRadius)
 
     detour.insert(detour.end(), remainder.begin(), remainder.end());
 
-    printf("[INFO] [%c] planning short detour via (%d,%d)\n",
+    LOG_DEBUG(Path, "[%c] planning short detour via (%d,%d)",
         getSymbol(), escape.first, escape.second);
     SetPath(detour);
     return true;
@@ -455,8 +402,8 @@ bool NPC::TryStepAside()
     if (pathIndex < 0 || pathIndex >= (int)path.size())
         return false;
 
-    int baseX = static_cast<int>(std::round(x));
-    int baseY = static_cast<int>(std::round(y));
+    int baseX = static_cast<int>(std::round(agents.x[slot]));
+    int baseY = static_cast<int>(std::round(agents.y[slot]));
     if (!Map::InBounds(baseX, baseY))
         return false;
 
@@ -490,7 +437,7 @@ bool NPC::TryStepAside()
         if (!Map::IsWalkable(nx, ny)) continue;
         if (Map::IsOccupied(nx, ny, id)) continue;
 
-        double security = Map::GetSecurityValue(ny, nx, team);
+        double security = Map::GetSecurityValue(ny, nx, getTeam());
         double occupancyPenalty = Map::GetOccupancyPenalty(nx, ny, id);
         double distGoal = std::abs(goal.first - nx) + std::abs(goal.second - ny);
         double score = security * 10.0 + occupancyPenalty + distGoal * 0.2;
@@ -512,7 +459,7 @@ bool NPC::TryStepAside()
         newPath.insert(newPath.end(), path.begin() + pathIndex, path.end());
     }
 
-    printf("[INFO] [%c] stepping aside to (%d,%d)\n", getSymbol(), bestX, bestY);
+    LOG_DEBUG(Path, "[%c] stepping aside to (%d,%d)", getSymbol(), bestX, bestY);
     SetPath(newPath);
     return true;
 }
@@ -526,13 +473,16 @@ void NPC::ClearPathBlocking()
 
 void NPC::UpdateOccupancy()
 {
-    int cellX = static_cast<int>(std::round(x));
-    int cellY = static_cast<int>(std::round(y));
+    int cellX = static_cast<int>(std::round(agents.x[slot]));
+    int cellY = static_cast<int>(std::round(agents.y[slot]));
+    int& occupiedCellX = agents.cellX[slot];
+    int& occupiedCellY = agents.cellY[slot];
+    const bool hasOccupancy = occupiedCellX >= 0;
 
     if (!Map::InBounds(cellX, cellY)) {
         if (hasOccupancy) {
             Map::ClearOccupied(occupiedCellX, occupiedCellY, id);
-            hasOccupancy = false;
+            occupiedCellX = occupiedCellY = -1;
         }
         return;
     }
@@ -544,17 +494,25 @@ void NPC::UpdateOccupancy()
         Map::SetOccupied(cellX, cellY, id);
         occupiedCellX = cellX;
         occupiedCellY = cellY;
-        hasOccupancy = true;
     }
     else {
         Map::SetOccupied(cellX, cellY, id);
     }
+    UpdateGridEntry();
+}
+
+// Files a living NPC under its current cell and drops a dead one from the grid
+void NPC::UpdateGridEntry()
+{
+    SpatialHash& grid = World::Current().npcGrid;
+    if (IsAlive()) grid.Update(this);
+    else grid.Remove(this);
 }
 
 bool NPC::ReplanPathWithDynamicCosts()
 {
-    int startCellX = static_cast<int>(std::round(x));
-    int startCellY = static_cast<int>(std::round(y));
+    int startCellX = static_cast<int>(std::round(agents.x[slot]));
+    int startCellY = static_cast<int>(std::round(agents.y[slot]));
 
     int goalX = -1;
     int goalY = -1;
@@ -572,10 +530,11 @@ bool NPC::ReplanPathWithDynamicCosts()
     if (goalX == -1 || goalY == -1)
         return false;
 
+    // A lower security weight cannot reach a goal the planner could not,
+    // so the only fallback left is FindPath's nearby-goal search
     std::vector<std::pair<int, int>> newPath;
     bool replanned =
-        Path::FindSafePath(startCellX, startCellY, goalX, goalY, team, newPath, 0.8, id) ||
-        Path::FindSafePath(startCellX, startCellY, goalX, goalY, team, newPath, 0.5, id) ||
+        planner->Plan(startCellX, startCellY, goalX, goalY, getTeam(), 0.8, id, newPath) ||
         Path::FindPath(startCellX, startCellY, goalX, goalY, newPath, id);
 
     if (replanned && !newPath.empty()) {
@@ -589,10 +548,10 @@ bool NPC::ReplanPathWithDynamicCosts()
 // Update direction based on next waypoint
 void NPC::setDirection()
 {
-    double dx = targetX - x, dy = targetY - y;
+    double dx = agents.targetX[slot] - agents.x[slot], dy = agents.targetY[slot] - agents.y[slot];
     double L = sqrt(dx * dx + dy * dy);
-    if (L > 1e-6) { dirX = dx / L; dirY = dy / L; }
-    else { dirX = dirY = 0; }
+    if (L > 1e-6) { agents.dirX[slot] = dx / L; agents.dirY[slot] = dy / L; }
+    else { agents.dirX[slot] = agents.dirY[slot] = 0; }
 }
 
 // Handle movement along current path
@@ -600,75 +559,61 @@ void NPC::DoSomeWork()
 {
     // Dead NPCs don't do anything
     if (!IsAlive()) {
-        isMoving = false;
+        agents.moving[slot] = false;
         return;
     }
     
     // If not moving but we have a valid path, start moving to the next cell
-    if (!isMoving && pathIndex >= 0 && pathIndex < (int)path.size()) {
-        targetX = (double)path[pathIndex].first;
-        targetY = (double)path[pathIndex].second;
+    if (!agents.moving[slot] && pathIndex >= 0 && pathIndex < (int)path.size()) {
+        agents.targetX[slot] = (double)path[pathIndex].first;
+        agents.targetY[slot] = (double)path[pathIndex].second;
         setDirection();
-        isMoving = true;
+        agents.moving[slot] = true;
     }
 
     // If currently moving, calculate next step
-    if (isMoving) {
-        double nx = x + dirX * SPEED;
-        double ny = y + dirY * SPEED;
+    if (agents.moving[slot]) {
+        double step = SPEED * SimClock::Dt();
+        double nx = agents.x[slot] + agents.dirX[slot] * step;
+        double ny = agents.y[slot] + agents.dirY[slot] * step;
 
         int cx = (int)(nx + 0.5);
         int cy = (int)(ny + 0.5);
 
         bool walkable = Map::IsWalkable(cx, cy);
-        bool occupied = Map::IsOccupiedByNPC(cx, cy, teamBlue, teamOrange, this);
+        World& world = World::Current();
+        bool occupied = Map::IsOccupiedByNPC(cx, cy, world.teamBlue, world.teamOrange, this);
 
         if (walkable && !occupied)
         {
             nx = ClampDouble(nx, 1.0, static_cast<double>(Map::W - 2));
             ny = ClampDouble(ny, 1.0, static_cast<double>(Map::H - 2));
-            x = nx;
-            y = ny;
+            agents.x[slot] = nx;
+            agents.y[slot] = ny;
             UpdateOccupancy();
             setBlockCounter(0); 
         }
         else {
-            int currentCellX = (int)(x + 0.5);
-            int currentCellY = (int)(y + 0.5);
+            int currentCellX = (int)(agents.x[slot] + 0.5);
+            int currentCellY = (int)(agents.y[slot] + 0.5);
 
             if (occupied) {
-                auto findNpcAtCell = [&](int cellX, int cellY) -> NPC*
-                {
-                    const std::vector<std::vector<NPC*>*> teams = { &teamOrange, &teamBlue };
-                    for (const auto* teamVec : teams) {
-                        for (NPC* npc : *teamVec) {
-                            if (!npc || npc == this || !npc->IsAlive()) continue;
-                            int npcCellX = (int)(npc->getX() + 0.5);
-                            int npcCellY = (int)(npc->getY() + 0.5);
-                            if (npcCellX == cellX && npcCellY == cellY) {
-                                return npc;
-                            }
-                        }
-                    }
-                    return nullptr;
-                };
-
-                NPC* occupant = findNpcAtCell(cx, cy);
+                NPC* occupant = world.npcGrid.FindAtCell(cx, cy, this);
 
                 if (occupant && occupant->getIsMoving()) {
                     int occupantTargetX = (int)(occupant->getTargetX() + 0.5);
                     int occupantTargetY = (int)(occupant->getTargetY() + 0.5);
                     if (occupantTargetX == currentCellX && occupantTargetY == currentCellY) {
-                        printf(" [%c] yielding swap with %c at (%d,%d)\n",
+                        LOG_DEBUG(Path, "[%c] yielding swap with %c at (%d,%d)",
                             getSymbol(), occupant->getSymbol(), cx, cy);
-                        isMoving = false;
+                        agents.moving[slot] = false;
                         setBlockCounter(0);
                         return;
                     }
                 }
 
                 if (TryStepAside()) {
-                    printf(" [%c] sidestepped to avoid block at (%d,%d)\n",
+                    LOG_DEBUG(Path, "[%c] sidestepped to avoid block at (%d,%d)",
                         getSymbol(), cx, cy);
                     setBlockCounter(0);
                     return;
@@ -676,23 +621,33 @@ void NPC::DoSomeWork()
             }
 
             if (!walkable) {
-                printf(" [%c] terrain blockage at (%d,%d)\n", getSymbol(), cx, cy);
+                LOG_DEBUG(Path, "[%c] terrain blockage at (%d,%d)", getSymbol(), cx, cy);
             }
 
-            printf(" [%c] blocked at (%d,%d). Counter: %d\n", getSymbol(), cx, cy, getBlockCounter());
-            isMoving = false; 
+            LOG_DEBUG(Path, "[%c] blocked at (%d,%d). Counter: %d", getSymbol(), cx, cy, getBlockCounter());
+            agents.moving[slot] = false; 
             
             setBlockCounter(getBlockCounter() + 1);
+
+            // Still blocked: repair the route around the obstacle before giving up on it
+            if (getBlockCounter() == REPLAN_BLOCKED_TICKS && !path.empty()) {
+                bool replanned = occupied
+                    ? TryPlanAroundOccupiedCell(cx, cy, path.back().first, path.back().second)
+                    : ReplanPathWithDynamicCosts();
+                if (replanned) {
+                    LOG_DEBUG(Path, "[%c] replanned around block at (%d,%d)", getSymbol(), cx, cy);
+                    return;
+                }
+            }
             
             if (getBlockCounter() > 5) {
-                printf(" [%c] Persistent block detected. Clearing path and retreating to cover.\n", getSymbol());
+                LOG_INFO(Path, "[%c] Persistent block detected. Clearing path and retreating to cover.", getSymbol());
                 
                 path.clear(); 
                 pathIndex = -1;
                 setBlockCounter(0); 
                 
-                if (getCurrentState()) delete getCurrentState();
-                setCurrentState(new GoToCover());
+                setCurrentState(statePool->Acquire<GoToCover>());
                 getCurrentState()->OnEnter(this);
                 return; 
             }
@@ -700,22 +655,22 @@ void NPC::DoSomeWork()
         }
 
         // Check if target reached
-        double dx = targetX - x, dy = targetY - y;
+        double dx = agents.targetX[slot] - agents.x[slot], dy = agents.targetY[slot] - agents.y[slot];
         if (dx * dx + dy * dy < 0.25) {
-            x = targetX;
-            y = targetY;
+            agents.x[slot] = agents.targetX[slot];
+            agents.y[slot] = agents.targetY[slot];
             UpdateOccupancy();
             pathIndex++;
 
             if (pathIndex < (int)path.size()) {
-                targetX = (double)path[pathIndex].first;
-                targetY = (double)path[pathIndex].second;
+                agents.targetX[slot] = (double)path[pathIndex].first;
+                agents.targetY[slot] = (double)path[pathIndex].second;
                 setDirection();
-                isMoving = true;
+                agents.moving[slot] = true;
             }
             else {
-                printf("🟢 [%c] reached destination (%.1f, %.1f)\n", getSymbol(), x, y);
-                isMoving = false;
+                LOG_DEBUG(Path, "[%c] reached destination (%.1f, %.1f)", getSymbol(), agents.x[slot], agents.y[slot]);
+                agents.moving[slot] = false;
                 path.clear();
                 pathIndex = -1;
             }
@@ -725,17 +680,17 @@ void NPC::DoSomeWork()
 
 void NPC::MarkRetreat()
 {
-    lastRetreatTime = clock() / (double)CLOCKS_PER_SEC;
+    lastRetreatTime = SimClock::Now();
 }
 
 void NPC::MarkIdleAnchorIssued()
 {
-    lastIdleAnchorTime = clock() / (double)CLOCKS_PER_SEC;
+    lastIdleAnchorTime = SimClock::Now();
 }
 
 // Combat and status reports
 void NPC::ReportEnemySpotted(int ex, int ey) {
-    double now = clock() / (double)CLOCKS_PER_SEC;
+    double now = SimClock::Now();
     if (lastEnemyReportTime > 0.0 && (now - lastEnemyReportTime) < ENEMY_REPORT_COOLDOWN) {
         return;
     }
@@ -749,38 +704,40 @@ void NPC::ReportEnemySpotted(int ex, int ey) {
 void NPC::ReportLowAmmo() {
     if (ammo <= LOW_AMMO_THRESHOLD && !isLowAmmo) {
         isLowAmmo = true;
-        printf(" [%c] reporting low ammo! (ammo=%d)\n", getSymbol(), ammo);
+        LOG_INFO(Combat, "[%c] reporting low ammo! (ammo=%d)", getSymbol(), ammo);
         if (commander) commander->ReceiveReport(this, ReportType::LOW_AMMO);
     }
 }
 
 
 void NPC::ReportInjury() {
-    if (hp < INJURY_THRESHOLD && hp > 0) {
-        printf(" [%c] injured (hp=%d)\n", getSymbol(), hp);
+    if (agents.hp[slot] < INJURY_THRESHOLD && agents.hp[slot] > 0) {
+        LOG_INFO(Combat, "[%c] injured (hp=%d)", getSymbol(), agents.hp[slot]);
         if (commander) commander->ReceiveReport(this, ReportType::INJURED);
     }
 }
 
 
 void NPC::TakeDamage(int dmg) {
-    double now = clock() / (double)CLOCKS_PER_SEC;
-    hp -= dmg;
-    if (hp <= 0) {
-        hp = 0;
-        isMoving = false;
+    double now = SimClock::Now();
+    agents.hp[slot] -= dmg;
+    if (agents.hp[slot] <= 0) {
+        agents.hp[slot] = 0;
+        agents.alive[slot] = 0;
+        agents.moving[slot] = false;
         path.clear();
         pathIndex = -1;
-        printf(" [%c] eliminated!\n", getSymbol());
+        UpdateGridEntry();
+        LOG_INFO(Combat, "[%c] eliminated!", getSymbol());
     }
     else {
         ReportInjury();
         hitFlashUntil = std::max(hitFlashUntil, now + 0.4);
-        if (hp < 40) {
+        if (agents.hp[slot] < 40) {
             State* current = getCurrentState();
             GoToCover* coverState = dynamic_cast<GoToCover*>(current);
             if (!coverState) {
-                setCurrentState(new GoToCover());
+                setCurrentState(statePool->Acquire<GoToCover>());
                 MarkRetreat();
                 hitFlashUntil = std::max(hitFlashUntil, now + 0.6);
                 if (getCurrentState()) {
@@ -791,31 +748,39 @@ void NPC::TakeDamage(int dmg) {
     }
 }
 
+void NPC::setHP(int h) {
+    agents.hp[slot] = h;
+    agents.alive[slot] = h > 0;
+    UpdateGridEntry();
+}
+
 void NPC::HealSelf(int amount) {
-    hp = std::min(100, hp + amount);
-    printf(" [%c] healed to %d HP\n", getSymbol(), hp);
+    agents.hp[slot] = std::min(100, agents.hp[slot] + amount);
+    agents.alive[slot] = agents.hp[slot] > 0;
+    UpdateGridEntry();
+    LOG_INFO(Combat, "[%c] healed to %d HP", getSymbol(), agents.hp[slot]);
 }
 
 // Combat helpers
 bool NPC::InRange(NPC* target, double range) const {
-    double dx = target->getX() - x;
-    double dy = target->getY() - y;
+    double dx = target->getX() - agents.x[slot];
+    double dy = target->getY() - agents.y[slot];
     return (dx * dx + dy * dy) <= (range * range);
 }
 
 bool NPC::CanSee(NPC* target) const {
-    return Map::IsLineOfSightClear((int)x, (int)y, (int)target->getX(), (int)target->getY());
+    return Map::IsLineOfSightClear((int)agents.x[slot], (int)agents.y[slot], (int)target->getX(), (int)target->getY());
 }
 
 void NPC::Shoot(NPC* target) {
     if (!CanShoot()) return;   // Only warriors with ammo can shoot
     if (!target || !target->IsAlive()) return;
-    if (!InRange(target, FIRE_RANGE)) return;
+    if (!InRange(target, World::Current().params.fireRange)) return;
     if (!CanSee(target)) return;
 
     decreaseAmmo();
     SpawnGunshot(this, target);
-    printf(" [%c] fired at %c! Ammo left: %d\n", getSymbol(), target->getSymbol(), ammo);
+    LOG_DEBUG(Combat, "[%c] fired at %c! Ammo left: %d", getSymbol(), target->getSymbol(), ammo);
     
     // Check if ammo is low
     if (ammo <= LOW_AMMO_THRESHOLD) {
@@ -825,52 +790,51 @@ void NPC::Shoot(NPC* target) {
 }
 
 void NPC::ThrowGrenade(double targetX, double targetY) {
-    if (role != Role::Warrior) {
-        printf("[WARN] [%c] attempt to throw grenade blocked (role %d).\n", getSymbol(), (int)role);
+    if (getRole() != Role::Warrior) {
+        LOG_WARN(Combat, "[%c] attempt to throw grenade blocked (role %d).", getSymbol(), (int)getRole());
         return;
     }
     if (!CanThrowGrenade()) {
-        printf("[WARN] [%c] cannot throw grenades (insufficient grenades).\n", getSymbol());
+        LOG_WARN(Combat, "[%c] cannot throw grenades (insufficient grenades).", getSymbol());
         return;
     }
     
     // Check if in range
-    double dx = targetX - x;
-    double dy = targetY - y;
+    double dx = targetX - agents.x[slot];
+    double dy = targetY - agents.y[slot];
     double dist2 = dx * dx + dy * dy;
     if (dist2 > GRENADE_RANGE * GRENADE_RANGE) return;
     
-    printf("[INFO] %c invoking ThrowGrenade (role=%d, grenades=%d) target=(%.1f, %.1f)\n",
-        getSymbol(), (int)role, grenades, targetX, targetY);
+    LOG_DEBUG(Combat, "%c invoking ThrowGrenade (role=%d, grenades=%d) target=(%.1f, %.1f)",
+        getSymbol(), (int)getRole(), grenades, targetX, targetY);
     decreaseGrenades();
-    if (role == Role::Warrior) {
+    if (getRole() == Role::Warrior) {
         supply = grenades;
     }
     
     // Create grenade at target position
     Grenade* grenade = new Grenade(targetX, targetY);
     grenade->SetIsExploding(true);
-    activeGrenades.push_back(grenade);
+    World::Current().activeGrenades.push_back(grenade);
     
-    printf("[GRENADE] [%c] threw grenade at (%.1f, %.1f)!\n", getSymbol(), targetX, targetY);
+    LOG_INFO(Combat, "[%c] threw grenade at (%.1f, %.1f)!", getSymbol(), targetX, targetY);
     
     // Damage enemies hit by grenade bullets
-    extern std::vector<NPC*> teamOrange;
-    extern std::vector<NPC*> teamBlue;
-    const std::vector<NPC*>& enemies = (team == TeamId::Orange) ? teamBlue : teamOrange;
-    
+    const double maxRadius = 36.0; // 6 cells radius squared
+    std::vector<NPC*> enemies;
+    World::Current().npcGrid.QueryRadius(EnemyOf(getTeam()), targetX, targetY, 6.0, enemies);
+
     for (NPC* enemy : enemies) {
         if (!enemy || !enemy->IsAlive()) continue;
         double ex = enemy->getX();
         double ey = enemy->getY();
         double dist2 = (ex - targetX) * (ex - targetX) + (ey - targetY) * (ey - targetY);
-        const double maxRadius = 36.0; // 6 cells radius squared
         if (dist2 <= maxRadius) {
             double dist = sqrt(dist2);
             double factor = std::max(0.0, 1.0 - (dist / 6.0));
-            int damage = std::max(1, (int)std::round(GRENADE_DAMAGE * factor));
+            int damage = std::max(1, (int)std::round(World::Current().params.grenadeDamage * factor));
             enemy->TakeDamage(damage);
-            printf("[EXPLOSION] Grenade hit %c! Damage=%d HP: %d\n", enemy->getSymbol(), damage, enemy->getHP());
+            LOG_INFO(Combat, "Grenade hit %c! Damage=%d HP: %d", enemy->getSymbol(), damage, enemy->getHP());
         }
     }
 }
@@ -879,7 +843,7 @@ void NPC::Reload(int amount) {
     if (maxAmmo <= 0) return;
     ammo += amount;
     if (ammo > maxAmmo) ammo = maxAmmo;
-    printf(" [%c] reloaded -> ammo = %d\n", getSymbol(), ammo);
+    LOG_INFO(Combat, "[%c] reloaded -> ammo = %d", getSymbol(), ammo);
     if (ammo > LOW_AMMO_THRESHOLD) {
         setLowAmmo(false);
     }
@@ -889,256 +853,29 @@ void NPC::RefillAmmo() {
     if (maxAmmo <= 0) return;
     ammo = maxAmmo;
     setLowAmmo(false);
-    printf(" [%c] ammo refilled -> ammo = %d\n", getSymbol(), ammo);
-    if (role == Role::Warrior) {
+    LOG_INFO(Combat, "[%c] ammo refilled -> ammo = %d", getSymbol(), ammo);
+    if (getRole() == Role::Warrior) {
         grenades = MAX_GRENADES;
         supply = maxSupply;
-        printf(" [%c] grenades restocked -> grenades = %d\n", getSymbol(), grenades);
+        LOG_INFO(Combat, "[%c] grenades restocked -> grenades = %d", getSymbol(), grenades);
     }
 }
 
 bool NPC::NeedsAmmo() const {
-    if (role != Role::Warrior) return false;
+    if (getRole() != Role::Warrior) return false;
     return ammo <= LOW_AMMO_THRESHOLD;
 }
 
 void NPC::RegisterAssistCompletion() {
-    if (role == Role::Medic || role == Role::Porter) {
+    if (getRole() == Role::Medic || getRole() == Role::Porter) {
         assistsDone = std::min(assistsDone + 1, ASSIST_LIMIT);
     }
 }
 
-// Draw HP bar above the NPC
-void NPC::DrawHPBar(bool placeAbove) const
-{
-    double barWidth = size * 1.5;
-    double barHeight = 0.9;
-    double barX = x - barWidth / 2.0;
-    double offset = placeAbove ? -(size + 1.8) : (size + 1.8);
-    double barY = y + offset;
-    
-    // Background grey
-    glColor3d(0.2, 0.2, 0.2);
-    glBegin(GL_POLYGON);
-    glVertex2d(barX, barY);
-    glVertex2d(barX + barWidth, barY);
-    glVertex2d(barX + barWidth, barY + barHeight);
-    glVertex2d(barX, barY + barHeight);
-    glEnd();
-    
-    // HP fill (light grey)
-    double hpPercent = (double)hp / 100.0;
-    double fillWidth = barWidth * hpPercent;
-    
-    glColor3d(0.75, 0.75, 0.75);
-    
-    if (fillWidth > 0) {
-        glBegin(GL_POLYGON);
-        glVertex2d(barX, barY);
-        glVertex2d(barX + fillWidth, barY);
-        glVertex2d(barX + fillWidth, barY + barHeight);
-        glVertex2d(barX, barY + barHeight);
-        glEnd();
-    }
-    
-    // Border
-    glColor3d(0.0, 0.0, 0.0);
-    glLineWidth(1.0);
-    glBegin(GL_LINE_LOOP);
-    glVertex2d(barX, barY);
-    glVertex2d(barX + barWidth, barY);
-    glVertex2d(barX + barWidth, barY + barHeight);
-    glVertex2d(barX, barY + barHeight);
-    glEnd();
-    
-    // HP text with percentage (to the right of the bar)
-    void* font = GLUT_BITMAP_HELVETICA_10;
-    
-    char hpStr[16];
-    sprintf_s(hpStr, sizeof(hpStr), "HP:%d%%", hp);
-    
-    // Calculate text position (centered)
-    double textX = barX + barWidth + 1.0;
-    double textY = barY + barHeight / 2.0 - 0.12;
-    
-    // White text for better visibility
-    glColor3d(1.0, 1.0, 1.0);
-    glRasterPos2d(textX, textY);
-    for (const char* c = hpStr; *c != '\0'; c++) {
-        glutBitmapCharacter(font, *c);
-    }
-}
-
-void NPC::DrawAmmoBar(bool placeAbove) const
-{
-    if (maxAmmo <= 0) return;
-
-    double percent = 0.0;
-    if (maxAmmo > 0) {
-        double ratio = ammo / (double)maxAmmo;
-        percent = std::max(0.0, std::min(1.0, ratio));
-    }
-    double barWidth = size * 1.5;
-    double barHeight = 0.65;
-    double barX = x - barWidth / 2.0;
-    double offset = placeAbove ? -(size + 3.0) : (size + 3.0);
-    double barY = y + offset;
-
-    glColor3d(0.2, 0.2, 0.2); // grey background
-    glBegin(GL_POLYGON);
-    glVertex2d(barX, barY);
-    glVertex2d(barX + barWidth, barY);
-    glVertex2d(barX + barWidth, barY + barHeight);
-    glVertex2d(barX, barY + barHeight);
-    glEnd();
-
-    glColor3d(0.75, 0.75, 0.75); // light grey fill
-    if (percent > 0) {
-        glBegin(GL_POLYGON);
-        glVertex2d(barX, barY);
-        glVertex2d(barX + barWidth * percent, barY);
-        glVertex2d(barX + barWidth * percent, barY + barHeight);
-        glVertex2d(barX, barY + barHeight);
-        glEnd();
-    }
-
-    glColor3d(0.0, 0.0, 0.0);
-    glBegin(GL_LINE_LOOP);
-    glVertex2d(barX, barY);
-    glVertex2d(barX + barWidth, barY);
-    glVertex2d(barX + barWidth, barY + barHeight);
-    glVertex2d(barX, barY + barHeight);
-    glEnd();
-
-    // Ammo label and values
-    void* font = GLUT_BITMAP_HELVETICA_10;
-    char ammoStr[32];
-    sprintf_s(ammoStr, sizeof(ammoStr), "A:%d/%d", ammo, maxAmmo);
-    glColor3d(1.0, 1.0, 1.0);
-    double textX = barX + barWidth + 1.0;
-    double textY = barY + barHeight / 2.0 - 0.1;
-    glRasterPos2d(textX, textY);
-    for (const char* c = ammoStr; *c != '\0'; ++c) {
-        glutBitmapCharacter(font, *c);
-    }
-}
-
-void NPC::DrawSupplyBar(bool placeAbove) const
-{
-    int current = 0;
-    int maxValue = 0;
-
-    if (role == Role::Warrior) {
-        current = grenades;
-        maxValue = MAX_GRENADES;
-    }
-    else {
-        maxValue = maxSupply;
-        current = supply;
-    }
-
-    if (maxValue <= 0) return;
-
-    double ratio = (maxValue > 0) ? current / (double)maxValue : 0.0;
-    double percent = std::max(0.0, std::min(1.0, ratio));
-    double barWidth = size * 1.5;
-    double barHeight = 0.65;
-    double barX = x - barWidth / 2.0;
-    double offset = placeAbove ? -(size + 4.2) : (size + 4.2);
-    double barY = y + offset;
-
-    glColor3d(0.2, 0.2, 0.2); // grey background
-    glBegin(GL_POLYGON);
-    glVertex2d(barX, barY);
-    glVertex2d(barX + barWidth, barY);
-    glVertex2d(barX + barWidth, barY + barHeight);
-    glVertex2d(barX, barY + barHeight);
-    glEnd();
-
-    glColor3d(0.75, 0.75, 0.75); // light grey fill
-    if (percent > 0) {
-        glBegin(GL_POLYGON);
-        glVertex2d(barX, barY);
-        glVertex2d(barX + barWidth * percent, barY);
-        glVertex2d(barX + barWidth * percent, barY + barHeight);
-        glVertex2d(barX, barY + barHeight);
-        glEnd();
-    }
-
-    glColor3d(0.0, 0.0, 0.0);
-    glBegin(GL_LINE_LOOP);
-    glVertex2d(barX, barY);
-    glVertex2d(barX + barWidth, barY);
-    glVertex2d(barX + barWidth, barY + barHeight);
-    glVertex2d(barX, barY + barHeight);
-    glEnd();
-
-    // Supply / grenade label and values
-    const char* label = "Supply";
-    if (role == Role::Warrior) label = "Grenades";
-    else if (role == Role::Medic) label = "Medkit";
-    else if (role == Role::Porter) label = "Crate";
-
-    void* font = GLUT_BITMAP_HELVETICA_10;
-    char supplyStr[40];
-    if ((role == Role::Porter || role == Role::Medic) && maxValue <= 1) {
-        const char* status = (current > 0) ? "Ready" : "Empty";
-        sprintf_s(supplyStr, sizeof(supplyStr), "%c:%s", label[0], status);
-    } else {
-        sprintf_s(supplyStr, sizeof(supplyStr), "%c:%d/%d", label[0], current, maxValue);
-    }
-    glColor3d(1.0, 1.0, 1.0);
-    double textX = barX + barWidth + 1.0;
-    double textY = barY + barHeight / 2.0 - 0.1;
-    glRasterPos2d(textX, textY);
-    for (const char* c = supplyStr; *c != '\0'; ++c) {
-        glutBitmapCharacter(font, *c);
-    }
-}
-
-void NPC::DrawDeadMarker() const
-{
-    double h = size * 0.5;
-    glColor3d(0.3, 0.3, 0.3);
-    glBegin(GL_POLYGON);
-    glVertex2d(x - h, y - h);
-    glVertex2d(x + h, y - h);
-    glVertex2d(x + h, y + h);
-    glVertex2d(x - h, y + h);
-    glEnd();
-
-    glColor3d(0.0, 0.0, 0.0);
-    glBegin(GL_LINES);
-    glVertex2d(x - h, y - h);
-    glVertex2d(x + h, y + h);
-    glVertex2d(x - h, y + h);
-    glVertex2d(x + h, y - h);
-    glEnd();
-}
-
-void NPC::DrawStatusBars() const
-{
-    bool placeAbove = y > 12.0;
-    DrawHPBar(placeAbove);
-
-    switch (role) {
-    case Role::Warrior:
-        DrawAmmoBar(placeAbove);
-        DrawSupplyBar(placeAbove);
-        break;
-    case Role::Porter:
-    case Role::Medic:
-        DrawSupplyBar(placeAbove);
-        break;
-    default:
-        break;
-    }
-}
-
 double NPC::getMoveSpeed() const
 {
     double base = SPEED;
-    switch (role) {
+    switch (getRole()) {
     case Role::Medic:
         base *= 1.6;
         break;
@@ -1150,116 +887,3 @@ double NPC::getMoveSpeed() const
     }
     return base;
 }
-
-void UpdateActiveGunshots()
-{
-    for (size_t i = 0; i < activeGunshots.size(); )
-    {
-        Gunshot& shot = activeGunshots[i];
-
-        shot.x += shot.dirX * shot.speed;
-        shot.y += shot.dirY * shot.speed;
-        shot.remainingDistance -= shot.speed;
-
-        bool removeShot = false;
-
-        int cx = (int)(shot.x + 0.5);
-        int cy = (int)(shot.y + 0.5);
-
-        if (!Map::InBounds(cx, cy)) {
-            removeShot = true;
-        }
-        else {
-            Map::Cell cell = Map::Get(cx, cy);
-            if (cell == Map::ROCK || cell == Map::WAREHOUSE || cell == Map::TREE) {
-                removeShot = true;
-            }
-        }
-
-        if (!removeShot) {
-            Map::AddFireRiskAt(cx, cy, shot.team, 0.002);
-
-            std::vector<NPC*>& enemies = (shot.team == TeamId::Orange) ? teamBlue : teamOrange;
-            for (NPC* enemy : enemies) {
-                if (!enemy || !enemy->IsAlive()) continue;
-                double dx = enemy->getX() - shot.x;
-                double dy = enemy->getY() - shot.y;
-                if (dx * dx + dy * dy <= 1.0) {
-                    enemy->TakeDamage(shot.damage);
-                    removeShot = true;
-                    break;
-                }
-            }
-        }
-
-        if (shot.remainingDistance <= 0.0) {
-            removeShot = true;
-        }
-
-        if (removeShot) {
-            activeGunshots.erase(activeGunshots.begin() + i);
-        }
-        else {
-            ++i;
-        }
-    }
-}
-
-void DrawActiveGunshots()
-{
-    glLineWidth(3.0);
-    for (const Gunshot& shot : activeGunshots)
-    {
-        TeamColor c = GetTeamColor(shot.team);
-        glColor3d(c.r, c.g, c.b);
-
-        double tipX = shot.x + shot.dirX * 1.2;
-        double tipY = shot.y + shot.dirY * 1.2;
-        double tailX = shot.x - shot.dirX * 0.6;
-        double tailY = shot.y - shot.dirY * 0.6;
-        double orthoX = -shot.dirY * 0.3;
-        double orthoY = shot.dirX * 0.3;
-
-        glBegin(GL_TRIANGLES);
-        glVertex2d(tailX + orthoX, tailY + orthoY);
-        glVertex2d(tailX - orthoX, tailY - orthoY);
-        glVertex2d(tipX, tipY);
-        glEnd();
-
-        glColor3d(1.0, 1.0, 0.0);
-        glBegin(GL_LINES);
-        glVertex2d(tailX, tailY);
-        glVertex2d(tipX, tipY);
-        glEnd();
-
-        glColor3d(1.0, 0.6, 0.1);
-        glBegin(GL_LINES);
-        glVertex2d(tailX + orthoX * 0.15, tailY + orthoY * 0.15);
-        glVertex2d(tipX, tipY);
-        glEnd();
-    }
-    glLineWidth(1.0);
-}
-void NPC::Show()
-{
-    if (IsAlive()) {
-        DrawAsSquareWithLetter();
-        double now = clock() / (double)CLOCKS_PER_SEC;
-        if (now < hitFlashUntil) {
-            double outlineHalf = size * 0.65;
-            glColor3d(1.0, 0.2, 0.2);
-            glLineWidth(3.0);
-            glBegin(GL_LINE_LOOP);
-            glVertex2d(x - outlineHalf, y - outlineHalf);
-            glVertex2d(x + outlineHalf, y - outlineHalf);
-            glVertex2d(x + outlineHalf, y + outlineHalf);
-            glVertex2d(x - outlineHalf, y + outlineHalf);
-            glEnd();
-            glLineWidth(1.0);
-        }
-    }
-    else {
-        DrawDeadMarker();
-    }
-    DrawStatusBars();
-}
@@ -5,6 +5,7 @@
 #include <utility>
 #include "Roles.h"
 #include "Definitions.h"
+#include "AgentTable.h"
 
 // Global list of all NPCs (used for collision checks)
 extern std::vector<NPC*> allNPCs;
@@ -13,28 +14,26 @@ extern std::vector<NPC*> allNPCs;
 //enum class TeamState { ATTACK, DEFEND, RETREAT }; // for team logic reference
 
 class Commander; // forward declaration
+class StatePool;
+namespace Path { class IncrementalPlanner; }
 
 class NPC {
 private:
-    double x, y;
-    double targetX, targetY;
-    double dirX, dirY;
-    bool isMoving, isEngaging, isDelivering, isResting, isLowAmmo;
+    // Position, direction, waypoint, hp, team, role, moving flag and
+    // occupied cell live in the world's AgentTable at index 'slot'
+    AgentTable& agents;
+    int slot;
+
+    bool isEngaging, isDelivering, isResting, isLowAmmo;
     int ammo;      // number of bullets
     int grenades;  // number of grenades (for Warriors only)
-    int hp;        // health points
     int maxAmmo;
     int supply;    // generic supply counter (medkits, ammo crates, etc.)
     int maxSupply;
     int assistsDone;
     NPC* targetNPC;
 
-    static int nextId;
-
-    int id;
-    int occupiedCellX;
-    int occupiedCellY;
-    bool hasOccupancy;
+    int id;                    // unique within the owning World
     int waitTicks;
     int stuckTicks;
     double lastProgressX;
@@ -46,15 +45,16 @@ private:
     double orderTargetX;
     double orderTargetY;
     
+    StatePool* statePool;       // owns every state instance; the pointers below only refer into it
     State* pCurrentState;
     State* pInterruptedState;
+    unsigned stateEpoch;        // bumped on every state change, including re-entering the same state type
 
     // --- path following state ---
     std::vector<std::pair<int, int>> path; // grid cells to follow
     int pathIndex; // current waypoint index in 'path'
+    Path::IncrementalPlanner* planner;      // D* Lite search reused by blocked replans (owned)
 
-    TeamId team;
-    Role role;
     double size;
 
     Commander* commander;  // reference to this NPC's commander
@@ -76,6 +76,7 @@ private:
     bool PlanShortDetour(int searchRadius);
     bool TryStepAside();
     void UpdateOccupancy();
+    void UpdateGridEntry();
     bool ReplanPathWithDynamicCosts();
 
 
@@ -89,17 +90,18 @@ public:
 
 
     void DoSomeWork();
-    void Show();
     void setDirection();
 
     // --- path API ---
     void SetPath(const std::vector<std::pair<int, int>>& p); // assign whole path
     void GoToGrid(int gx, int gy); // compute A* and start moving
+    bool IsAwaitingPath() const;   // a path request is still being searched (PathService)
 
     int GetId() const { return id; }
+    int GetSlot() const { return slot; }     // index into World::agents
 
-    void setTarget(double tx, double ty) { targetX = tx; targetY = ty; }
-    void setIsMoving(bool v) { isMoving = v; }
+    void setTarget(double tx, double ty) { agents.targetX[slot] = tx; agents.targetY[slot] = ty; }
+    void setIsMoving(bool v) { agents.moving[slot] = v; }
     void setIsEngaging(bool v) { isEngaging = v; }
     void setIsDelivering(bool v) { isDelivering = v; }
     void setIsResting(bool v) { isResting = v; }
@@ -112,15 +114,17 @@ public:
     void clearOrderTarget() { hasOrderTarget = false; }
     std::pair<int, int> getOrderTarget() const { return { (int)orderTargetX, (int)orderTargetY }; }
 
-    void setCurrentState(State* ps) { pCurrentState = ps; }
+    void setCurrentState(State* ps) { pCurrentState = ps; ++stateEpoch; }
     void setInterruptedState(State* ps) { pInterruptedState = ps; }
 
     bool getIsEngaging() const { return isEngaging; }
     State* getCurrentState() { return pCurrentState; }
+    unsigned GetStateEpoch() const { return stateEpoch; }
     State* getInterruptedState() { return pInterruptedState; }
+    StatePool& getStatePool() { return *statePool; }
     bool   getLowAmmo() const { return isLowAmmo; }
 
-    bool getIsMoving() const { return isMoving; }
+    bool getIsMoving() const { return agents.moving[slot]; }
     bool getIsResting() const { return isResting; }
 
     bool getIsDelivering() const { return isDelivering; }
@@ -129,11 +133,11 @@ public:
     NPC* getTargetNPC() const { return targetNPC; }
     int getBlockCounter() const { return blockCounter; }
     void setBlockCounter(int c) { blockCounter = c; }
-    double getTargetX() const { return targetX; }
-    double getTargetY() const { return targetY; }
+    double getTargetX() const { return agents.targetX[slot]; }
+    double getTargetY() const { return agents.targetY[slot]; }
 
-    double getX() const { return x; }
-    double getY() const { return y; }
+    double getX() const { return agents.x[slot]; }
+    double getY() const { return agents.y[slot]; }
 
     // --- combat API ---
     void setAmmo(int a) { 
@@ -149,7 +153,7 @@ public:
         }
     }
     int getAmmo() const { return ammo; }
-    bool CanShoot() const { return role == Role::Warrior && ammo > 0; }
+    bool CanShoot() const { return getRole() == Role::Warrior && ammo > 0; }
     void decreaseAmmo() { if (ammo > 0) ammo--; }
     void Reload(int amount);
     void RefillAmmo();
@@ -157,7 +161,7 @@ public:
     int getMaxAmmo() const { return maxAmmo; }
     
     void setGrenades(int g) {
-        if (role != Role::Warrior) {
+        if (getRole() != Role::Warrior) {
             grenades = 0;
             return;
         }
@@ -165,16 +169,16 @@ public:
         supply = std::min(maxSupply, grenades);
     }
     int getGrenades() const { return grenades; }
-    bool CanThrowGrenade() const { return role == Role::Warrior && grenades > 0; }
+    bool CanThrowGrenade() const { return getRole() == Role::Warrior && grenades > 0; }
     void decreaseGrenades() { 
         if (grenades > 0) {
             grenades--;
-            if (role == Role::Warrior) {
+            if (getRole() == Role::Warrior) {
                 supply = std::max(0, grenades);
             }
         }
     }
-    bool CanTakeAssist() const { return (role == Role::Medic || role == Role::Porter) && assistsDone < ASSIST_LIMIT; }
+    bool CanTakeAssist() const { return (getRole() == Role::Medic || getRole() == Role::Porter) && assistsDone < ASSIST_LIMIT; }
     int GetAssistsDone() const { return assistsDone; }
     void RegisterAssistCompletion();
     void ResetAssistCounter() { assistsDone = 0; }
@@ -189,34 +193,28 @@ public:
     int getMaxSupply() const { return maxSupply; }
     void consumeSupply(int amount) { 
         supply = std::max(0, supply - amount); 
-        if (role == Role::Warrior) {
+        if (getRole() == Role::Warrior) {
             grenades = supply;
         }
     }
     void addSupply(int amount) { 
         supply = std::min(maxSupply, supply + amount); 
-        if (role == Role::Warrior) {
+        if (getRole() == Role::Warrior) {
             grenades = supply;
         }
     }
 
-    void setHP(int h) { hp = h; }
-    int getHP() const { return hp; }
-    bool IsAlive() const { return hp > 0; }
+    void setHP(int h);
+    int getHP() const { return agents.hp[slot]; }
+    bool IsAlive() const { return agents.alive[slot] != 0; }
 
     int getPathSize() const { return (int)path.size(); }
 
-    TeamId getTeam() const { return team; }
-    Role   getRole() const { return role; }
-    char   getSymbol() const { return RoleLetter(role); }
+    TeamId getTeam() const { return agents.team[slot]; }
+    Role   getRole() const { return agents.role[slot]; }
+    char   getSymbol() const { return RoleLetter(getRole()); }
     double getSize() const { return size; }
 
-    void   DrawAsSquareWithLetter() const;
-    void   DrawHPBar(bool placeAbove) const;  // Draw HP bar relative to NPC
-    void   DrawAmmoBar(bool placeAbove) const;
-    void   DrawSupplyBar(bool placeAbove) const;
-    void   DrawDeadMarker() const;
-    void   DrawStatusBars() const;
     void AssignInitialStateByRole();
     double getMoveSpeed() const;
 
@@ -241,8 +239,6 @@ public:
     double GetLastRetreatTime() const { return lastRetreatTime; }
     void MarkIdleAnchorIssued();
     double GetLastIdleAnchorTime() const { return lastIdleAnchorTime; }
+    double GetHitFlashUntil() const { return hitFlashUntil; }   // red outline until this sim time
 
 };
-
-void UpdateActiveGunshots();
-void DrawActiveGunshots();
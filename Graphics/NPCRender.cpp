@@ -0,0 +1,181 @@
+﻿#include "Snapshot.h"
+#include <stdio.h>
+#include <algorithm>
+#include "Roles.h"
+#include "Definitions.h"
+#include "RenderBatch.h"
+
+// Agents and gunshots from a FrameSnapshot - only linked into the GLUT frontend
+
+static const TeamColor BLACK{ 0.0, 0.0, 0.0 };
+static const TeamColor WHITE{ 1.0, 1.0, 1.0 };
+static const TeamColor BAR_BACKGROUND{ 0.2, 0.2, 0.2 };
+static const TeamColor BAR_FILL{ 0.75, 0.75, 0.75 };
+
+// Grey background, light grey fill for 'percent' of the width, black border
+static void AddBar(RenderBatch& batch, double barX, double barY, double barWidth, double barHeight, double percent)
+{
+    batch.Quad(barX, barY, barX + barWidth, barY + barHeight, BAR_BACKGROUND);
+    if (percent > 0) {
+        batch.Quad(barX, barY, barX + barWidth * percent, barY + barHeight, BAR_FILL);
+    }
+    batch.Outline(barX, barY, barX + barWidth, barY + barHeight, BLACK);
+}
+
+// Draw as colored square with centered role letter
+static void DrawAsSquareWithLetter(const AgentView& a)
+{
+    RenderBatch& batch = RenderBatch::Frame();
+    double h = a.size * 0.5;
+
+    batch.Quad(a.x - h, a.y - h, a.x + h, a.y + h, GetTeamColor(a.team));   // fill
+    batch.Outline(a.x - h, a.y - h, a.x + h, a.y + h, BLACK);
+
+    // Role symbol
+    char symbol[2] = { RoleLetter(a.role), '\0' };
+    batch.Text(a.x - 0.5, a.y - 0.5, RenderBatch::Font::Helvetica12, symbol, BLACK);
+}
+
+// Draw HP bar above the NPC
+static void DrawHPBar(const AgentView& a, bool placeAbove)
+{
+    double barWidth = a.size * 1.5;
+    double barHeight = 0.9;
+    double barX = a.x - barWidth / 2.0;
+    double offset = placeAbove ? -(a.size + 1.8) : (a.size + 1.8);
+    double barY = a.y + offset;
+
+    RenderBatch& batch = RenderBatch::Frame();
+    AddBar(batch, barX, barY, barWidth, barHeight, (double)a.hp / 100.0);
+
+    // HP text with percentage (to the right of the bar), white for better visibility
+    char hpStr[16];
+    sprintf_s(hpStr, sizeof(hpStr), "HP:%d%%", a.hp);
+    batch.Text(barX + barWidth + 1.0, barY + barHeight / 2.0 - 0.12, RenderBatch::Font::Helvetica10, hpStr, WHITE);
+}
+
+static void DrawAmmoBar(const AgentView& a, bool placeAbove)
+{
+    if (a.maxAmmo <= 0) return;
+
+    double ratio = a.ammo / (double)a.maxAmmo;
+    double percent = std::max(0.0, std::min(1.0, ratio));
+    double barWidth = a.size * 1.5;
+    double barHeight = 0.65;
+    double barX = a.x - barWidth / 2.0;
+    double offset = placeAbove ? -(a.size + 3.0) : (a.size + 3.0);
+    double barY = a.y + offset;
+
+    RenderBatch& batch = RenderBatch::Frame();
+    AddBar(batch, barX, barY, barWidth, barHeight, percent);
+
+    // Ammo label and values
+    char ammoStr[32];
+    sprintf_s(ammoStr, sizeof(ammoStr), "A:%d/%d", a.ammo, a.maxAmmo);
+    batch.Text(barX + barWidth + 1.0, barY + barHeight / 2.0 - 0.1, RenderBatch::Font::Helvetica10, ammoStr, WHITE);
+}
+
+static void DrawSupplyBar(const AgentView& a, bool placeAbove)
+{
+    int current = 0;
+    int maxValue = 0;
+
+    if (a.role == Role::Warrior) {
+        current = a.grenades;
+        maxValue = MAX_GRENADES;
+    }
+    else {
+        maxValue = a.maxSupply;
+        current = a.supply;
+    }
+
+    if (maxValue <= 0) return;
+
+    double ratio = current / (double)maxValue;
+    double percent = std::max(0.0, std::min(1.0, ratio));
+    double barWidth = a.size * 1.5;
+    double barHeight = 0.65;
+    double barX = a.x - barWidth / 2.0;
+    double offset = placeAbove ? -(a.size + 4.2) : (a.size + 4.2);
+    double barY = a.y + offset;
+
+    RenderBatch& batch = RenderBatch::Frame();
+    AddBar(batch, barX, barY, barWidth, barHeight, percent);
+
+    // Supply / grenade label and values
+    const char* label = "Supply";
+    if (a.role == Role::Warrior) label = "Grenades";
+    else if (a.role == Role::Medic) label = "Medkit";
+    else if (a.role == Role::Porter) label = "Crate";
+
+    char supplyStr[40];
+    if ((a.role == Role::Porter || a.role == Role::Medic) && maxValue <= 1) {
+        const char* status = (current > 0) ? "Ready" : "Empty";
+        sprintf_s(supplyStr, sizeof(supplyStr), "%c:%s", label[0], status);
+    } else {
+        sprintf_s(supplyStr, sizeof(supplyStr), "%c:%d/%d", label[0], current, maxValue);
+    }
+    batch.Text(barX + barWidth + 1.0, barY + barHeight / 2.0 - 0.1, RenderBatch::Font::Helvetica10, supplyStr, WHITE);
+}
+
+static void DrawDeadMarker(const AgentView& a)
+{
+    RenderBatch& batch = RenderBatch::Frame();
+    double h = a.size * 0.5;
+    batch.Quad(a.x - h, a.y - h, a.x + h, a.y + h, TeamColor{ 0.3, 0.3, 0.3 });
+    batch.Line(a.x - h, a.y - h, a.x + h, a.y + h, BLACK);
+    batch.Line(a.x - h, a.y + h, a.x + h, a.y - h, BLACK);
+}
+
+static void DrawStatusBars(const AgentView& a)
+{
+    bool placeAbove = a.y > 12.0;
+    DrawHPBar(a, placeAbove);
+
+    switch (a.role) {
+    case Role::Warrior:
+        DrawAmmoBar(a, placeAbove);
+        DrawSupplyBar(a, placeAbove);
+        break;
+    case Role::Porter:
+    case Role::Medic:
+        DrawSupplyBar(a, placeAbove);
+        break;
+    default:
+        break;
+    }
+}
+
+void DrawGunshots(const FrameSnapshot& snapshot)
+{
+    RenderBatch& batch = RenderBatch::Frame();
+    for (const ShotView& shot : snapshot.gunshots)
+    {
+        double tipX = shot.x + shot.dirX * 1.2;
+        double tipY = shot.y + shot.dirY * 1.2;
+        double tailX = shot.x - shot.dirX * 0.6;
+        double tailY = shot.y - shot.dirY * 0.6;
+        double orthoX = -shot.dirY * 0.3;
+        double orthoY = shot.dirX * 0.3;
+
+        batch.Triangle(tailX + orthoX, tailY + orthoY, tailX - orthoX, tailY - orthoY, tipX, tipY, GetTeamColor(shot.team));
+        batch.Line(tailX, tailY, tipX, tipY, TeamColor{ 1.0, 1.0, 0.0 }, true);
+        batch.Line(tailX + orthoX * 0.15, tailY + orthoY * 0.15, tipX, tipY, TeamColor{ 1.0, 0.6, 0.1 }, true);
+    }
+}
+
+void DrawAgent(const AgentView& a)
+{
+    if (a.hp > 0) {
+        DrawAsSquareWithLetter(a);
+        if (a.hitFlash) {
+            double outlineHalf = a.size * 0.65;
+            RenderBatch::Frame().Outline(a.x - outlineHalf, a.y - outlineHalf, a.x + outlineHalf, a.y + outlineHalf,
+                TeamColor{ 1.0, 0.2, 0.2 }, true);
+        }
+    }
+    else {
+        DrawDeadMarker(a);
+    }
+    DrawStatusBars(a);
+}
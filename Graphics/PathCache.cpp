@@ -0,0 +1,126 @@
+#include <cmath>
+#include <cstdlib>
+#include "PathCache.h"
+
+int PathCache::Bucket(double securityWeight)
+{
+    return (int)std::lround(securityWeight / WEIGHT_STEP);
+}
+
+bool PathCache::IsCurrent(const Entry& e)
+{
+    for (size_t i = 0; i < e.regions.size(); ++i) {
+        int region = e.regions[i];
+        if (Map::GetRegionVersion(region % Map::REGIONS_X, region / Map::REGIONS_X, e.team) != e.versions[i])
+            return false;
+    }
+    return true;
+}
+
+void PathCache::SetEnabled(bool on)
+{
+    enabled = on;
+    if (!on) Clear();
+}
+
+static int Steps(const Path::Cell& a, int x, int y)
+{
+    return std::abs(a.first - x) + std::abs(a.second - y);
+}
+
+bool PathCache::Lookup(int sx, int sy, int gx, int gy, TeamId team, double securityWeight, std::vector<Path::Cell>& out)
+{
+    int bucket = Bucket(securityWeight);
+    bool goalWalkable = Map::IsWalkable(gx, gy);
+
+    for (size_t k = 0; k < entries.size();) {
+        Entry& e = entries[k];
+        if (e.team != team || e.bucket != bucket) {
+            ++k;
+            continue;
+        }
+        // The goal may be the entry's goal or a walkable cell next to it
+        int goalSteps = Steps(e.path.back(), gx, gy);
+        if (goalSteps > 1 || (goalSteps == 1 && !goalWalkable)) {
+            ++k;
+            continue;
+        }
+        if (!IsCurrent(e)) {
+            entries[k] = std::move(entries.back());
+            entries.pop_back();
+            ++retired;
+            continue;
+        }
+
+        // Join the route at the cell closest to its end that is the start or next to it
+        for (size_t i = e.path.size(); i-- > 0;) {
+            if (Steps(e.path[i], sx, sy) > 1) continue;
+            out.clear();
+            if (e.path[i].first != sx || e.path[i].second != sy) out.emplace_back(sx, sy);
+            out.insert(out.end(), e.path.begin() + i, e.path.end());
+            if (goalSteps == 1) out.emplace_back(gx, gy);
+
+            e.lastUsed = ++useCounter;
+            ++hits;
+            if (i > 0) ++suffixHits;
+            return true;
+        }
+        ++k;
+    }
+
+    ++misses;
+    return false;
+}
+
+void PathCache::Store(TeamId team, double securityWeight, const std::vector<Path::Cell>& path)
+{
+    if (path.empty()) return;
+
+    const Path::Cell& last = path.back();
+    int goal = last.second * Map::W + last.first;
+    int bucket = Bucket(securityWeight);
+
+    Entry* slot = nullptr;
+    for (Entry& e : entries) {
+        // The same route from the same start replaces the older one
+        if (e.goal == goal && e.team == team && e.bucket == bucket && e.path.front() == path.front()) {
+            slot = &e;
+            break;
+        }
+    }
+    if (!slot) {
+        if ((int)entries.size() < CAPACITY) {
+            entries.emplace_back();
+            slot = &entries.back();
+        }
+        else {
+            slot = &entries[0];
+            for (Entry& e : entries) {
+                if (e.lastUsed < slot->lastUsed) slot = &e;
+            }
+        }
+    }
+
+    slot->team = team;
+    slot->bucket = bucket;
+    slot->goal = goal;
+    slot->path = path;
+    slot->regions.clear();
+    slot->versions.clear();
+    for (const Path::Cell& c : path) {
+        int region = (c.second / Map::REGION_SIZE) * Map::REGIONS_X + c.first / Map::REGION_SIZE;
+        bool seen = false;
+        for (int r : slot->regions) {
+            if (r == region) { seen = true; break; }
+        }
+        if (seen) continue;
+        slot->regions.push_back(region);
+        slot->versions.push_back(Map::GetRegionVersion(c.first / Map::REGION_SIZE, c.second / Map::REGION_SIZE, team));
+    }
+    slot->lastUsed = ++useCounter;
+}
+
+void PathCache::Clear()
+{
+    entries.clear();
+}
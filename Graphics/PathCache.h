@@ -0,0 +1,59 @@
+#pragma once
+#include <vector>
+#include "Roles.h"
+#include "Map.h"
+#include "Pathfinding.h"
+
+// ---------------------------------------------------------
+// PathCache - recent FindSafePath results, reused for repeated requests
+// Entries are keyed by team, goal cell and security weight (rounded to
+// WEIGHT_STEP). A request hits when an entry of its key starts at the
+// requested cell, or passes through it (the rest of that route is
+// returned). An entry is valid while the Map region versions of every
+// region its route crosses are unchanged, so terrain, dynamic cost and
+// large danger changes along the route retire it. Occupancy is not
+// tracked: blocked NPCs replan on their own. Off by default; when full,
+// the least recently used entry is replaced.
+// ---------------------------------------------------------
+class PathCache {
+public:
+    static const int CAPACITY = 64;
+    static constexpr double WEIGHT_STEP = 0.1;
+
+    void SetEnabled(bool on);
+    bool IsEnabled() const { return enabled; }
+
+    // Route from (sx,sy) to (gx,gy) in FindSafePath layout, if a valid entry covers it
+    bool Lookup(int sx, int sy, int gx, int gy, TeamId team, double securityWeight, std::vector<Path::Cell>& out);
+    // Remembers a route FindSafePath found (start cell first)
+    void Store(TeamId team, double securityWeight, const std::vector<Path::Cell>& path);
+    void Clear();
+
+    // Counters for profiling
+    unsigned long long Hits() const { return hits; }
+    unsigned long long SuffixHits() const { return suffixHits; }   // included in Hits
+    unsigned long long Misses() const { return misses; }
+    unsigned long long Retired() const { return retired; }         // dropped because a region changed
+
+private:
+    struct Entry {
+        TeamId team = TeamId::Orange;
+        int bucket = 0;
+        int goal = -1;                          // cell index
+        std::vector<Path::Cell> path;
+        std::vector<int> regions;               // regions the route crosses (ry * REGIONS_X + rx)
+        std::vector<unsigned int> versions;     // their versions when stored
+        unsigned long long lastUsed = 0;
+    };
+
+    static int Bucket(double securityWeight);
+    static bool IsCurrent(const Entry& e);
+
+    bool enabled = false;
+    std::vector<Entry> entries;
+    unsigned long long useCounter = 0;
+    unsigned long long hits = 0;
+    unsigned long long suffixHits = 0;
+    unsigned long long misses = 0;
+    unsigned long long retired = 0;
+};
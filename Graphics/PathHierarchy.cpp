@@ -0,0 +1,166 @@
+#include <algorithm>
+#include "PathHierarchy.h"
+#include "Log.h"
+
+void PathHierarchy::Bounds(int cluster, int& x0, int& y0, int& x1, int& y1)
+{
+    x0 = (cluster % CLUSTERS_X) * CLUSTER;
+    y0 = (cluster / CLUSTERS_X) * CLUSTER;
+    x1 = std::min(x0 + CLUSTER, Map::W) - 1;
+    y1 = std::min(y0 + CLUSTER, Map::H) - 1;
+}
+
+void PathHierarchy::DistancesFrom(int x, int y, std::vector<int>& dist) const
+{
+    const Map::TerrainPlanes& planes = Map::Planes();
+    int x0, y0, x1, y1;
+    Bounds(ClusterOf(x, y), x0, y0, x1, y1);
+
+    dist.assign(CLUSTER * CLUSTER, -1);
+    if (!planes.Walkable(x, y)) return;
+
+    static const int DX[4] = { +1, -1, 0, 0 };
+    static const int DY[4] = { 0, 0, +1, -1 };
+    std::vector<std::pair<int, int>> queue;
+    queue.reserve(CLUSTER * CLUSTER);
+    queue.emplace_back(x, y);
+    dist[LocalIndex(x, y)] = 0;
+
+    for (size_t head = 0; head < queue.size(); ++head) {
+        int cx = queue[head].first;
+        int cy = queue[head].second;
+        int d = dist[LocalIndex(cx, cy)];
+        for (int k = 0; k < 4; ++k) {
+            int nx = cx + DX[k];
+            int ny = cy + DY[k];
+            if (nx < x0 || nx > x1 || ny < y0 || ny > y1) continue;
+            if (!planes.Walkable(nx, ny)) continue;
+            int& nd = dist[LocalIndex(nx, ny)];
+            if (nd != -1) continue;
+            nd = d + 1;
+            queue.emplace_back(nx, ny);
+        }
+    }
+}
+
+void PathHierarchy::BuildBorder(int cluster, bool alongY)
+{
+    std::vector<std::pair<int, int>>& border = alongY ? bordersY[cluster] : bordersX[cluster];
+    border.clear();
+
+    int cx = cluster % CLUSTERS_X;
+    int cy = cluster / CLUSTERS_X;
+    if (alongY ? cy + 1 >= CLUSTERS_Y : cx + 1 >= CLUSTERS_X) return;
+
+    const Map::TerrainPlanes& planes = Map::Planes();
+    int x0, y0, x1, y1;
+    Bounds(cluster, x0, y0, x1, y1);
+
+    // Walk the border; (px,py) is the block's cell, the neighbour's is one step further
+    const int length = alongY ? x1 - x0 + 1 : y1 - y0 + 1;
+    const int stepX = alongY ? 0 : 1;
+    const int stepY = alongY ? 1 : 0;
+    auto cellAt = [&](int i, int& px, int& py) {
+        px = alongY ? x0 + i : x1;
+        py = alongY ? y1 : y0 + i;
+    };
+    auto addEntrance = [&](int i) {
+        int px, py;
+        cellAt(i, px, py);
+        border.push_back({ py * Map::W + px, (py + stepY) * Map::W + (px + stepX) });
+    };
+
+    int runStart = -1;
+    for (int i = 0; i <= length; ++i) {
+        bool open = false;
+        if (i < length) {
+            int px, py;
+            cellAt(i, px, py);
+            open = planes.Walkable(px, py) && planes.Walkable(px + stepX, py + stepY);
+        }
+        if (open && runStart < 0) runStart = i;
+        if (open || runStart < 0) continue;
+
+        int runLength = i - runStart;
+        if (runLength >= SPLIT_OPENING) {
+            addEntrance(runStart);
+            addEntrance(i - 1);
+        }
+        else {
+            addEntrance(runStart + (runLength - 1) / 2);
+        }
+        runStart = -1;
+    }
+}
+
+void PathHierarchy::BuildCluster(int cluster)
+{
+    Cluster& c = clusters[cluster];
+    c.nodes.clear();
+    c.links.clear();
+
+    auto addLink = [&](int inside, int across) {
+        size_t slot = std::find(c.nodes.begin(), c.nodes.end(), inside) - c.nodes.begin();
+        if (slot == c.nodes.size()) c.nodes.push_back(inside);
+        c.links.push_back({ (int)slot, across });
+    };
+
+    int cx = cluster % CLUSTERS_X;
+    int cy = cluster / CLUSTERS_X;
+    for (const auto& e : bordersX[cluster]) addLink(e.first, e.second);
+    for (const auto& e : bordersY[cluster]) addLink(e.first, e.second);
+    if (cx > 0) for (const auto& e : bordersX[cluster - 1]) addLink(e.second, e.first);
+    if (cy > 0) for (const auto& e : bordersY[cluster - CLUSTERS_X]) addLink(e.second, e.first);
+
+    const int n = (int)c.nodes.size();
+    c.dist.assign(n * n, -1);
+    std::vector<int> dist;
+    for (int a = 0; a < n; ++a) {
+        DistancesFrom(c.nodes[a] % Map::W, c.nodes[a] / Map::W, dist);
+        for (int b = 0; b < n; ++b) {
+            c.dist[a * n + b] = dist[LocalIndex(c.nodes[b] % Map::W, c.nodes[b] / Map::W)];
+        }
+    }
+    ++rebuilds;
+}
+
+void PathHierarchy::Refresh()
+{
+    uint64_t hash = Map::GetTerrainHash();
+    if (built && hash == terrainHash) return;
+
+    std::vector<unsigned char> changed(CLUSTER_COUNT, 0);
+    std::vector<unsigned char> touched(CLUSTER_COUNT, 0);
+    int changedCount = 0;
+
+    for (int cluster = 0; cluster < CLUSTER_COUNT; ++cluster) {
+        uint64_t regionHash = Map::GetRegionHash(cluster % CLUSTERS_X, cluster / CLUSTERS_X);
+        if (built && regionHash == clusters[cluster].regionHash) continue;
+        clusters[cluster].regionHash = regionHash;
+        changed[cluster] = 1;
+        ++changedCount;
+    }
+
+    // A border belongs to the block on its low side, and its entrances
+    // are nodes of both blocks it separates
+    for (int cluster = 0; cluster < CLUSTER_COUNT; ++cluster) {
+        if (!changed[cluster]) continue;
+        int cx = cluster % CLUSTERS_X;
+        int cy = cluster / CLUSTERS_X;
+        BuildBorder(cluster, false);
+        BuildBorder(cluster, true);
+        touched[cluster] = 1;
+        if (cx > 0) { BuildBorder(cluster - 1, false); touched[cluster - 1] = 1; }
+        if (cy > 0) { BuildBorder(cluster - CLUSTERS_X, true); touched[cluster - CLUSTERS_X] = 1; }
+        if (cx + 1 < CLUSTERS_X) touched[cluster + 1] = 1;
+        if (cy + 1 < CLUSTERS_Y) touched[cluster + CLUSTERS_X] = 1;
+    }
+
+    for (int cluster = 0; cluster < CLUSTER_COUNT; ++cluster) {
+        if (touched[cluster]) BuildCluster(cluster);
+    }
+
+    LOG_DEBUG(Path, "Path hierarchy: %d of %d clusters changed", changedCount, CLUSTER_COUNT);
+    built = true;
+    terrainHash = hash;
+}
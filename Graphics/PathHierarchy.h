@@ -0,0 +1,64 @@
+#pragma once
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include "Map.h"
+
+// ---------------------------------------------------------
+// PathHierarchy - cluster abstraction of the grid for HPA*
+// The map is cut into CLUSTER x CLUSTER blocks (Map's change tracking
+// regions). Every maximal opening between two neighbouring blocks gets an
+// entrance: the cell pair in its middle, or one pair at each end when the
+// opening is long. Entrance cells are the nodes of the abstract graph;
+// inside a block they are joined by their step distance through that block,
+// across a border by a single step. Distances count steps only, costs that
+// change every tick are left to the search that uses the graph.
+// A block whose region hash changed (Map::Set) is rebuilt together with
+// the entrances and distances of its four neighbours; the rest is kept.
+// ---------------------------------------------------------
+class PathHierarchy {
+public:
+    static const int CLUSTER = Map::REGION_SIZE;
+    static const int CLUSTERS_X = Map::REGIONS_X;
+    static const int CLUSTERS_Y = Map::REGIONS_Y;
+    static const int CLUSTER_COUNT = CLUSTERS_X * CLUSTERS_Y;
+    static const int SPLIT_OPENING = 6;         // openings this long get an entrance at each end
+
+    struct Cluster {
+        uint64_t regionHash = 0;                // Map region hash the block was built from
+        std::vector<int> nodes;                 // entrance cells inside the block (cell index)
+        std::vector<std::pair<int, int>> links; // {node slot, cell across the border}
+        std::vector<int> dist;                  // nodes x nodes steps through the block, -1 = none
+
+        int Distance(int from, int to) const { return dist[from * (int)nodes.size() + to]; }
+    };
+
+    // Brings every block up to date with the current terrain
+    void Refresh();
+
+    const Cluster& Get(int cluster) const { return clusters[cluster]; }
+
+    // Steps from (x,y) to every cell of its block without leaving it,
+    // indexed by LocalIndex; -1 where the block is not reachable.
+    void DistancesFrom(int x, int y, std::vector<int>& dist) const;
+
+    static int ClusterOf(int x, int y) { return (y / CLUSTER) * CLUSTERS_X + x / CLUSTER; }
+    static int LocalIndex(int x, int y) { return (y % CLUSTER) * CLUSTER + x % CLUSTER; }
+    // Cell range of a block (inclusive)
+    static void Bounds(int cluster, int& x0, int& y0, int& x1, int& y1);
+
+    // Blocks rebuilt so far (for profiling)
+    unsigned long long Rebuilds() const { return rebuilds; }
+
+private:
+    // Entrances between a block and its neighbour at x + 1 (or y + 1 when 'alongY')
+    void BuildBorder(int cluster, bool alongY);
+    void BuildCluster(int cluster);
+
+    bool built = false;
+    uint64_t terrainHash = 0;
+    Cluster clusters[CLUSTER_COUNT];
+    std::vector<std::pair<int, int>> bordersX[CLUSTER_COUNT];  // {cell in block, cell at x + 1}
+    std::vector<std::pair<int, int>> bordersY[CLUSTER_COUNT];  // {cell in block, cell at y + 1}
+    unsigned long long rebuilds = 0;
+};
@@ -0,0 +1,218 @@
+#include <algorithm>
+#include <cstring>
+#include "PathService.h"
+#include "World.h"
+#include "NPC.h"
+#include "Log.h"
+
+namespace {
+    // The parts of the map layers the searches read
+    void CopySearchLayers(const Map::Layers& from, Map::Layers& to)
+    {
+        to.grid = from.grid;
+        to.occupancy = from.occupancy;
+        to.planes = from.planes;
+        std::memcpy(to.securityMaps, from.securityMaps, sizeof(to.securityMaps));
+        std::memcpy(to.dynamicCost, from.dynamicCost, sizeof(to.dynamicCost));
+        to.terrainHash = from.terrainHash;
+        std::memcpy(to.regionHash, from.regionHash, sizeof(to.regionHash));
+        to.securityVersion[0] = from.securityVersion[0];
+        to.securityVersion[1] = from.securityVersion[1];
+    }
+}
+
+PathService::~PathService()
+{
+    StopWorkers();
+    delete snapshot;
+}
+
+void PathService::Serve(const Path::Request& request, Path::Result& result)
+{
+    const Path::Request& r = request;
+    for (size_t i = 0; i < r.safeWeights.size(); ++i) {
+        if (Path::FindSafePath(r.sx, r.sy, r.gx, r.gy, r.team, result.path, r.safeWeights[i], r.ignoreNpcId)) {
+            result.attempt = (int)i;
+            return;
+        }
+    }
+    if (r.plainFallback && Path::FindPath(r.sx, r.sy, r.gx, r.gy, result.path, r.ignoreNpcId)) {
+        result.attempt = (int)r.safeWeights.size();
+    }
+}
+
+void PathService::Submit(NPC* npc, const Path::Request& request, Path::Callback done)
+{
+    Cancel(npc);
+    ++requests;
+
+    if (workers.empty()) {
+        Path::Result result;
+        Serve(request, result);
+        done(npc, result);
+        return;
+    }
+
+    Job job;
+    job.npc = npc;
+    job.stateEpoch = npc->GetStateEpoch();
+    job.request = request;
+    job.done = std::move(done);
+    queued.push_back(std::move(job));
+    ++deferred;
+}
+
+bool PathService::IsPending(const NPC* npc) const
+{
+    for (const Job& job : queued) {
+        if (job.live && job.npc == npc) return true;
+    }
+    for (const Job& job : batch) {
+        if (job.live && job.npc == npc) return true;
+    }
+    return false;
+}
+
+void PathService::Cancel(const NPC* npc)
+{
+    for (Job& job : queued) {
+        if (job.live && job.npc == npc) {
+            job.live = false;
+            ++dropped;
+        }
+    }
+    for (Job& job : batch) {
+        if (job.live && job.npc == npc) {
+            job.live = false;
+            ++dropped;
+        }
+    }
+}
+
+void PathService::Collect()
+{
+    if (batch.empty()) return;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [this] { return doneJobs == (int)batch.size(); });
+    }
+    World::Current().profiler.TakeSearches(snapshot->profiler);
+
+    // Callbacks may submit (into 'queued') or cancel, but never resize 'batch'
+    for (size_t i = 0; i < batch.size(); ++i) {
+        Job& job = batch[i];
+        if (!job.live) continue;
+        job.live = false;
+        if (job.npc->GetStateEpoch() != job.stateEpoch) {
+            ++dropped;
+            continue;
+        }
+        job.done(job.npc, job.result);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    batch.clear();
+    nextJob = 0;
+    doneJobs = 0;
+}
+
+void PathService::Dispatch()
+{
+    queued.erase(std::remove_if(queued.begin(), queued.end(), [](const Job& job) { return !job.live; }),
+        queued.end());
+    if (queued.empty()) return;
+
+    World& live = World::Current();
+    CopySearchLayers(live.map, snapshot->map);
+    snapshot->pathSearch = live.pathSearch;
+    snapshot->tickCount = live.tickCount;
+    if (snapshot->pathSearch == Path::SearchMode::Hierarchical) {
+        // Brought up to date here so the workers only read it
+        WorldScope scope(snapshot);
+        snapshot->pathHierarchy.Refresh();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        batch.swap(queued);
+        nextJob = 0;
+        doneJobs = 0;
+    }
+    queued.clear();
+    wake.notify_all();
+}
+
+void PathService::Update()
+{
+    if (workers.empty()) return;
+    Collect();
+    Dispatch();
+}
+
+void PathService::SetWorkers(int count)
+{
+    count = std::max(0, count);
+    if (count == (int)workers.size()) return;
+
+    Collect();
+    StopWorkers();
+
+    if (count == 0) {
+        // Whatever was queued for the pool is searched right away
+        std::vector<Job> pending;
+        pending.swap(queued);
+        for (Job& job : pending) {
+            if (!job.live || job.npc->GetStateEpoch() != job.stateEpoch) continue;
+            job.live = false;
+            Serve(job.request, job.result);
+            job.done(job.npc, job.result);
+        }
+        LOG_INFO(Path, "Path requests are searched inline");
+        return;
+    }
+
+    if (!snapshot) snapshot = new World();
+    stopping = false;
+    for (int i = 0; i < count; ++i) {
+        workers.emplace_back(&PathService::WorkerLoop, this);
+    }
+    LOG_INFO(Path, "Path requests are searched by %d worker threads", count);
+}
+
+void PathService::StopWorkers()
+{
+    if (workers.empty()) return;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [this] { return doneJobs == (int)batch.size(); });
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& t : workers) t.join();
+    workers.clear();
+}
+
+void PathService::WorkerLoop()
+{
+    WorldScope scope(snapshot);
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        wake.wait(lock, [this] { return stopping || nextJob < (int)batch.size(); });
+        if (stopping) return;
+
+        Job& job = batch[nextJob++];
+        lock.unlock();
+        Serve(job.request, job.result);
+        lock.lock();
+
+        if (++doneJobs == (int)batch.size()) finished.notify_one();
+    }
+}
+
+namespace Path
+{
+    void RequestPath(NPC* npc, const Request& request, Callback done)
+    {
+        World::Current().pathRequests.Submit(npc, request, std::move(done));
+    }
+}
@@ -0,0 +1,117 @@
+#pragma once
+#include <vector>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "Roles.h"
+#include "Pathfinding.h"
+
+class NPC;
+class World;
+
+namespace Path
+{
+    // A route wanted by an FSM state: FindSafePath with each weight in
+    // turn, then (if allowed) plain FindPath, first success wins.
+    struct Request {
+        int sx = 0, sy = 0;
+        int gx = 0, gy = 0;
+        TeamId team = TeamId::Orange;
+        int ignoreNpcId = -1;
+        std::vector<double> safeWeights;
+        bool plainFallback = true;
+    };
+
+    struct Result {
+        std::vector<Cell> path;
+        int attempt = -1;           // index into safeWeights, safeWeights.size() = FindPath, -1 = no route
+        bool Found() const { return attempt >= 0; }
+    };
+
+    // Runs on the simulation thread once the route is known
+    using Callback = std::function<void(NPC*, Result&)>;
+}
+
+// ---------------------------------------------------------
+// PathService - path requests of the FSM states, optionally served off-tick
+// With no workers (the default) a request is searched at once and its
+// callback runs before Submit returns, exactly like calling the searches
+// directly. With workers, requests made during tick N are searched by a
+// thread pool against a copy of the map layers taken at the end of tick N,
+// while tick N + 1 runs, and their callbacks run in request order at the
+// end of tick N + 1. The NPC keeps its current path (and skips its state's
+// Transition) until then. Results depend only on the tick a request was
+// made in, never on the worker count or thread timing.
+// One request per NPC is outstanding: a newer one, a direct NPC::SetPath
+// or a state change drops the older result. State changes are detected by
+// the NPC's state epoch, since re-entering the same state type reuses the
+// pooled state object.
+// ---------------------------------------------------------
+class PathService {
+public:
+    PathService() = default;
+    ~PathService();
+
+    PathService(const PathService&) = delete;
+    PathService& operator=(const PathService&) = delete;
+
+    // 0 = search inline (default). Results still in flight are delivered first.
+    void SetWorkers(int count);
+    int Workers() const { return (int)workers.size(); }
+
+    void Submit(NPC* npc, const Path::Request& request, Path::Callback done);
+    bool IsPending(const NPC* npc) const;
+    // Drops the NPC's outstanding request, its callback never runs
+    void Cancel(const NPC* npc);
+
+    // End of tick: delivers the batch searched during this tick and hands
+    // the requests made in it to the workers
+    void Update();
+
+    // Counters for profiling
+    unsigned long long Requests() const { return requests; }
+    unsigned long long Deferred() const { return deferred; }    // served by the workers
+    unsigned long long Dropped() const { return dropped; }      // superseded or cancelled
+
+private:
+    struct Job {
+        NPC* npc = nullptr;
+        unsigned stateEpoch = 0;    // NPC's state epoch when submitted; the result is dropped if it changed
+        Path::Request request;
+        Path::Callback done;
+        Path::Result result;        // written by a worker
+        bool live = true;           // cleared when delivered or cancelled (simulation thread only)
+    };
+
+    static void Serve(const Path::Request& request, Path::Result& result);
+
+    // Waits for the batch in flight and runs its callbacks
+    void Collect();
+    // Copies the map layers into the snapshot and starts the queued requests
+    void Dispatch();
+    void StopWorkers();
+    void WorkerLoop();
+
+    std::vector<Job> queued;        // submitted this tick
+    std::vector<Job> batch;         // being searched by the workers
+
+    World* snapshot = nullptr;      // read-only copy the workers search (owned)
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    int nextJob = 0;                // next batch index to claim
+    int doneJobs = 0;
+    bool stopping = false;
+
+    unsigned long long requests = 0;
+    unsigned long long deferred = 0;
+    unsigned long long dropped = 0;
+};
+
+namespace Path
+{
+    // Submits to the current world's PathService
+    void RequestPath(NPC* npc, const Request& request, Callback done);
+}
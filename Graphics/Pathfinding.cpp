@@ -6,7 +6,10 @@
 #include <cmath>
 #include <limits>
 #include <algorithm>
-#include <stdio.h>
+#include "Log.h"
+#include "World.h"
+#include "PathHierarchy.h"
+#include "PathCache.h"
 
 namespace Path
 {
@@ -30,9 +33,93 @@ namespace Path
         bool operator<(const Node& other) const { return f > other.f; } // min-heap
     };
 
+    // Node arrays reused by every search on this thread. A cell's entries are
+    // only valid when its stamp equals the current generation, so starting a
+    // new search is a counter bump instead of clearing W*H entries.
+    struct SearchContext
+    {
+        std::vector<double> gscore;
+        std::vector<int> came;
+        std::vector<unsigned int> seen;     // gscore/came valid for this search
+        std::vector<unsigned int> closed;   // cell expanded (or visited, for BFS)
+        std::vector<Node> open;             // binary heap, capacity kept between searches
+        // Jump point search: cells that cost more than 1 and the cells around them (TerrainPlanes layout)
+        std::vector<uint64_t> costly;
+        std::vector<uint64_t> irregular;
+        std::vector<unsigned char> rowIrregular;    // any irregular cell in row y
+        // Hierarchical search: mean extra step cost per cluster, valid for this search like gscore
+        std::vector<double> penalty;
+        std::vector<unsigned int> penaltySeen;
+        unsigned int generation = 0;
+        long long expanded = 0;             // Close calls on this thread, for the profiler
+
+        void Begin()
+        {
+            const int N = Map::W * Map::H;
+            if (seen.empty()) {
+                gscore.resize(N);
+                came.resize(N);
+                seen.assign(N, 0);
+                closed.assign(N, 0);
+            }
+            if (++generation == 0) {
+                // Wrapped around: stale stamps could now look current
+                std::fill(seen.begin(), seen.end(), 0);
+                std::fill(closed.begin(), closed.end(), 0);
+                std::fill(penaltySeen.begin(), penaltySeen.end(), 0);
+                generation = 1;
+            }
+            open.clear();
+        }
+
+        double G(int i) const
+        {
+            return seen[i] == generation ? gscore[i] : std::numeric_limits<double>::infinity();
+        }
+        void SetG(int i, double g, int from)
+        {
+            gscore[i] = g;
+            came[i] = from;
+            seen[i] = generation;
+        }
+        bool IsClosed(int i) const { return closed[i] == generation; }
+        void Close(int i) { closed[i] = generation; ++expanded; }
+
+        // Same ordering as std::priority_queue<Node>
+        void Push(const Node& n)
+        {
+            open.push_back(n);
+            std::push_heap(open.begin(), open.end());
+        }
+        Node Pop()
+        {
+            std::pop_heap(open.begin(), open.end());
+            Node n = open.back();
+            open.pop_back();
+            return n;
+        }
+    };
+
+    static SearchContext& Context()
+    {
+        static thread_local SearchContext context;
+        return context;
+    }
+
+    // Reports one search, and the nodes closed during it, to the world's profiler
+    class SearchTally {
+    public:
+        SearchTally() : ctx(Context()), start(ctx.expanded) {}
+        ~SearchTally() { World::Current().profiler.AddSearch(ctx.expanded - start); }
+
+    private:
+        SearchContext& ctx;
+        long long start;
+    };
+
     // Reconstruct path from 'came' chain
     static void Reconstruct(int sx, int sy, int gx, int gy,
-        const std::vector<int>& came,
+        const SearchContext& ctx,
         std::vector<std::pair<int, int>>& out)
     {
         out.clear();
@@ -44,60 +131,556 @@ namespace Path
             int y = cur / Map::W;
             out.emplace_back(x, y);
             if (cur == start) break;
-            cur = came[cur];
+            cur = ctx.came[cur];
         }
         std::reverse(out.begin(), out.end());
     }
 
-bool FindPath(int sx, int sy, int gx, int gy, std::vector<std::pair<int, int>>& out, int ignoreNpcId)
+    void SetSearchMode(SearchMode mode)
     {
-        //  Basic guards 
-        if (!Map::InBounds(sx, sy) || !Map::InBounds(gx, gy)) {
-            printf("? Pathfinding: start or goal out of bounds.\n");
-            return false;
+        World::Current().pathSearch = mode;
+    }
+
+    SearchMode GetSearchMode()
+    {
+        return World::Current().pathSearch;
+    }
+
+    // ---------------------------------------------------------
+    // Jump point search (JPS+, 4-connected)
+    // JumpTable stores, for every cell and direction, how far a straight
+    // move goes before it reaches a jump point (a forced neighbour, see
+    // Harabor & Grastien) or a wall. It depends on terrain only and is
+    // rebuilt when the terrain hash changes. Each query marks the cells that
+    // cost more than 1 to enter, their neighbours and the goal as irregular:
+    // jumps stop on the first irregular cell, and irregular cells expand
+    // their four neighbours one step at a time like A*, so occupancy,
+    // dynamic and security costs are still paid exactly.
+    // ---------------------------------------------------------
+
+    static const int JUMP_DX[4] = { +1, -1, 0, 0 };
+    static const int JUMP_DY[4] = { 0, 0, +1, -1 };
+
+    struct JumpTable
+    {
+        bool built = false;
+        uint64_t terrainHash = 0;
+        std::vector<short> dist[4];     // per JUMP_DX/DY direction: >0 steps to the jump point, <=0 -(steps before the wall)
+        std::vector<short> runLeft;     // first x of the walkable run the cell lies in
+        std::vector<short> runRight;    // last x of that run
+
+        void Build(const Map::TerrainPlanes& planes)
+        {
+            const int N = Map::W * Map::H;
+            for (auto& d : dist) d.assign(N, 0);
+            runLeft.assign(N, 0);
+            runRight.assign(N, 0);
+
+            // One step further along 'from': wall, jump point, or one more than the next cell
+            auto extend = [](bool walkable, bool jumpPoint, short from) -> short {
+                if (!walkable) return 0;
+                if (jumpPoint) return 1;
+                return from > 0 ? from + 1 : from - 1;
+            };
+            // A side cell that opens up after being blocked behind the step
+            auto forcedH = [&](int nx, int y, int dx) {
+                return (planes.Walkable(nx, y - 1) && !planes.Walkable(nx - dx, y - 1)) ||
+                    (planes.Walkable(nx, y + 1) && !planes.Walkable(nx - dx, y + 1));
+            };
+            auto forcedV = [&](int x, int ny, int dy) {
+                return (planes.Walkable(x - 1, ny) && !planes.Walkable(x - 1, ny - dy)) ||
+                    (planes.Walkable(x + 1, ny) && !planes.Walkable(x + 1, ny - dy));
+            };
+
+            for (int y = 0; y < Map::H; ++y) {
+                for (int x = Map::W - 1; x >= 0; --x) {
+                    short next = (x + 1 < Map::W) ? dist[0][idx(x + 1, y)] : 0;
+                    dist[0][idx(x, y)] = extend(planes.Walkable(x + 1, y), forcedH(x + 1, y, +1), next);
+                    runRight[idx(x, y)] = (short)((x + 1 < Map::W && planes.Walkable(x + 1, y)) ? runRight[idx(x + 1, y)] : x);
+                }
+                for (int x = 0; x < Map::W; ++x) {
+                    short next = (x > 0) ? dist[1][idx(x - 1, y)] : 0;
+                    dist[1][idx(x, y)] = extend(planes.Walkable(x - 1, y), forcedH(x - 1, y, -1), next);
+                    runLeft[idx(x, y)] = (short)((x > 0 && planes.Walkable(x - 1, y)) ? runLeft[idx(x - 1, y)] : x);
+                }
+            }
+
+            // A vertical line also stops on rows where a horizontal jump finds a jump point
+            auto rowJumps = [&](int x, int y) { return dist[0][idx(x, y)] > 0 || dist[1][idx(x, y)] > 0; };
+            for (int x = 0; x < Map::W; ++x) {
+                for (int y = Map::H - 1; y >= 0; --y) {
+                    bool open = planes.Walkable(x, y + 1);
+                    short next = (y + 1 < Map::H) ? dist[2][idx(x, y + 1)] : 0;
+                    dist[2][idx(x, y)] = extend(open, open && (forcedV(x, y + 1, +1) || rowJumps(x, y + 1)), next);
+                }
+                for (int y = 0; y < Map::H; ++y) {
+                    bool open = planes.Walkable(x, y - 1);
+                    short next = (y > 0) ? dist[3][idx(x, y - 1)] : 0;
+                    dist[3][idx(x, y)] = extend(open, open && (forcedV(x, y - 1, -1) || rowJumps(x, y - 1)), next);
+                }
+            }
         }
-        if (!Map::IsWalkable(sx, sy)) {
-            printf(" Pathfinding: start not walkable (%d,%d)\n", sx, sy);
-            return false;
+    };
+
+    static JumpTable& Jumps()
+    {
+        static thread_local JumpTable table;
+        return table;
+    }
+
+    // First / last marked cell with x in [from, to] of a padded plane row, -1 if none
+    static int FirstMarked(const uint64_t* row, int from, int to)
+    {
+        int lo = from + 1, hi = to + 1;
+        for (int w = lo >> 6; w <= (hi >> 6); ++w) {
+            uint64_t bits = row[w];
+            if (w == (lo >> 6)) bits &= ~0ull << (lo & 63);
+            if (w == (hi >> 6)) bits &= ~0ull >> (63 - (hi & 63));
+            if (bits == 0) continue;
+            int b = 0;
+            while (!(bits & 1)) { bits >>= 1; ++b; }
+            return w * 64 + b - 1;
         }
-        if (!Map::IsWalkable(gx, gy)) {
-        printf(" Pathfinding: goal not walkable (%d,%d) - will try nearby.\n", gx, gy);
+        return -1;
+    }
+
+    static int LastMarked(const uint64_t* row, int from, int to)
+    {
+        int lo = from + 1, hi = to + 1;
+        for (int w = hi >> 6; w >= (lo >> 6); --w) {
+            uint64_t bits = row[w];
+            if (w == (lo >> 6)) bits &= ~0ull << (lo & 63);
+            if (w == (hi >> 6)) bits &= ~0ull >> (63 - (hi & 63));
+            if (bits == 0) continue;
+            int b = 63;
+            while (!(bits >> 63)) { bits <<= 1; --b; }
+            return w * 64 + b - 1;
+        }
+        return -1;
+    }
+
+    // Cost of entering a cell, the same sum FindPath / FindSafePath use
+    struct StepCost
+    {
+        double securityWeight;      // 0 for FindPath
+        TeamId team;
+        int ignoreNpcId;
+
+        double operator()(int x, int y) const
+        {
+            double security = securityWeight != 0.0 ? Map::GetSecurityValue(y, x, team) : 0.0;
+            return 1.0 + securityWeight * security * 10.0 +
+                Map::GetOccupancyPenalty(x, y, ignoreNpcId) + Map::GetDynamicCost(x, y);
+        }
+    };
+
+    class JumpPointSearcher
+    {
+    public:
+        JumpPointSearcher(SearchContext& context, const StepCost& stepCost, int goalX, int goalY)
+            : ctx(context), step(stepCost), table(Jumps())
+        {
+            const Map::TerrainPlanes& planes = Map::Planes();
+            if (!table.built || table.terrainHash != Map::GetTerrainHash()) {
+                table.Build(planes);
+                table.built = true;
+                table.terrainHash = Map::GetTerrainHash();
+            }
+            MarkIrregular(goalX, goalY);
+        }
+
+        bool Irregular(int x, int y) const
+        {
+            return (ctx.irregular[Map::TerrainPlanes::Word(x, y)] & Map::TerrainPlanes::Bit(x)) != 0;
+        }
+
+        // Every cell that is not irregular costs exactly 1
+        double Cost(int x, int y) const
+        {
+            return Irregular(x, y) ? step(x, y) : 1.0;
+        }
+
+        // Walks from (x,y) in direction (dx,dy) to the next jump point.
+        // Returns its cell index (and the number of steps) or -1 if the line is blocked.
+        int Jump(int x, int y, int dx, int dy, int& steps) const
+        {
+            const int STRIDE = Map::TerrainPlanes::STRIDE;
+            if (dx != 0) {
+                short d = table.dist[dx > 0 ? 0 : 1][idx(x, y)];
+                int limit = d > 0 ? d : -d;
+                if (limit == 0) return -1;
+                const uint64_t* row = &ctx.irregular[(y + 1) * STRIDE];
+                int hit = dx > 0 ? FirstMarked(row, x + 1, x + limit) : LastMarked(row, x - limit, x - 1);
+                if (hit != -1) {
+                    steps = std::abs(hit - x);
+                    return idx(hit, y);
+                }
+                steps = d;
+                return d > 0 ? idx(x + dx * d, y) : -1;
+            }
+
+            short d = table.dist[dy > 0 ? 2 : 3][idx(x, y)];
+            int limit = d > 0 ? d : -d;
+            for (int s = 1; s <= limit; ++s) {
+                int ny = y + dy * s;
+                if (!ctx.rowIrregular[ny]) continue;
+                // Irregular on the line itself, or where a horizontal scan from it would stop
+                int i = idx(x, ny);
+                if (FirstMarked(&ctx.irregular[(ny + 1) * STRIDE], table.runLeft[i], table.runRight[i]) != -1) {
+                    steps = s;
+                    return i;
+                }
+            }
+            steps = d;
+            return d > 0 ? idx(x, y + dy * d) : -1;
+        }
+
+    private:
+        // Costly cells grown by one cell in each direction, plus the goal
+        void MarkIrregular(int goalX, int goalY)
+        {
+            const int STRIDE = Map::TerrainPlanes::STRIDE;
+            const int WORDS = Map::TerrainPlanes::WORDS;
+            ctx.costly.assign(WORDS, 0);
+            ctx.irregular.assign(WORDS, 0);
+            ctx.rowIrregular.assign(Map::H, 0);
+            Map::MarkCostlyCells(ctx.costly.data(), step.ignoreNpcId,
+                step.securityWeight != 0.0 ? &step.team : nullptr);
+
+            for (int y = 0; y < Map::H; ++y) {
+                const uint64_t* above = &ctx.costly[y * STRIDE];
+                const uint64_t* here = &ctx.costly[(y + 1) * STRIDE];
+                const uint64_t* below = &ctx.costly[(y + 2) * STRIDE];
+                uint64_t* out = &ctx.irregular[(y + 1) * STRIDE];
+                uint64_t any = 0;
+                for (int w = 0; w < STRIDE; ++w) {
+                    uint64_t left = (here[w] << 1) | (w > 0 ? here[w - 1] >> 63 : 0);
+                    uint64_t right = (here[w] >> 1) | (w + 1 < STRIDE ? here[w + 1] << 63 : 0);
+                    out[w] = above[w] | here[w] | below[w] | left | right;
+                    any |= out[w];
+                }
+                ctx.rowIrregular[y] = any != 0;
+            }
+
+            ctx.irregular[Map::TerrainPlanes::Word(goalX, goalY)] |= Map::TerrainPlanes::Bit(goalX);
+            ctx.rowIrregular[goalY] = 1;
+        }
+
+        SearchContext& ctx;
+        const StepCost& step;
+        JumpTable& table;
+    };
+
+    // Rebuilds the cell path from the jump point chain; consecutive jump
+    // points share a row or a column, so the cells between are filled in.
+    static void ReconstructJumps(int sx, int sy, int gx, int gy,
+        const SearchContext& ctx, std::vector<Cell>& out)
+    {
+        out.clear();
+        int cur = idx(gx, gy);
+        int start = idx(sx, sy);
+        out.emplace_back(gx, gy);
+        while (cur != start) {
+            int prev = ctx.came[cur];
+            int x = cur % Map::W, y = cur / Map::W;
+            int px = prev % Map::W, py = prev / Map::W;
+            int dx = (px > x) - (px < x);
+            int dy = (py > y) - (py < y);
+            while (x != px || y != py) {
+                x += dx;
+                y += dy;
+                out.emplace_back(x, y);
+            }
+            cur = prev;
+        }
+        std::reverse(out.begin(), out.end());
+    }
+
+    static bool JumpPointSearch(int sx, int sy, int gx, int gy, const StepCost& step, std::vector<Cell>& out)
+    {
+        SearchContext& ctx = Context();
+        ctx.Begin();
+        JumpPointSearcher jps(ctx, step, gx, gy);
+        const Map::TerrainPlanes& planes = Map::Planes();
+
+        int s = idx(sx, sy);
+        ctx.SetG(s, 0.0, -1);
+        ctx.Push({ sx, sy, 0.0, Heuristic(sx, sy, gx, gy) });
+
+        while (!ctx.open.empty())
+        {
+            Node cur = ctx.Pop();
+
+            int ci = idx(cur.x, cur.y);
+            if (ctx.IsClosed(ci)) continue;
+            ctx.Close(ci);
+
+            if (cur.x == gx && cur.y == gy)
+            {
+                ReconstructJumps(sx, sy, gx, gy, ctx, out);
+                return true;
+            }
+
+            // A regular cell reached by a jump never turns back toward its parent
+            bool irregular = jps.Irregular(cur.x, cur.y);
+            int from = ctx.came[ci];
+            int pdx = 0, pdy = 0;
+            if (from != -1 && !irregular) {
+                pdx = (cur.x > from % Map::W) - (cur.x < from % Map::W);
+                pdy = (cur.y > from / Map::W) - (cur.y < from / Map::W);
+            }
+
+            for (int k = 0; k < 4; ++k)
+            {
+                int dx = JUMP_DX[k];
+                int dy = JUMP_DY[k];
+                if ((pdx != 0 || pdy != 0) && dx == -pdx && dy == -pdy) continue;
+                if (!planes.Walkable(cur.x + dx, cur.y + dy)) continue;
+
+                // Irregular cells step to their neighbours like A*
+                int steps = 1;
+                int ji = irregular ? idx(cur.x + dx, cur.y + dy) : jps.Jump(cur.x, cur.y, dx, dy, steps);
+                if (ji == -1 || ctx.IsClosed(ji)) continue;
+
+                // Every cell before the jump point is regular and costs exactly 1
+                int jx = ji % Map::W;
+                int jy = ji / Map::W;
+                double tentative = ctx.G(ci) + (steps - 1) + jps.Cost(jx, jy);
+                if (tentative < ctx.G(ji))
+                {
+                    ctx.SetG(ji, tentative, ci);
+                    ctx.Push({ jx, jy, tentative, tentative + Heuristic(jx, jy, gx, gy) });
+                }
+            }
+        }
+
+        return false;
+    }
+
+    // ---------------------------------------------------------
+    // Hierarchical search (HPA*)
+    // A* over the entrance graph of PathHierarchy, from the start cell to
+    // the entrances of its cluster, across clusters, and into the goal
+    // cell. The graph only knows step counts, so every step inside a
+    // cluster is charged 1 plus that cluster's mean extra cost for this
+    // query (computed for the clusters the search reaches). The chain of
+    // entrances is then refined leg by leg with A* confined to one cluster
+    // under the exact step cost. Paths are close to, not always, optimal.
+    // ---------------------------------------------------------
+
+    // Mean extra step cost over the walkable cells of a cluster, once per search
+    static double ClusterPenalty(SearchContext& ctx, int cluster, const StepCost& step)
+    {
+        if (ctx.penalty.empty()) {
+            ctx.penalty.resize(PathHierarchy::CLUSTER_COUNT);
+            ctx.penaltySeen.assign(PathHierarchy::CLUSTER_COUNT, 0);
+        }
+        if (ctx.penaltySeen[cluster] != ctx.generation) {
+            const Map::TerrainPlanes& planes = Map::Planes();
+            int x0, y0, x1, y1;
+            PathHierarchy::Bounds(cluster, x0, y0, x1, y1);
+            double extra = 0.0;
+            int cells = 0;
+            for (int y = y0; y <= y1; ++y) {
+                for (int x = x0; x <= x1; ++x) {
+                    if (!planes.Walkable(x, y)) continue;
+                    extra += step(x, y) - 1.0;
+                    ++cells;
+                }
+            }
+            ctx.penalty[cluster] = cells > 0 ? extra / cells : 0.0;
+            ctx.penaltySeen[cluster] = ctx.generation;
+        }
+        return ctx.penalty[cluster];
+    }
+
+    // A* from (ax,ay) to (bx,by) that never leaves the given cluster; appends
+    // the cells after (ax,ay) to 'out'
+    static bool RefineLeg(int ax, int ay, int bx, int by, int cluster, const StepCost& step, std::vector<Cell>& out)
+    {
+        SearchContext& ctx = Context();
+        ctx.Begin();
+        const Map::TerrainPlanes& planes = Map::Planes();
+        int x0, y0, x1, y1;
+        PathHierarchy::Bounds(cluster, x0, y0, x1, y1);
+
+        ctx.SetG(idx(ax, ay), 0.0, -1);
+        ctx.Push({ ax, ay, 0.0, Heuristic(ax, ay, bx, by) });
+
+        const int DX[4] = { +1, -1, 0, 0 };
+        const int DY[4] = { 0, 0, +1, -1 };
+
+        while (!ctx.open.empty())
+        {
+            Node cur = ctx.Pop();
+
+            int ci = idx(cur.x, cur.y);
+            if (ctx.IsClosed(ci)) continue;
+            ctx.Close(ci);
+
+            if (cur.x == bx && cur.y == by)
+            {
+                std::vector<Cell> leg;
+                Reconstruct(ax, ay, bx, by, ctx, leg);
+                out.insert(out.end(), leg.begin() + 1, leg.end());
+                return true;
+            }
+
+            for (int k = 0; k < 4; ++k)
+            {
+                int nx = cur.x + DX[k];
+                int ny = cur.y + DY[k];
+                if (nx < x0 || nx > x1 || ny < y0 || ny > y1) continue;
+                if (!planes.Walkable(nx, ny)) continue;
+
+                int ni = idx(nx, ny);
+                if (ctx.IsClosed(ni)) continue;
+
+                double tentative = ctx.G(ci) + step(nx, ny);
+                if (tentative < ctx.G(ni))
+                {
+                    ctx.SetG(ni, tentative, ci);
+                    ctx.Push({ nx, ny, tentative, tentative + Heuristic(nx, ny, bx, by) });
+                }
+            }
+        }
+        return false;
+    }
+
+    static bool HierarchicalSearch(int sx, int sy, int gx, int gy, const StepCost& step, std::vector<Cell>& out)
+    {
+        PathHierarchy& hierarchy = World::Current().pathHierarchy;
+        hierarchy.Refresh();
+
+        const int s = idx(sx, sy);
+        const int goal = idx(gx, gy);
+        const int goalCluster = PathHierarchy::ClusterOf(gx, gy);
+
+        std::vector<int> startDist, goalDist;
+        hierarchy.DistancesFrom(sx, sy, startDist);
+        hierarchy.DistancesFrom(gx, gy, goalDist);
+
+        SearchContext& ctx = Context();
+        ctx.Begin();
+
+        auto relax = [&](int from, int to, double cost) {
+            if (ctx.IsClosed(to)) return;
+            double tentative = ctx.G(from) + cost;
+            if (tentative < ctx.G(to)) {
+                int x = to % Map::W;
+                int y = to / Map::W;
+                ctx.SetG(to, tentative, from);
+                ctx.Push({ x, y, tentative, tentative + Heuristic(x, y, gx, gy) });
+            }
+        };
+        auto inside = [&](int cluster, int steps) {
+            return steps * (1.0 + ClusterPenalty(ctx, cluster, step));
+        };
+
+        ctx.SetG(s, 0.0, -1);
+        ctx.Push({ sx, sy, 0.0, Heuristic(sx, sy, gx, gy) });
+
+        bool found = false;
+        while (!ctx.open.empty())
+        {
+            Node cur = ctx.Pop();
+
+            int ci = idx(cur.x, cur.y);
+            if (ctx.IsClosed(ci)) continue;
+            ctx.Close(ci);
+
+            if (ci == goal) {
+                found = true;
+                break;
+            }
+
+            int cluster = PathHierarchy::ClusterOf(cur.x, cur.y);
+            const PathHierarchy::Cluster& c = hierarchy.Get(cluster);
+
+            if (ci == s) {
+                for (int node : c.nodes) {
+                    int d = startDist[PathHierarchy::LocalIndex(node % Map::W, node / Map::W)];
+                    if (d > 0) relax(ci, node, inside(cluster, d));
+                }
+                int d = startDist[PathHierarchy::LocalIndex(gx, gy)];
+                if (cluster == goalCluster && d >= 0) relax(ci, goal, inside(cluster, d));
+            }
+
+            int slot = (int)(std::find(c.nodes.begin(), c.nodes.end(), ci) - c.nodes.begin());
+            if (slot == (int)c.nodes.size()) continue;
+
+            for (int other = 0; other < (int)c.nodes.size(); ++other) {
+                int d = c.Distance(slot, other);
+                if (d > 0) relax(ci, c.nodes[other], inside(cluster, d));
+            }
+            for (const auto& link : c.links) {
+                if (link.first == slot) relax(ci, link.second, step(link.second % Map::W, link.second / Map::W));
+            }
+            if (cluster == goalCluster) {
+                int d = goalDist[PathHierarchy::LocalIndex(cur.x, cur.y)];
+                if (d >= 0) relax(ci, goal, inside(cluster, d));
+            }
+        }
+        if (!found) return false;
+
+        // Entrance chain, start first; consecutive cells share a cluster or a border
+        std::vector<int> waypoints;
+        for (int cell = goal; cell != -1; cell = ctx.came[cell]) {
+            waypoints.push_back(cell);
+            if (cell == s) break;
         }
+        std::reverse(waypoints.begin(), waypoints.end());
 
-        const int N = Map::W * Map::H;
-        const double INF = std::numeric_limits<double>::infinity();
+        out.clear();
+        out.emplace_back(sx, sy);
+        for (size_t i = 1; i < waypoints.size(); ++i) {
+            int ax = waypoints[i - 1] % Map::W, ay = waypoints[i - 1] / Map::W;
+            int bx = waypoints[i] % Map::W, by = waypoints[i] / Map::W;
+            if (std::abs(ax - bx) + std::abs(ay - by) == 1) {
+                out.emplace_back(bx, by);
+            }
+            else if (!RefineLeg(ax, ay, bx, by, PathHierarchy::ClusterOf(ax, ay), step, out)) {
+                return false;
+            }
+        }
+        LOG_DEBUG(Path, "Hierarchical path: %zu entrances, length = %zu", waypoints.size() - 2, out.size());
+        return true;
+    }
 
-        std::vector<double> gscore(N, INF);
-        std::vector<double> fscore(N, INF);
-        std::vector<int> came(N, -1);
-        std::vector<char> closed(N, 0);
+    // Whether a query in hierarchical mode should use the cluster graph;
+    // nearby goals are cheaper to reach with a single A*
+    static bool UseHierarchy(int sx, int sy, int gx, int gy)
+    {
+        return GetSearchMode() == SearchMode::Hierarchical &&
+            Heuristic(sx, sy, gx, gy) > 2 * PathHierarchy::CLUSTER;
+    }
 
-        std::priority_queue<Node> open;
+    // Plain A*: every step costs 1 plus occupancy and dynamic penalties
+    static bool AStarPath(int sx, int sy, int gx, int gy, std::vector<Cell>& out, int ignoreNpcId)
+    {
+        SearchContext& ctx = Context();
+        ctx.Begin();
+        const Map::TerrainPlanes& planes = Map::Planes();
 
         int s = idx(sx, sy);
-        int g = idx(gx, gy);
 
-        gscore[s] = 0.0;
-        fscore[s] = Heuristic(sx, sy, gx, gy);
-        open.push({ sx, sy, 0.0, fscore[s] });
+        ctx.SetG(s, 0.0, -1);
+        ctx.Push({ sx, sy, 0.0, Heuristic(sx, sy, gx, gy) });
 
         const int DX[4] = { +1, -1, 0, 0 };
         const int DY[4] = { 0, 0, +1, -1 };
 
-        while (!open.empty())
+        while (!ctx.open.empty())
         {
-            Node cur = open.top();
-            open.pop();
+            Node cur = ctx.Pop();
 
             int ci = idx(cur.x, cur.y);
-            if (closed[ci]) continue;
-            closed[ci] = 1;
+            if (ctx.IsClosed(ci)) continue;
+            ctx.Close(ci);
 
             if (cur.x == gx && cur.y == gy)
             {
-                Reconstruct(sx, sy, gx, gy, came, out);
-                printf("  Path found! length = %zu (from %d,%d to %d,%d)\n",
-                    out.size(), sx, sy, gx, gy);
+                Reconstruct(sx, sy, gx, gy, ctx, out);
                 return true;
             }
 
@@ -105,27 +688,56 @@ bool FindPath(int sx, int sy, int gx, int gy, std::vector<std::pair<int, int>>&
             {
                 int nx = cur.x + DX[k];
                 int ny = cur.y + DY[k];
-                if (!Map::InBounds(nx, ny)) continue;
-                if (!Map::IsWalkable(nx, ny)) continue;
+                if (!planes.Walkable(nx, ny)) continue;   // border cells are never walkable
 
                 int ni = idx(nx, ny);
-                if (closed[ni]) continue;
+                if (ctx.IsClosed(ni)) continue;
 
                 double occupancyPenalty = Map::GetOccupancyPenalty(nx, ny, ignoreNpcId);
-                double tentative = gscore[ci] + 1.0 + occupancyPenalty + Map::GetDynamicCost(nx, ny);
+                double tentative = ctx.G(ci) + 1.0 + occupancyPenalty + Map::GetDynamicCost(nx, ny);
 
-                if (tentative < gscore[ni])
+                if (tentative < ctx.G(ni))
                 {
-                    came[ni] = ci;
-                    gscore[ni] = tentative;
-                    fscore[ni] = tentative + Heuristic(nx, ny, gx, gy);
-                    open.push({ nx, ny, gscore[ni], fscore[ni] });
+                    ctx.SetG(ni, tentative, ci);
+                    ctx.Push({ nx, ny, tentative, tentative + Heuristic(nx, ny, gx, gy) });
                 }
             }
         }
 
+        return false;
+    }
+
+bool FindPath(int sx, int sy, int gx, int gy, std::vector<std::pair<int, int>>& out, int ignoreNpcId)
+    {
+        //  Basic guards 
+        if (!Map::InBounds(sx, sy) || !Map::InBounds(gx, gy)) {
+            LOG_WARN(Path, "Pathfinding: start or goal out of bounds.");
+            return false;
+        }
+        if (!Map::IsWalkable(sx, sy)) {
+            LOG_WARN(Path, "Pathfinding: start not walkable (%d,%d)", sx, sy);
+            return false;
+        }
+        if (!Map::IsWalkable(gx, gy)) {
+        LOG_DEBUG(Path, "Pathfinding: goal not walkable (%d,%d) - will try nearby.", gx, gy);
+        }
+
+        StepCost step{ 0.0, TeamId::Orange, ignoreNpcId };
+        bool found;
+        {
+            SearchTally tally;
+            if (GetSearchMode() == SearchMode::JumpPoint) found = JumpPointSearch(sx, sy, gx, gy, step, out);
+            else if (UseHierarchy(sx, sy, gx, gy)) found = HierarchicalSearch(sx, sy, gx, gy, step, out);
+            else found = AStarPath(sx, sy, gx, gy, out, ignoreNpcId);
+        }
+        if (found) {
+            LOG_DEBUG(Path, "Path found! length = %zu (from %d,%d to %d,%d)",
+                out.size(), sx, sy, gx, gy);
+            return true;
+        }
+
         //  No path found: try nearby cells as fallback 
-        printf(" No path found from (%d,%d) to (%d,%d). Trying nearby cells...\n",
+        LOG_DEBUG(Path, "No path found from (%d,%d) to (%d,%d). Trying nearby cells...",
             sx, sy, gx, gy);
 
         double bestDist = 1e9;
@@ -152,11 +764,11 @@ bool FindPath(int sx, int sy, int gx, int gy, std::vector<std::pair<int, int>>&
 
         if (bestX != gx || bestY != gy)
         {
-            printf(" Trying alternate goal near (%d,%d) -> (%d,%d)\n", gx, gy, bestX, bestY);
+            LOG_DEBUG(Path, "Trying alternate goal near (%d,%d) -> (%d,%d)", gx, gy, bestX, bestY);
             return FindPath(sx, sy, bestX, bestY, out, ignoreNpcId);
         }
 
-        printf(" No reachable area found around (%d,%d)\n", gx, gy);
+        LOG_WARN(Path, "No reachable area found around (%d,%d)", gx, gy);
         return false;
     }
 
@@ -171,7 +783,9 @@ bool FindPath(int sx, int sy, int gx, int gy, std::vector<std::pair<int, int>>&
         };
 
         std::queue<BFSNode> q;
-        std::vector<char> visited(Map::W * Map::H, 0);
+        SearchContext& ctx = Context();
+        ctx.Begin();
+        const Map::TerrainPlanes& planes = Map::Planes();
         
         const int DX[8] = { +1, -1, 0, 0, +1, +1, -1, -1 };  // 4-direction + diagonals
         const int DY[8] = { 0, 0, +1, -1, +1, -1, +1, -1 };
@@ -181,7 +795,7 @@ bool FindPath(int sx, int sy, int gx, int gy, std::vector<std::pair<int, int>>&
         int bestDist = 999999;
 
         q.push({ sx, sy, 0 });
-        visited[idx(sx, sy)] = 1;
+        ctx.Close(idx(sx, sy));
 
         bool hasFallback = false;
         double fallbackSafety = 1.0;
@@ -196,7 +810,7 @@ bool FindPath(int sx, int sy, int gx, int gy, std::vector<std::pair<int, int>>&
             if (cur.dist > searchRadius) continue;
 
             // Check if this cell is a good cover point
-            if (Map::IsWalkable(cur.x, cur.y))
+            if (planes.Walkable(cur.x, cur.y))
             {
                 double security = Map::GetSecurityValue(cur.y, cur.x, team);
                 double occupancyPenalty = Map::GetOccupancyPenalty(cur.x, cur.y);
@@ -247,13 +861,12 @@ bool FindPath(int sx, int sy, int gx, int gy, std::vector<std::pair<int, int>>&
             {
                 int nx = cur.x + DX[k];
                 int ny = cur.y + DY[k];
-                if (!Map::InBounds(nx, ny)) continue;
-                
+                if (!planes.Walkable(nx, ny)) continue;
+
                 int ni = idx(nx, ny);
-                if (visited[ni]) continue;
-                if (!Map::IsWalkable(nx, ny)) continue;
+                if (ctx.IsClosed(ni)) continue;
 
-                visited[ni] = 1;
+                ctx.Close(ni);
                 q.push({ nx, ny, cur.dist + 1 });
             }
         }
@@ -261,63 +874,55 @@ bool FindPath(int sx, int sy, int gx, int gy, std::vector<std::pair<int, int>>&
         if (bestX != -1 && bestY != -1)
         {
             out = { bestX, bestY };
-            printf("  Found cover point at (%d,%d) with safety=%.2f\n", bestX, bestY, bestSafety);
+            LOG_DEBUG(Path, "Found cover point at (%d,%d) with safety=%.2f", bestX, bestY, bestSafety);
             return true;
         }
 
         if (hasFallback) {
             out = { fallbackX, fallbackY };
-            printf("  Using fallback cover at (%d,%d) with safety=%.2f\n", fallbackX, fallbackY, fallbackSafety);
+            LOG_DEBUG(Path, "Using fallback cover at (%d,%d) with safety=%.2f", fallbackX, fallbackY, fallbackSafety);
             return true;
         }
 
-        printf("  No cover point found within radius %d\n", searchRadius);
+        LOG_DEBUG(Path, "No cover point found within radius %d", searchRadius);
         return false;
     }
 
     // A* with security map consideration
-    bool FindSafePath(int sx, int sy, int gx, int gy, TeamId team, std::vector<Cell>& out, double securityWeight, int ignoreNpcId)
+    // Similar to FindPath but adds security cost to edge weights
+    static bool SafePath(int sx, int sy, int gx, int gy, TeamId team, std::vector<Cell>& out, double securityWeight, int ignoreNpcId)
     {
-        // Similar to FindPath but adds security cost to edge weights
-        if (!Map::InBounds(sx, sy) || !Map::InBounds(gx, gy)) {
-            return false;
+        SearchTally tally;
+        if (GetSearchMode() == SearchMode::JumpPoint) {
+            return JumpPointSearch(sx, sy, gx, gy, StepCost{ securityWeight, team, ignoreNpcId }, out);
         }
-        if (!Map::IsWalkable(sx, sy)) {
-            return false;
+        if (UseHierarchy(sx, sy, gx, gy)) {
+            return HierarchicalSearch(sx, sy, gx, gy, StepCost{ securityWeight, team, ignoreNpcId }, out);
         }
 
-        const int N = Map::W * Map::H;
-        const double INF = std::numeric_limits<double>::infinity();
-
-        std::vector<double> gscore(N, INF);
-        std::vector<double> fscore(N, INF);
-        std::vector<int> came(N, -1);
-        std::vector<char> closed(N, 0);
-
-        std::priority_queue<Node> open;
+        SearchContext& ctx = Context();
+        ctx.Begin();
+        const Map::TerrainPlanes& planes = Map::Planes();
 
         int s = idx(sx, sy);
-        int g = idx(gx, gy);
 
-        gscore[s] = 0.0;
-        fscore[s] = Heuristic(sx, sy, gx, gy);
-        open.push({ sx, sy, 0.0, fscore[s] });
+        ctx.SetG(s, 0.0, -1);
+        ctx.Push({ sx, sy, 0.0, Heuristic(sx, sy, gx, gy) });
 
         const int DX[4] = { +1, -1, 0, 0 };
         const int DY[4] = { 0, 0, +1, -1 };
 
-        while (!open.empty())
+        while (!ctx.open.empty())
         {
-            Node cur = open.top();
-            open.pop();
+            Node cur = ctx.Pop();
 
             int ci = idx(cur.x, cur.y);
-            if (closed[ci]) continue;
-            closed[ci] = 1;
+            if (ctx.IsClosed(ci)) continue;
+            ctx.Close(ci);
 
             if (cur.x == gx && cur.y == gy)
             {
-                Reconstruct(sx, sy, gx, gy, came, out);
+                Reconstruct(sx, sy, gx, gy, ctx, out);
                 return true;
             }
 
@@ -325,29 +930,49 @@ bool FindPath(int sx, int sy, int gx, int gy, std::vector<std::pair<int, int>>&
             {
                 int nx = cur.x + DX[k];
                 int ny = cur.y + DY[k];
-                if (!Map::InBounds(nx, ny)) continue;
-                if (!Map::IsWalkable(nx, ny)) continue;
+                if (!planes.Walkable(nx, ny)) continue;   // border cells are never walkable
 
                 int ni = idx(nx, ny);
-                if (closed[ni]) continue;
+                if (ctx.IsClosed(ni)) continue;
 
                 // Base cost + security penalty
                 double security = Map::GetSecurityValue(ny, nx, team);
                 double occupancyPenalty = Map::GetOccupancyPenalty(nx, ny, ignoreNpcId);
                 double extraCost = Map::GetDynamicCost(nx, ny);
                 double edgeCost = 1.0 + securityWeight * security * 10.0 + occupancyPenalty + extraCost;
-                double tentative = gscore[ci] + edgeCost;
+                double tentative = ctx.G(ci) + edgeCost;
 
-                if (tentative < gscore[ni])
+                if (tentative < ctx.G(ni))
                 {
-                    came[ni] = ci;
-                    gscore[ni] = tentative;
-                    fscore[ni] = tentative + Heuristic(nx, ny, gx, gy);
-                    open.push({ nx, ny, gscore[ni], fscore[ni] });
+                    ctx.SetG(ni, tentative, ci);
+                    ctx.Push({ nx, ny, tentative, tentative + Heuristic(nx, ny, gx, gy) });
                 }
             }
         }
 
         return false;
     }
+
+    bool FindSafePath(int sx, int sy, int gx, int gy, TeamId team, std::vector<Cell>& out, double securityWeight, int ignoreNpcId)
+    {
+        if (!Map::InBounds(sx, sy) || !Map::InBounds(gx, gy)) {
+            return false;
+        }
+        if (!Map::IsWalkable(sx, sy)) {
+            return false;
+        }
+
+        PathCache& cache = World::Current().pathCache;
+        if (!cache.IsEnabled()) {
+            return SafePath(sx, sy, gx, gy, team, out, securityWeight, ignoreNpcId);
+        }
+        if (cache.Lookup(sx, sy, gx, gy, team, securityWeight, out)) {
+            return true;
+        }
+        if (!SafePath(sx, sy, gx, gy, team, out, securityWeight, ignoreNpcId)) {
+            return false;
+        }
+        cache.Store(team, securityWeight, out);
+        return true;
+    }
 }
@@ -8,6 +8,17 @@ namespace Path
     // A single grid coordinate (integer cell)
     using Cell = std::pair<int, int>; // {x, y}
 
+    // Search used by FindPath and FindSafePath
+    enum class SearchMode {
+        AStar,          // expands every 4-connected neighbour
+        JumpPoint,      // jump point search across cells that cost exactly 1, A* elsewhere
+        Hierarchical    // HPA* over map clusters for distant goals (near-optimal)
+    };
+
+    // Selects the search of the current world (takes effect on the next query)
+    void SetSearchMode(SearchMode mode);
+    SearchMode GetSearchMode();
+
     // Find a path on the logical map from (sx,sy) to (gx,gy).
     // Returns true if a path was found; 
     bool FindPath(int sx, int sy, int gx, int gy, std::vector<Cell>& out, int ignoreNpcId = -1);
@@ -0,0 +1,114 @@
+#include <algorithm>
+#include <cmath>
+#include "Profiler.h"
+#include "World.h"
+
+namespace Profile
+{
+    const char* StageName(Stage stage)
+    {
+        switch (stage) {
+        case Stage::Agents: return "agents";
+        case Stage::SecurityMaps: return "security";
+        case Stage::VisibilityOrange: return "visOrange";
+        case Stage::VisibilityBlue: return "visBlue";
+        case Stage::Commanders: return "commanders";
+        case Stage::Gunshots: return "gunshots";
+        case Stage::Grenades: return "grenades";
+        case Stage::DecayCosts: return "decay";
+        case Stage::PathRequests: return "pathRequests";
+        case Stage::Tick: return "tick";
+        default: return "?";
+        }
+    }
+
+    Scope::~Scope()
+    {
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        World::Current().profiler.Add(stage, us);
+    }
+}
+
+void TickProfiler::BeginTick()
+{
+    current = Row();
+    searches = 0;
+    expanded = 0;
+}
+
+void TickProfiler::Add(Profile::Stage stage, double us)
+{
+    current.us[(int)stage] += us;
+}
+
+void TickProfiler::AddSearch(long long nodes)
+{
+    searches.fetch_add(1, std::memory_order_relaxed);
+    expanded.fetch_add(nodes, std::memory_order_relaxed);
+}
+
+void TickProfiler::TakeSearches(TickProfiler& from)
+{
+    searches.fetch_add(from.searches.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+    expanded.fetch_add(from.expanded.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+void TickProfiler::EndTick(long long tick)
+{
+    current.tick = tick;
+    current.searches = searches.exchange(0, std::memory_order_relaxed);
+    current.expanded = expanded.exchange(0, std::memory_order_relaxed);
+    rows[next] = current;
+    next = (next + 1) % WINDOW;
+    filled = std::min(filled + 1, WINDOW);
+    current = Row();
+}
+
+void TickProfiler::Clear()
+{
+    current = Row();
+    next = 0;
+    filled = 0;
+    searches = 0;
+    expanded = 0;
+}
+
+const TickProfiler::Row& TickProfiler::Last() const
+{
+    return rows[(next + WINDOW - 1) % WINDOW];
+}
+
+template <typename Get>
+TickProfiler::Stats TickProfiler::Summarize(Get get) const
+{
+    Stats stats;
+    if (filled == 0) return stats;
+
+    double values[WINDOW];
+    double sum = 0.0;
+    for (int i = 0; i < filled; ++i) {
+        values[i] = get(rows[i]);
+        sum += values[i];
+    }
+    int p99 = std::max(0, (int)std::ceil(filled * 0.99) - 1);
+    std::nth_element(values, values + p99, values + filled);
+    stats.p99 = values[p99];
+    stats.min = *std::min_element(values, values + filled);
+    stats.avg = sum / filled;
+    return stats;
+}
+
+TickProfiler::Stats TickProfiler::StageStats(Profile::Stage stage) const
+{
+    return Summarize([stage](const Row& r) { return r.us[(int)stage]; });
+}
+
+TickProfiler::Stats TickProfiler::SearchStats() const
+{
+    return Summarize([](const Row& r) { return (double)r.searches; });
+}
+
+TickProfiler::Stats TickProfiler::ExpandedStats() const
+{
+    return Summarize([](const Row& r) { return (double)r.expanded; });
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+
+// ---------------------------------------------------------
+// TickProfiler - wall time of each simulation stage, per tick
+// Simulation::Step opens a tick with BeginTick, times its stages with
+// Profile::Scope and closes it with EndTick; the last WINDOW ticks are
+// kept for rolling min / avg / p99 (HUD, Headless summary). Path searches
+// report themselves with AddSearch, which is safe from worker threads;
+// PathService hands the searches of its workers to the live world when it
+// collects them, so those count in the tick their routes arrive.
+// ---------------------------------------------------------
+namespace Profile
+{
+    enum class Stage : unsigned char {
+        Agents,             // NPC work, FSM transitions, idle motion
+        SecurityMaps,
+        VisibilityOrange,
+        VisibilityBlue,
+        Commanders,         // PlanAndAssignOrders
+        Gunshots,
+        Grenades,
+        DecayCosts,
+        PathRequests,       // PathService::Update
+        Tick,               // the whole Step
+        Count
+    };
+    static const int STAGE_COUNT = (int)Stage::Count;
+
+    const char* StageName(Stage stage);
+
+    // Adds the time until the end of the scope to a stage of the current world's profiler
+    class Scope {
+    public:
+        explicit Scope(Stage stage) : stage(stage), start(std::chrono::steady_clock::now()) {}
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        Stage stage;
+        std::chrono::steady_clock::time_point start;
+    };
+}
+
+class TickProfiler {
+public:
+    static constexpr int WINDOW = 300;  // 5 s of ticks
+
+    // One finished tick
+    struct Row {
+        long long tick = 0;
+        double us[Profile::STAGE_COUNT] = {};   // microseconds per stage
+        long long searches = 0;                 // FindPath / FindSafePath searches
+        long long expanded = 0;                 // nodes they expanded
+    };
+
+    struct Stats {
+        double min = 0.0, avg = 0.0, p99 = 0.0;
+    };
+
+    // Drops anything recorded since the last tick (setup outside Step)
+    void BeginTick();
+    void Add(Profile::Stage stage, double us);
+    // One path search that expanded 'expanded' nodes (any thread)
+    void AddSearch(long long expanded);
+    // Moves the search counts of another profiler (a path worker snapshot) into this tick
+    void TakeSearches(TickProfiler& from);
+    void EndTick(long long tick);
+    void Clear();
+
+    int Count() const { return filled; }        // ticks in the window
+    const Row& Last() const;                    // the latest finished tick
+    Stats StageStats(Profile::Stage stage) const;
+    Stats SearchStats() const;
+    Stats ExpandedStats() const;
+
+private:
+    template <typename Get>
+    Stats Summarize(Get get) const;
+
+    Row current;
+    Row rows[WINDOW];
+    int next = 0;
+    int filled = 0;
+    std::atomic<long long> searches{ 0 };
+    std::atomic<long long> expanded{ 0 };
+};
@@ -0,0 +1,17 @@
+#include "Snapshot.h"
+#include "RenderBatch.h"
+
+// Grenade shards from a FrameSnapshot - only linked into the GLUT frontend
+
+void DrawGrenadeShards(const FrameSnapshot& snapshot)
+{
+    // Diamond of two triangles per moving shard
+    const TeamColor red{ 1.0, 0.0, 0.0 };
+    RenderBatch& batch = RenderBatch::Frame();
+    for (const std::pair<double, double>& shard : snapshot.shards) {
+        double x = shard.first;
+        double y = shard.second;
+        batch.Triangle(x - 0.5, y, x, y + 0.5, x + 0.5, y, red);
+        batch.Triangle(x - 0.5, y, x + 0.5, y, x, y - 0.5, red);
+    }
+}
@@ -0,0 +1,48 @@
+#include <cmath>
+#include "RayTable.h"
+#include "Definitions.h"
+
+namespace Map {
+
+    static_assert(W <= 256 && H <= 256, "RayTable stores coordinates as bytes");
+
+    // Walks one axis of every ray from every origin exactly like the old casters
+    static void BuildAxis(int numRays, int maxRange, int extent, bool vertical,
+        std::vector<unsigned char>& cells, std::vector<int>& steps)
+    {
+        cells.assign((size_t)extent * numRays * maxRange, 0);
+        steps.assign((size_t)extent * numRays, maxRange);
+
+        for (int origin = 0; origin < extent; ++origin) {
+            for (int r = 0; r < numRays; ++r) {
+                double ang = (2.0 * M_PI * r) / (double)numRays;
+                double d = vertical ? std::sin(ang) : std::cos(ang);
+
+                double f = origin + 0.5;
+                unsigned char* out = &cells[((size_t)origin * numRays + r) * maxRange];
+                for (int step = 0; step < maxRange; ++step) {
+                    f += d;
+                    int c = (int)std::floor(f);
+                    if (c < 0 || c >= extent) {
+                        steps[(size_t)origin * numRays + r] = step;
+                        break;
+                    }
+                    out[step] = (unsigned char)c;
+                }
+            }
+        }
+    }
+
+    RayTable::RayTable(int numRays, int maxRange)
+        : numRays(numRays), maxRange(maxRange)
+    {
+        BuildAxis(numRays, maxRange, W, false, xCells, xSteps);
+        BuildAxis(numRays, maxRange, H, true, yCells, ySteps);
+    }
+
+    const RayTable& RayTable::Standard()
+    {
+        static const RayTable table(72, 35);
+        return table;
+    }
+}
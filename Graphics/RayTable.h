@@ -0,0 +1,40 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include "Map.h"
+
+namespace Map {
+
+    // ---------------------------------------------------------
+    // RayTable - precomputed cells visited by the fixed-angle raycasts
+    // Ray r starts at the centre of the origin cell and advances one cell
+    // length per step at angle 2*pi*r/numRays. The table stores the absolute
+    // column (row) reached at every step for every origin column (row).
+    // Built with the same floating-point stepping the casters used, so
+    // casts stay bit-identical, but casting needs no trig and no floor.
+    // ---------------------------------------------------------
+    class RayTable {
+    public:
+        RayTable(int numRays, int maxRange);
+
+        int NumRays() const { return numRays; }
+        int MaxRange() const { return maxRange; }
+
+        // Steps of ray r from (sx,sy) before it leaves the map (at most MaxRange)
+        int StepsInBounds(int sx, int sy, int r) const {
+            return std::min(xSteps[sx * numRays + r], ySteps[sy * numRays + r]);
+        }
+        // Columns / rows reached by ray r from column sx / row sy, indexed by step
+        const unsigned char* Columns(int sx, int r) const { return &xCells[(sx * numRays + r) * maxRange]; }
+        const unsigned char* Rows(int sy, int r) const { return &yCells[(sy * numRays + r) * maxRange]; }
+
+        // Shared table for the security and visibility casts (72 rays, 35 cells)
+        static const RayTable& Standard();
+
+    private:
+        int numRays;
+        int maxRange;
+        std::vector<unsigned char> xCells, yCells;
+        std::vector<int> xSteps, ySteps;
+    };
+}
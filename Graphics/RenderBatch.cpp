@@ -0,0 +1,218 @@
+#include "RenderBatch.h"
+
+static GLubyte ToByte(double v)
+{
+    if (v <= 0.0) return 0;
+    if (v >= 1.0) return 255;
+    return (GLubyte)(v * 255.0 + 0.5);
+}
+
+void RenderBatch::Mesh::Add(double x, double y, const TeamColor& color)
+{
+    vertices.push_back((GLfloat)x);
+    vertices.push_back((GLfloat)y);
+    colors.push_back(ToByte(color.r));
+    colors.push_back(ToByte(color.g));
+    colors.push_back(ToByte(color.b));
+}
+
+void RenderBatch::Mesh::Draw(GLenum mode) const
+{
+    if (vertices.empty()) return;
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(2, GL_FLOAT, 0, vertices.data());
+    glColorPointer(3, GL_UNSIGNED_BYTE, 0, colors.data());
+    if (!texCoords.empty()) {
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glTexCoordPointer(2, GL_FLOAT, 0, texCoords.data());
+    }
+    glDrawArrays(mode, 0, (GLsizei)(vertices.size() / 2));
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+}
+
+void RenderBatch::Mesh::Clear()
+{
+    vertices.clear();
+    texCoords.clear();
+    colors.clear();
+}
+
+RenderBatch& RenderBatch::Frame()
+{
+    static RenderBatch batch;
+    return batch;
+}
+
+void* RenderBatch::GlutFont(Font font)
+{
+    return font == Font::Helvetica12 ? GLUT_BITMAP_HELVETICA_12 : GLUT_BITMAP_HELVETICA_10;
+}
+
+void RenderBatch::Prepare()
+{
+    if (!atlasTried) {
+        atlasTried = true;
+        BuildAtlas();
+    }
+}
+
+void RenderBatch::BuildAtlas()
+{
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    if (viewport[2] < ATLAS_W || viewport[3] < ATLAS_H) return;    // labels stay on glutBitmapCharacter
+
+    GLfloat clearColor[4];
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    glOrtho(0, viewport[2], 0, viewport[3], -1, 1);
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+
+    // White glyphs on black, one CELL x CELL cell each, pen at (PEN_X, PEN_Y) of the cell
+    glClearColor(0, 0, 0, 0);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glColor3d(1.0, 1.0, 1.0);
+    const int rowsPerFont = (CHAR_COUNT + CELLS_PER_ROW - 1) / CELLS_PER_ROW;
+    for (int f = 0; f < (int)Font::Count; ++f) {
+        void* font = GlutFont((Font)f);
+        for (int i = 0; i < CHAR_COUNT; ++i) {
+            int col = i % CELLS_PER_ROW;
+            int row = f * rowsPerFont + i / CELLS_PER_ROW;
+            glRasterPos2i(col * CELL + PEN_X, row * CELL + PEN_Y);
+            glutBitmapCharacter(font, FIRST_CHAR + i);
+            advance[f][i] = glutBitmapWidth(font, FIRST_CHAR + i);
+        }
+    }
+
+    // Intensity texture: glyph pixels 1, the rest 0 (cut by the alpha test)
+    glGenTextures(1, &atlas);
+    glBindTexture(GL_TEXTURE_2D, atlas);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glCopyTexImage2D(GL_TEXTURE_2D, 0, GL_INTENSITY, 0, 0, ATLAS_W, ATLAS_H, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glPopMatrix();
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+}
+
+void RenderBatch::Triangle(double ax, double ay, double bx, double by, double cx, double cy, const TeamColor& color)
+{
+    fills.Add(ax, ay, color);
+    fills.Add(bx, by, color);
+    fills.Add(cx, cy, color);
+}
+
+void RenderBatch::Quad(double x0, double y0, double x1, double y1, const TeamColor& color)
+{
+    Triangle(x0, y0, x1, y0, x1, y1, color);
+    Triangle(x0, y0, x1, y1, x0, y1, color);
+}
+
+void RenderBatch::Line(double ax, double ay, double bx, double by, const TeamColor& color, bool thick)
+{
+    Mesh& mesh = thick ? thickLines : lines;
+    mesh.Add(ax, ay, color);
+    mesh.Add(bx, by, color);
+}
+
+void RenderBatch::Outline(double x0, double y0, double x1, double y1, const TeamColor& color, bool thick)
+{
+    Line(x0, y0, x1, y0, color, thick);
+    Line(x1, y0, x1, y1, color, thick);
+    Line(x1, y1, x0, y1, color, thick);
+    Line(x0, y1, x0, y0, color, thick);
+}
+
+void RenderBatch::Text(double x, double y, Font font, const char* text, const TeamColor& color)
+{
+    labels.push_back({ x, y, font, text, color });
+}
+
+void RenderBatch::AddGlyphs(const Label& label, double unitsPerPixelX, double unitsPerPixelY)
+{
+    const int rowsPerFont = (CHAR_COUNT + CELLS_PER_ROW - 1) / CELLS_PER_ROW;
+    const double cellW = CELL * unitsPerPixelX;
+    const double cellH = CELL * unitsPerPixelY;
+    double penX = label.x;
+    for (const char* p = label.text.c_str(); *p != '\0'; ++p) {
+        int i = (unsigned char)*p - FIRST_CHAR;
+        if (i < 0 || i >= CHAR_COUNT) continue;
+        int col = i % CELLS_PER_ROW;
+        int row = (int)label.font * rowsPerFont + i / CELLS_PER_ROW;
+
+        double x0 = penX - PEN_X * unitsPerPixelX;
+        double y0 = label.y - PEN_Y * unitsPerPixelY;
+        GLfloat s0 = (GLfloat)(col * CELL) / ATLAS_W;
+        GLfloat t0 = (GLfloat)(row * CELL) / ATLAS_H;
+        GLfloat s1 = (GLfloat)((col + 1) * CELL) / ATLAS_W;
+        GLfloat t1 = (GLfloat)((row + 1) * CELL) / ATLAS_H;
+
+        glyphs.Add(x0, y0, label.color);
+        glyphs.Add(x0 + cellW, y0, label.color);
+        glyphs.Add(x0 + cellW, y0 + cellH, label.color);
+        glyphs.Add(x0, y0 + cellH, label.color);
+        const GLfloat st[8] = { s0, t0, s1, t0, s1, t1, s0, t1 };
+        glyphs.texCoords.insert(glyphs.texCoords.end(), st, st + 8);
+
+        penX += advance[(int)label.font][i] * unitsPerPixelX;
+    }
+}
+
+void RenderBatch::Flush()
+{
+    fills.Draw(GL_TRIANGLES);
+    lines.Draw(GL_LINES);
+    glLineWidth(3.0);
+    thickLines.Draw(GL_LINES);
+    glLineWidth(1.0);
+
+    if (atlas != 0) {
+        // Pixel size in map units, from the current projection (modelview is not scaled)
+        GLint viewport[4];
+        GLfloat projection[16];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        glGetFloatv(GL_PROJECTION_MATRIX, projection);
+        double unitsPerPixelX = 2.0 / (projection[0] * viewport[2]);
+        double unitsPerPixelY = 2.0 / (projection[5] * viewport[3]);
+        for (const Label& label : labels) {
+            AddGlyphs(label, unitsPerPixelX, unitsPerPixelY);
+        }
+
+        glEnable(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, atlas);
+        glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+        glEnable(GL_ALPHA_TEST);
+        glAlphaFunc(GL_GREATER, 0.5f);
+        glyphs.Draw(GL_QUADS);
+        glDisable(GL_ALPHA_TEST);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glDisable(GL_TEXTURE_2D);
+    }
+    else {
+        for (const Label& label : labels) {
+            glColor3d(label.color.r, label.color.g, label.color.b);
+            glRasterPos2d(label.x, label.y);
+            for (const char* p = label.text.c_str(); *p != '\0'; ++p) {
+                glutBitmapCharacter(GlutFont(label.font), *p);
+            }
+        }
+    }
+
+    fills.Clear();
+    lines.Clear();
+    thickLines.Clear();
+    glyphs.Clear();
+    labels.clear();
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "glut.h"
+#include "Roles.h"
+
+// ---------------------------------------------------------
+// RenderBatch - per-frame vertex arrays for agents, status bars and projectiles
+// The Show functions add fills, lines and labels here instead of issuing
+// immediate-mode primitives; Flush draws each kind with one glDrawArrays
+// (triangles, 1 px lines, 3 px lines, text quads), in that order. Labels
+// come from a glyph atlas: Prepare draws the GLUT bitmap fonts once into
+// the back buffer and copies them into a texture, so a character is four
+// vertices instead of a glutBitmapCharacter call. If the window is too
+// small for the atlas, labels fall back to glutBitmapCharacter.
+// Frontend only (OpenGL 1.1).
+// ---------------------------------------------------------
+class RenderBatch {
+public:
+    enum class Font { Helvetica10, Helvetica12, Count };
+
+    // The batch the window draws with
+    static RenderBatch& Frame();
+
+    // Call before glClear: builds the atlas the first time
+    void Prepare();
+
+    void Triangle(double ax, double ay, double bx, double by, double cx, double cy, const TeamColor& color);
+    void Quad(double x0, double y0, double x1, double y1, const TeamColor& color);   // axis aligned
+    void Line(double ax, double ay, double bx, double by, const TeamColor& color, bool thick = false);
+    void Outline(double x0, double y0, double x1, double y1, const TeamColor& color, bool thick = false);
+    // Text whose first pen position is (x, y), as with glRasterPos
+    void Text(double x, double y, Font font, const char* text, const TeamColor& color);
+
+    // Draws everything added since the last Flush and empties the batch
+    void Flush();
+
+private:
+    static const int ATLAS_W = 512;
+    static const int ATLAS_H = 128;
+    static const int CELL = 16;             // atlas cell per glyph, in pixels
+    static const int PEN_X = 2;             // pen position inside a cell
+    static const int PEN_Y = 4;
+    static const int FIRST_CHAR = 32;
+    static const int CHAR_COUNT = 95;       // printable ASCII
+    static const int CELLS_PER_ROW = ATLAS_W / CELL;
+
+    // Vertex arrays of one primitive kind
+    struct Mesh {
+        std::vector<GLfloat> vertices;      // x, y
+        std::vector<GLfloat> texCoords;     // s, t (text only)
+        std::vector<GLubyte> colors;        // r, g, b
+
+        void Add(double x, double y, const TeamColor& color);
+        void Draw(GLenum mode) const;
+        void Clear();
+    };
+
+    struct Label {
+        double x, y;
+        Font font;
+        std::string text;
+        TeamColor color;
+    };
+
+    static void* GlutFont(Font font);
+    void BuildAtlas();
+    void AddGlyphs(const Label& label, double unitsPerPixelX, double unitsPerPixelY);
+
+    Mesh fills;
+    Mesh lines;
+    Mesh thickLines;
+    Mesh glyphs;
+    std::vector<Label> labels;
+    GLuint atlas = 0;
+    bool atlasTried = false;
+    int advance[(int)Font::Count][CHAR_COUNT] = {};
+};
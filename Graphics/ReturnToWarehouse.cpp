@@ -1,37 +1,37 @@
 #include "ReturnToWarehouse.h"
+#include "StatePool.h"
 #include "NPC.h"
 #include "Map.h"
 #include "Pathfinding.h"
+#include "FlowField.h"
+#include "PathService.h"
 #include "Definitions.h"
+#include "World.h"
 #include "GoToSupply.h"
 #include "GoToMedSupply.h"
 #include "GoToHeal.h"
-#include <stdio.h>
+#include "Log.h"
 #include <cmath>
-#include <ctime>
+#include "SimClock.h"
 #include <cstdlib>
 #include <vector>
 #include <limits>
 
-extern std::vector<NPC*> teamOrange;
-extern std::vector<NPC*> teamBlue;
-
 namespace {
     constexpr double REPATH_INTERVAL = 2.0;
 
     double NowSeconds() {
-        return clock() / static_cast<double>(CLOCKS_PER_SEC);
+        return SimClock::Now();
     }
 
     double RandomRange(double minValue, double maxValue) {
         if (maxValue <= minValue) return minValue;
-        double t = static_cast<double>(rand()) / static_cast<double>(RAND_MAX);
+        double t = static_cast<double>(World::Current().Random()) / static_cast<double>(World::RANDOM_MAX);
         return minValue + (maxValue - minValue) * t;
     }
 NPC* FindPriorityInjured(NPC* medic)
 {
-    const std::vector<NPC*>& myTeam =
-        (medic->getTeam() == TeamId::Orange) ? teamOrange : teamBlue;
+    const std::vector<NPC*>& myTeam = World::Current().Team(medic->getTeam());
 
     NPC* best = nullptr;
     int bestScore = std::numeric_limits<int>::max();
@@ -97,11 +97,11 @@ void ReturnToWarehouse::OnEnter(NPC* pn) {
     double now = lastRepathCheck;
     if (!StartRetreat(pn, now)) {
         PlanRouteToWarehouse(pn);
-        printf("[STATE] [%c] returning to warehouse hub (%d,%d).\n",
+        LOG_INFO(State, "[%c] returning to warehouse hub (%d,%d).",
             pn->getSymbol(), centerX, centerY);
     }
     else {
-        printf("[STATE] [%c] retreating from frontline before returning to warehouse.\n",
+        LOG_INFO(State, "[%c] retreating from frontline before returning to warehouse.",
             pn->getSymbol());
     }
 }
@@ -131,7 +131,7 @@ void ReturnToWarehouse::Transition(NPC* pn) {
         if (retreatDist2 <= arrivalRadius2 || !pn->getIsMoving()) {
             retreating = false;
             PlanRouteToWarehouse(pn);
-            printf("[STATE] [%c] retreat complete, heading to warehouse hub.\n", pn->getSymbol());
+            LOG_INFO(State, "[%c] retreat complete, heading to warehouse hub.", pn->getSymbol());
             return;
         }
 
@@ -158,7 +158,7 @@ void ReturnToWarehouse::Transition(NPC* pn) {
                 pn->setIsDelivering(false);
                 pn->setLowAmmo(false);
                 pn->setIsResting(true);
-                printf("[STATE] [%c] auto-refilled ammo crate at warehouse (%d,%d).\n",
+                LOG_INFO(State, "[%c] auto-refilled ammo crate at warehouse (%d,%d).",
                     pn->getSymbol(), wh.ammoX, wh.ammoY);
             }
 
@@ -167,12 +167,12 @@ void ReturnToWarehouse::Transition(NPC* pn) {
                 pn->ResetAssistCounter();
                 pn->setIsDelivering(false);
                 pn->setIsResting(true);
-                printf("[STATE] [%c] auto-refilled medical supplies at warehouse.\n", pn->getSymbol());
+                LOG_INFO(State, "[%c] auto-refilled medical supplies at warehouse.", pn->getSymbol());
 
                 NPC* nextPatient = FindPriorityInjured(pn);
                 if (nextPatient) {
                     pn->setTargetNPC(nextPatient);
-                    pn->setCurrentState(new GoToHeal());
+                    pn->setCurrentState(pn->getStatePool().Acquire<GoToHeal>());
                     pn->getCurrentState()->OnEnter(pn);
                     return;
                 }
@@ -211,23 +211,47 @@ void ReturnToWarehouse::OnExit(NPC* pn) {
     pn->setIsResting(false);
 }
 
-bool ReturnToWarehouse::PlanPathTo(NPC* pn, int gx, int gy) {
-    if (!pn) return false;
+void ReturnToWarehouse::PlanPathTo(NPC* pn, int gx, int gy, bool sharedGoal, void (ReturnToWarehouse::*failed)(NPC*)) {
+    if (!pn) return;
 
     int startX = static_cast<int>(std::round(pn->getX()));
     int startY = static_cast<int>(std::round(pn->getY()));
 
     std::vector<std::pair<int, int>> path;
-    bool foundPath =
-        Path::FindSafePath(startX, startY, gx, gy, pn->getTeam(), path, 0.4, pn->GetId()) ||
-        Path::FindSafePath(startX, startY, gx, gy, pn->getTeam(), path, 0.2, pn->GetId()) ||
-        Path::FindPath(startX, startY, gx, gy, path, pn->GetId());
-
-    if (foundPath && !path.empty()) {
+    if (sharedGoal && Path::FindFlowPath(startX, startY, gx, gy, pn->getTeam(), path, 0.4) && !path.empty()) {
         pn->SetPath(path);
-        return true;
+        return;
     }
-    return false;
+
+    Path::Request request;
+    request.sx = startX;
+    request.sy = startY;
+    request.gx = gx;
+    request.gy = gy;
+    request.team = pn->getTeam();
+    request.ignoreNpcId = pn->GetId();
+    request.safeWeights = { 0.4, 0.2 };
+
+    Path::RequestPath(pn, request, [this, failed](NPC* npc, Path::Result& result) {
+        if (result.Found() && !result.path.empty()) {
+            npc->SetPath(result.path);
+        }
+        else if (failed) {
+            (this->*failed)(npc);
+        }
+    });
+}
+
+void ReturnToWarehouse::RouteFailed(NPC* pn) {
+    pn->setIsMoving(false);
+    pn->setIsResting(true);
+    LOG_WARN(State, "[%c] could not find route back to warehouse (%d,%d).",
+        pn->getSymbol(), centerX, centerY);
+}
+
+void ReturnToWarehouse::RetreatFailed(NPC* pn) {
+    (void)pn;
+    retreating = false;
 }
 
 void ReturnToWarehouse::PlanRouteToWarehouse(NPC* pn) {
@@ -245,12 +269,7 @@ void ReturnToWarehouse::PlanRouteToWarehouse(NPC* pn) {
         }
     }
 
-    if (!PlanPathTo(pn, targetX, targetY)) {
-        pn->setIsMoving(false);
-        pn->setIsResting(true);
-        printf("[WARN] [%c] could not find route back to warehouse (%d,%d).\n",
-            pn->getSymbol(), centerX, centerY);
-    }
+    PlanPathTo(pn, targetX, targetY, true, &ReturnToWarehouse::RouteFailed);
 }
 
 bool ReturnToWarehouse::StartRetreat(NPC* pn, double now) {
@@ -284,17 +303,17 @@ bool ReturnToWarehouse::StartRetreat(NPC* pn, double now) {
         gy = altY;
     }
 
-    if (!PlanPathTo(pn, gx, gy)) {
-        return false;
-    }
-
     retreating = true;
     retreatTargetX = gx;
     retreatTargetY = gy;
     lastRepathCheck = now;
     inPatrol = false;
     pn->setIsResting(false);
-    return true;
+
+    // Without a route the retreat is called off (at once when searched inline,
+    // otherwise Transition heads for the hub once the result is in)
+    PlanPathTo(pn, gx, gy, false, &ReturnToWarehouse::RetreatFailed);
+    return retreating;
 }
 
 void ReturnToWarehouse::StartPatrol(NPC* pn, double now) {
@@ -303,7 +322,7 @@ void ReturnToWarehouse::StartPatrol(NPC* pn, double now) {
     nextPatrolTime = now;
     pn->setIsResting(true);
     pn->setIsMoving(false);
-    printf("[STATE] [%c] arrived at warehouse hub, starting patrol.\n", pn->getSymbol());
+    LOG_INFO(State, "[%c] arrived at warehouse hub, starting patrol.", pn->getSymbol());
 }
 
 void ReturnToWarehouse::IssuePatrolMove(NPC* pn, double now) {
@@ -7,6 +7,7 @@ class NPC;
 
 class ReturnToWarehouse : public State {
 public:
+    ReturnToWarehouse() : ReturnToWarehouse(0, 0) {}   // StatePool slot
     ReturnToWarehouse(int warehouseX, int warehouseY, double patrolRadius = 4.0,
         double avoidX = std::numeric_limits<double>::quiet_NaN(),
         double avoidY = std::numeric_limits<double>::quiet_NaN());
@@ -31,7 +32,12 @@ private:
     double avoidX;
     double avoidY;
 
-    bool PlanPathTo(NPC* pn, int gx, int gy);
+    // sharedGoal: try the team flow field first. 'failed' runs when there is no
+    // route, which may be ticks later when path requests are served off-tick.
+    void PlanPathTo(NPC* pn, int gx, int gy, bool sharedGoal = false,
+        void (ReturnToWarehouse::*failed)(NPC*) = nullptr);
+    void RouteFailed(NPC* pn);
+    void RetreatFailed(NPC* pn);
     void PlanRouteToWarehouse(NPC* pn);
     bool StartRetreat(NPC* pn, double now);
     void StartPatrol(NPC* pn, double now);
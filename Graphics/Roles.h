@@ -4,6 +4,9 @@
 enum class TeamId : unsigned char { Orange = 0, Blue = 1 };
 enum class Role : unsigned char { Commander, Warrior, Medic, Porter };
 
+inline TeamId EnemyOf(TeamId t) {
+    return (t == TeamId::Orange) ? TeamId::Blue : TeamId::Orange;
+}
 
 inline char RoleLetter(Role r) {
     switch (r) {
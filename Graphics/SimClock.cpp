@@ -0,0 +1,30 @@
+#include "SimClock.h"
+#include "World.h"
+
+namespace SimClock
+{
+    void Reset()
+    {
+        World::Current().tickCount = 0;
+    }
+
+    void Advance()
+    {
+        World::Current().tickCount++;
+    }
+
+    double Now()
+    {
+        return World::Current().tickCount * FIXED_DT;
+    }
+
+    double Dt()
+    {
+        return FIXED_DT;
+    }
+
+    long long Ticks()
+    {
+        return World::Current().tickCount;
+    }
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+// ---------------------------------------------------------
+// SimClock - fixed-timestep simulation time
+// Advanced once per Simulation::Step; every subsystem reads time from here
+// instead of clock(), so a match runs the same regardless of machine load.
+// ---------------------------------------------------------
+namespace SimClock
+{
+    // Length of one simulation tick in seconds
+    const double FIXED_DT = 1.0 / 60.0;
+
+    // Back to t = 0 (called when a match is set up)
+    void Reset();
+    // Moves time forward by one tick
+    void Advance();
+
+    // Simulation time in seconds since the match started
+    double Now();
+    // Seconds covered by one tick
+    double Dt();
+    // Number of ticks since the match started
+    long long Ticks();
+}
@@ -0,0 +1,92 @@
+#include <chrono>
+#include "SimThread.h"
+#include "Simulation.h"
+#include "SimClock.h"
+#include "World.h"
+
+SimThread::SimThread(World* w)
+    : world(w)
+{
+}
+
+SimThread::~SimThread()
+{
+    Stop();
+}
+
+void SimThread::Start()
+{
+    if (running) return;
+    running = true;
+    thread = std::thread(&SimThread::Run, this);
+}
+
+void SimThread::Stop()
+{
+    running = false;
+    if (thread.joinable()) thread.join();
+    std::lock_guard<std::mutex> lock(commandMutex);
+    commands.clear();
+}
+
+void SimThread::Post(std::function<void()> command)
+{
+    std::lock_guard<std::mutex> lock(commandMutex);
+    commands.push_back(std::move(command));
+}
+
+void SimThread::SetSnapshotOptions(const SnapshotOptions& options)
+{
+    wantSecurity.store(options.security, std::memory_order_relaxed);
+    wantVisibility.store(options.visibility, std::memory_order_relaxed);
+    wantProfile.store(options.profile, std::memory_order_relaxed);
+}
+
+bool SimThread::RunCommands()
+{
+    std::vector<std::function<void()>> pending;
+    {
+        std::lock_guard<std::mutex> lock(commandMutex);
+        pending.swap(commands);
+    }
+    for (std::function<void()>& command : pending) {
+        command();
+    }
+    return !pending.empty();
+}
+
+void SimThread::Run()
+{
+    using Clock = std::chrono::steady_clock;
+    WorldScope scope(world);
+
+    Clock::time_point last = Clock::now();
+    double accumulator = 0.0;
+    while (running) {
+        bool changed = RunCommands();
+
+        // Run as many fixed ticks as real time has elapsed since the last wake
+        Clock::time_point now = Clock::now();
+        accumulator += std::chrono::duration<double>(now - last).count();
+        last = now;
+
+        int steps = 0;
+        while (accumulator >= SimClock::FIXED_DT && steps < MAX_STEPS_PER_WAKE) {
+            Simulation::Step();
+            accumulator -= SimClock::FIXED_DT;
+            steps++;
+        }
+        if (steps == MAX_STEPS_PER_WAKE) accumulator = 0.0;
+
+        if (steps > 0 || changed) {
+            SnapshotOptions options;
+            options.security = wantSecurity.load(std::memory_order_relaxed);
+            options.visibility = wantVisibility.load(std::memory_order_relaxed);
+            options.profile = wantProfile.load(std::memory_order_relaxed);
+            Snapshot::Capture(snapshots.WriteBuffer(), options);
+            snapshots.Publish();
+        }
+
+        std::this_thread::sleep_for(std::chrono::duration<double>(SimClock::FIXED_DT - accumulator));
+    }
+}
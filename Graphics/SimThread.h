@@ -0,0 +1,61 @@
+#pragma once
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Snapshot.h"
+#include "TripleBuffer.h"
+
+class World;
+
+// ---------------------------------------------------------
+// SimThread - plays a world in real time on its own thread
+// The thread steps the world at SimClock::FIXED_DT and, after every batch
+// of ticks, captures a FrameSnapshot into a TripleBuffer. The window
+// thread never touches the world: it reads the newest snapshot, without
+// locks, and changes the match only through Post, whose commands run on
+// the simulation thread between ticks.
+// ---------------------------------------------------------
+class SimThread {
+public:
+    explicit SimThread(World* world);
+    ~SimThread();       // Stop
+
+    SimThread(const SimThread&) = delete;
+    SimThread& operator=(const SimThread&) = delete;
+
+    void Start();
+    // Waits for the tick in progress; queued commands are dropped
+    void Stop();
+
+    // Runs 'command' on the simulation thread (with the world bound) before the next tick
+    void Post(std::function<void()> command);
+
+    // What the next snapshots copy besides agents and projectiles
+    void SetSnapshotOptions(const SnapshotOptions& options);
+
+    // Reader side, window thread only: switches to the newest snapshot,
+    // false if none was published since the last call
+    bool AcquireSnapshot() { return snapshots.Acquire(); }
+    const FrameSnapshot& CurrentSnapshot() const { return snapshots.ReadBuffer(); }
+
+private:
+    static const int MAX_STEPS_PER_WAKE = 5;    // don't spiral if the machine falls behind
+
+    void Run();
+    bool RunCommands();
+
+    World* world;
+    std::thread thread;
+    std::atomic<bool> running{ false };
+
+    std::mutex commandMutex;
+    std::vector<std::function<void()>> commands;
+
+    std::atomic<bool> wantSecurity{ false };
+    std::atomic<bool> wantVisibility{ false };
+    std::atomic<bool> wantProfile{ false };
+
+    TripleBuffer<FrameSnapshot> snapshots;
+};
@@ -0,0 +1,394 @@
+#include <stdlib.h>
+#include <cmath>
+#include "Log.h"
+#include <vector>
+#include "Simulation.h"
+#include "NPC.h"
+#include "Map.h"
+#include "Roles.h"
+#include "Commander.h"
+#include "Definitions.h"
+#include "Grenade.h"
+#include "Profiler.h"
+#include "GoToCover.h"
+#include "Pathfinding.h"
+#include "GoDeliverAmmo.h"
+#include "StatePool.h"
+#include "SimClock.h"
+#include "World.h"
+
+// All match state lives in World::Current() (see World.h)
+const double COMMANDER_UPDATE_INTERVAL = 1.0; // Commander gives new orders every second
+
+// ================== Security Map Builder ==================
+// Incremental: only shooters that moved since the last tick are recast
+static void UpdateSecurityMaps()
+{
+    Profile::Scope scope(Profile::Stage::SecurityMaps);
+    World& world = World::Current();
+    Map::BuildSecurityMap(world.teamBlue, TeamId::Orange);  // danger for Orange team
+    Map::BuildSecurityMap(world.teamOrange, TeamId::Blue);  // danger for Blue team
+}
+
+// ================== Team Spawns ==================
+struct SpawnSpec { int x, y; char sym; };
+inline Role CharToRole(char c) {
+    switch (c) {
+    case 'C': return Role::Commander;
+    case 'W': return Role::Warrior;
+    case 'M': return Role::Medic;
+    case 'P': return Role::Porter;
+    }
+    return Role::Warrior;
+}
+
+static const SpawnSpec ORANGE_SPAWN[] = {
+    {34,68,'C'},   // commander shifted slightly south to clear the choke
+    {50,72,'W'},
+    {42,58,'W'},
+    {13,18,'M'},
+    {24,82,'P'}
+};
+static const SpawnSpec BLUE_SPAWN[] = {
+    {172,64,'C'},  // commander tucked slightly behind northern cover
+    {150,70,'W'},
+    {158,54,'W'},
+    {187,18,'M'},
+    {176,82,'P'}
+};
+
+// ================== Team creation ==================
+static void SpawnTeamsFromSpecs()
+{
+    World& world = World::Current();
+    std::vector<NPC*>& teamOrange = world.teamOrange;
+    std::vector<NPC*>& teamBlue = world.teamBlue;
+
+    teamOrange.reserve(5);
+    for (const auto& s : ORANGE_SPAWN) {
+        Role role = CharToRole(s.sym);
+        NPC* npc = new NPC(s.x, s.y, TeamId::Orange, role, 4.0);
+        teamOrange.push_back(npc);
+    }
+
+    teamBlue.reserve(5);
+    for (const auto& s : BLUE_SPAWN) {
+        Role role = CharToRole(s.sym);
+        NPC* npc = new NPC(s.x, s.y, TeamId::Blue, role, 4.0);
+        teamBlue.push_back(npc);
+    }
+
+    // Assign commander reference to each NPC
+    for (NPC* npc : teamOrange) npc->setCommander(world.commanderOrange);
+    for (NPC* npc : teamBlue) npc->setCommander(world.commanderBlue);
+
+}
+
+// ================== Idle motion ==================
+static bool FindLocalPatrolTarget(NPC* npc, int radius, int& outX, int& outY)
+{
+    if (!npc) return false;
+    int baseX = static_cast<int>(npc->getX() + 0.5);
+    int baseY = static_cast<int>(npc->getY() + 0.5);
+    const int maxAttempts = 18;
+    World& world = World::Current();
+
+    for (int attempt = 0; attempt < maxAttempts; ++attempt) {
+        int dx = (world.Random() % (radius * 2 + 1)) - radius;
+        int dy = (world.Random() % (radius * 2 + 1)) - radius;
+        int candidateX = baseX + dx;
+        int candidateY = baseY + dy;
+        if (dx == 0 && dy == 0) continue;
+        if (!Map::InBounds(candidateX, candidateY)) continue;
+        if (!Map::IsWalkable(candidateX, candidateY)) continue;
+        if (Map::IsOccupied(candidateX, candidateY, npc->GetId())) continue;
+
+        double dist2 = (candidateX - npc->getX()) * (candidateX - npc->getX()) +
+            (candidateY - npc->getY()) * (candidateY - npc->getY());
+        if (dist2 < 9.0) continue; // skip targets too close
+
+        double risk = Map::GetSecurityValue(candidateY, candidateX, npc->getTeam());
+        if (risk > 0.78) continue;
+
+        outX = candidateX;
+        outY = candidateY;
+        return true;
+    }
+    return false;
+}
+
+static void EnsureIdleMotion(NPC* npc, double currentTime)
+{
+    if (!npc || !npc->IsAlive()) return;
+    if (npc->getIsMoving() || npc->getCurrentState()) return;
+
+    Role role = npc->getRole();
+    if (role == Role::Commander) return;
+
+    if ((currentTime - npc->GetLastIdleAnchorTime()) < 3.0) return;
+
+    int targetX = 0, targetY = 0;
+    if (FindLocalPatrolTarget(npc, 9, targetX, targetY)) {
+        npc->setOrderTarget(targetX, targetY);
+        npc->MarkIdleAnchorIssued();
+        npc->setCurrentState(npc->getStatePool().Acquire<GoToCover>());
+        npc->getCurrentState()->OnEnter(npc);
+        npc->clearOrderTarget();
+        return;
+    }
+
+    int startX = static_cast<int>(std::round(npc->getX()));
+    int startY = static_cast<int>(std::round(npc->getY()));
+
+    std::pair<int, int> safeCell;
+    if (Path::FindNearestCover(startX, startY, 12, npc->getTeam(), safeCell)) {
+        npc->setOrderTarget(safeCell.first, safeCell.second);
+        npc->MarkIdleAnchorIssued();
+        npc->GoToGrid(safeCell.first, safeCell.second);
+        npc->clearOrderTarget();
+        return;
+    }
+
+    World& world = World::Current();
+    int fallbackX = startX + ((world.Random() % 11) - 5);
+    int fallbackY = startY + ((world.Random() % 11) - 5);
+    if (Map::InBounds(fallbackX, fallbackY) && Map::IsWalkable(fallbackX, fallbackY)) {
+        npc->setOrderTarget(fallbackX, fallbackY);
+        npc->MarkIdleAnchorIssued();
+        npc->GoToGrid(fallbackX, fallbackY);
+        npc->clearOrderTarget();
+    }
+}
+
+// ================== Simulation ==================
+static void UpdateAllAgents(double currentTime)
+{
+    World& world = World::Current();
+    const AgentTable& agents = world.agents;
+    std::vector<Grenade*>& activeGrenades = world.activeGrenades;
+
+    // Slots are in spawn order (Orange, then Blue), as the team vectors
+    {
+        Profile::Scope scope(Profile::Stage::Agents);
+        for (int i = 0; i < agents.Count(); ++i)
+        {
+            if (!agents.alive[i]) continue;  // Dead NPCs don't update
+            NPC* a = agents.handle[i];
+            a->DoSomeWork();
+            if (a->getCurrentState() && !a->IsAwaitingPath()) a->getCurrentState()->Transition(a);
+        }
+    }
+
+    {
+        Profile::Scope scope(Profile::Stage::Gunshots);
+        world.gunshots.Update();
+    }
+
+    // Update active grenades
+    {
+        Profile::Scope scope(Profile::Stage::Grenades);
+        for (auto it = activeGrenades.begin(); it != activeGrenades.end();) {
+            Grenade* g = *it;
+            if (g && g->GetIsExploding()) {
+                g->Explode();
+                ++it;
+            } else {
+                delete g;
+                it = activeGrenades.erase(it);
+            }
+        }
+    }
+
+    {
+        Profile::Scope scope(Profile::Stage::Agents);
+        for (int i = 0; i < agents.Count(); ++i) {
+            // Only idle, living non-commanders can need an anchor
+            if (!agents.alive[i] || agents.moving[i] || agents.role[i] == Role::Commander) continue;
+            EnsureIdleMotion(agents.handle[i], currentTime);
+        }
+    }
+
+    Profile::Scope scope(Profile::Stage::DecayCosts);
+    Map::DecayDynamicCosts(0.96);
+}
+
+static void CheckWinCondition(double currentTime)
+{
+    World& world = World::Current();
+    if (world.matchState != MatchState::Running) return;
+
+    bool orangeAlive = world.agents.CountAlive(TeamId::Orange) > 0;
+    bool blueAlive = world.agents.CountAlive(TeamId::Blue) > 0;
+    bool timedOut = world.params.maxMatchSeconds > 0.0 &&
+        currentTime >= world.params.maxMatchSeconds;
+
+    if (orangeAlive && blueAlive && !timedOut) return;
+
+    world.matchEndTime = currentTime;
+
+    if (orangeAlive == blueAlive) {
+        world.matchState = MatchState::Draw;   // both wiped out, or time limit reached
+    }
+    else if (orangeAlive) {
+        world.matchState = MatchState::OrangeWin;
+    }
+    else {
+        world.matchState = MatchState::BlueWin;
+    }
+}
+
+namespace Simulation
+{
+    void Cleanup()
+    {
+        World::Current().ClearAgents();
+    }
+
+    void Setup()
+    {
+        World& world = World::Current();
+        std::vector<NPC*>& teamOrange = world.teamOrange;
+        std::vector<NPC*>& teamBlue = world.teamBlue;
+
+        SimClock::Reset();
+        world.flowFields.Clear();
+
+        Map::BuildLogicalMapLikeYourDrawField();
+        SpawnTeamsFromSpecs();
+
+        teamOrange[2]->setAmmo(1);
+        LOG_INFO(General, "Simulated low ammo: Orange W Ammo = %d", teamOrange[2]->getAmmo());
+
+        world.commanderOrange = new Commander(teamOrange[0], teamOrange);
+        world.commanderBlue = new Commander(teamBlue[0], teamBlue);
+
+        for (NPC* npc : teamOrange) npc->setCommander(world.commanderOrange);
+        for (NPC* npc : teamBlue)  npc->setCommander(world.commanderBlue);
+
+        for (NPC* npc : teamOrange) {
+            if (npc) npc->AssignInitialStateByRole();
+        }
+        for (NPC* npc : teamBlue) {
+            if (npc) npc->AssignInitialStateByRole();
+        }
+
+        // Ensure initial ammo delivery kicks off immediately
+        NPC* initialLowAmmoWarrior = nullptr;
+        NPC* initialPorter = nullptr;
+        for (NPC* npc : teamOrange) {
+            if (!npc) continue;
+            if (npc->getRole() == Role::Warrior && npc->NeedsAmmo()) {
+                initialLowAmmoWarrior = npc;
+            }
+            else if (npc->getRole() == Role::Porter) {
+                initialPorter = npc;
+            }
+        }
+        if (initialLowAmmoWarrior && initialPorter) {
+            State* current = initialPorter->getCurrentState();
+            if (current) {
+                current->OnExit(initialPorter);
+            }
+            LOG_INFO(General, "Porter %c assigned immediate delivery to warrior %c.",
+                initialPorter->getSymbol(), initialLowAmmoWarrior->getSymbol());
+            initialPorter->setCurrentState(initialPorter->getStatePool().Acquire<GoDeliverAmmo>(initialLowAmmoWarrior));
+            initialPorter->getCurrentState()->OnEnter(initialPorter);
+        }
+
+        LOG_INFO(General, "=== INIT COMPLETE ===");
+        world.commanderOrange->PlanAndAssignOrders();
+        world.commanderBlue->PlanAndAssignOrders();
+
+        // Build initial security map
+        UpdateSecurityMaps();
+
+        world.matchEndTime = 0.0;
+        world.matchState = MatchState::Running;
+        world.lastCommanderUpdateTime = 0.0;
+
+        Map::UpdateVisibilityMap(teamOrange);
+        Map::UpdateVisibilityMap(teamBlue);
+    }
+
+    void Reset()
+    {
+        Cleanup();
+        Setup();
+    }
+
+    void Step()
+    {
+        World& world = World::Current();
+        if (world.matchState != MatchState::Running) return;
+
+        world.profiler.BeginTick();
+        {
+            Profile::Scope tickScope(Profile::Stage::Tick);
+            SimClock::Advance();
+            double currentTime = SimClock::Now();
+
+            UpdateAllAgents(currentTime);
+
+            UpdateSecurityMaps();
+
+            std::vector<NPC*>& teamOrange = world.teamOrange;
+            std::vector<NPC*>& teamBlue = world.teamBlue;
+            {
+                Profile::Scope scope(Profile::Stage::VisibilityOrange);
+                Map::UpdateVisibilityMap(teamOrange);
+            }
+            {
+                Profile::Scope scope(Profile::Stage::VisibilityBlue);
+                Map::UpdateVisibilityMap(teamBlue);
+            }
+
+            if (currentTime - world.lastCommanderUpdateTime > COMMANDER_UPDATE_INTERVAL) {
+                Profile::Scope scope(Profile::Stage::Commanders);
+                if (world.commanderOrange && teamOrange.size() > 0 && teamOrange[0] && teamOrange[0]->IsAlive()) {
+                    world.commanderOrange->PlanAndAssignOrders();
+                }
+                if (world.commanderBlue && teamBlue.size() > 0 && teamBlue[0] && teamBlue[0]->IsAlive()) {
+                    world.commanderBlue->PlanAndAssignOrders();
+                }
+                world.lastCommanderUpdateTime = currentTime;
+            }
+
+            // Routes requested in the previous tick arrive, this tick's requests go out
+            {
+                Profile::Scope scope(Profile::Stage::PathRequests);
+                world.pathRequests.Update();
+            }
+
+            CheckWinCondition(currentTime);
+        }
+        world.profiler.EndTick(world.tickCount);
+    }
+
+    MatchState GetMatchState()
+    {
+        return World::Current().matchState;
+    }
+
+    double GetMatchDuration()
+    {
+        return World::Current().matchEndTime;
+    }
+
+    int CountAlive(const std::vector<NPC*>& team)
+    {
+        int alive = 0;
+        for (NPC* npc : team) {
+            if (npc && npc->IsAlive()) alive++;
+        }
+        return alive;
+    }
+
+    int CountAliveByRole(const std::vector<NPC*>& team, Role role)
+    {
+        int alive = 0;
+        for (NPC* npc : team) {
+            if (npc && npc->IsAlive() && npc->getRole() == role) alive++;
+        }
+        return alive;
+    }
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <vector>
+#include "Roles.h"
+
+class NPC;
+
+enum class MatchState { Running, OrangeWin, BlueWin, Draw };
+
+// ---------------------------------------------------------
+// Simulation - owns the match loop, independent of any renderer
+// Operates on World::Current(); bind a world with WorldScope first.
+// ---------------------------------------------------------
+namespace Simulation
+{
+    // Builds the logical map, spawns both teams and issues the opening orders.
+    void Setup();
+    // Frees all NPCs, commanders and grenades of the current match.
+    void Cleanup();
+    // Cleanup followed by Setup.
+    void Reset();
+
+    // Advances the match by one fixed tick (SimClock::FIXED_DT seconds).
+    void Step();
+
+    MatchState GetMatchState();
+    // Match length in simulation seconds (valid once the match is no longer running).
+    double GetMatchDuration();
+
+    int CountAlive(const std::vector<NPC*>& team);
+    int CountAliveByRole(const std::vector<NPC*>& team, Role role);
+}
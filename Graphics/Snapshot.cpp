@@ -0,0 +1,113 @@
+#include "Snapshot.h"
+#include "World.h"
+#include "NPC.h"
+#include "Grenade.h"
+#include "SimClock.h"
+
+namespace Snapshot
+{
+    // Hot fields come straight from the AgentTable arrays; only the
+    // supplies need the NPC object
+    static void CaptureAgents(FrameSnapshot& out, const AgentTable& agents, double now)
+    {
+        out.agents.clear();
+        for (int t = 0; t < 2; ++t) {
+            out.alive[t] = 0;
+            for (int r = 0; r < 4; ++r) out.aliveByRole[t][r] = 0;
+        }
+
+        for (int i = 0; i < agents.Count(); ++i) {
+            const NPC* npc = agents.handle[i];
+            AgentView a;
+            a.x = agents.x[i];
+            a.y = agents.y[i];
+            a.size = npc->getSize();
+            a.team = agents.team[i];
+            a.role = agents.role[i];
+            a.hp = agents.hp[i];
+            a.ammo = npc->getAmmo();
+            a.maxAmmo = npc->getMaxAmmo();
+            a.grenades = npc->getGrenades();
+            a.supply = npc->getSupply();
+            a.maxSupply = npc->getMaxSupply();
+            a.hitFlash = now < npc->GetHitFlashUntil();
+            out.agents.push_back(a);
+
+            if (agents.alive[i]) {
+                out.alive[(int)a.team]++;
+                out.aliveByRole[(int)a.team][(int)a.role]++;
+            }
+        }
+    }
+
+    void Capture(FrameSnapshot& out, const SnapshotOptions& options)
+    {
+        World& world = World::Current();
+        const double now = SimClock::Now();
+
+        out.tick = world.tickCount;
+        out.matchState = world.matchState;
+        out.matchDuration = world.matchEndTime;
+
+        CaptureAgents(out, world.agents, now);
+
+        out.gunshots.clear();
+        const GunshotTable& shots = world.gunshots;
+        for (int i = 0; i < shots.Count(); ++i) {
+            out.gunshots.push_back({ shots.x[i], shots.y[i], shots.dirX[i], shots.dirY[i], shots.team[i] });
+        }
+
+        out.shards.clear();
+        for (Grenade* g : world.activeGrenades) {
+            if (!g || !g->GetIsExploding()) continue;
+            for (int i = 0; i < NUM_BULLETS; ++i) {
+                const Bullet* b = g->GetBullet(i);
+                if (b->GetIsMoving()) out.shards.push_back({ b->GetX(), b->GetY() });
+            }
+        }
+
+        // The slot may hold a snapshot several ticks old, so compare hashes rather than assume
+        uint64_t terrainHash = Map::GetTerrainHash();
+        if (out.terrain.empty() || out.terrainHash != terrainHash) {
+            out.terrain.resize(Map::W * Map::H);
+            for (int y = 0; y < Map::H; ++y) {
+                for (int x = 0; x < Map::W; ++x) {
+                    out.terrain[y * Map::W + x] = Map::Get(x, y);
+                }
+            }
+            out.terrainHash = terrainHash;
+        }
+
+        for (int t = 0; t < 2; ++t) {
+            out.security[t].clear();
+            if (!options.security) continue;
+            out.security[t].resize(Map::W * Map::H);
+            for (int y = 0; y < Map::H; ++y) {
+                for (int x = 0; x < Map::W; ++x) {
+                    out.security[t][y * Map::W + x] = (float)Map::GetSecurityValue(y, x, (TeamId)t);
+                }
+            }
+        }
+
+        out.visibility.clear();
+        if (options.visibility) {
+            out.visibility.resize(Map::W * Map::H);
+            for (int y = 0; y < Map::H; ++y) {
+                for (int x = 0; x < Map::W; ++x) {
+                    out.visibility[y * Map::W + x] = Map::GetVisibilityValue(y, x) > 0.5 ? 1 : 0;
+                }
+            }
+        }
+
+        out.hasProfile = options.profile;
+        if (options.profile) {
+            const TickProfiler& profiler = world.profiler;
+            out.profileTicks = profiler.Count();
+            for (int s = 0; s < Profile::STAGE_COUNT; ++s) {
+                out.stages[s] = profiler.StageStats((Profile::Stage)s);
+            }
+            out.searches = profiler.SearchStats();
+            out.expanded = profiler.ExpandedStats();
+        }
+    }
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include "Roles.h"
+#include "Map.h"
+#include "Simulation.h"
+#include "Profiler.h"
+
+// ---------------------------------------------------------
+// FrameSnapshot - everything the window draws of one tick, copied out of
+// the World by Snapshot::Capture on the simulation thread
+// The renderer only reads snapshots (see SimThread), never the World, so
+// drawing needs no locks and never sees a half-updated tick. Heatmaps and
+// profiler statistics are copied only when SnapshotOptions asks for them.
+// ---------------------------------------------------------
+struct AgentView {
+    double x = 0.0, y = 0.0;
+    double size = 0.0;
+    TeamId team = TeamId::Orange;
+    Role role = Role::Warrior;
+    int hp = 0;
+    int ammo = 0, maxAmmo = 0;
+    int grenades = 0;
+    int supply = 0, maxSupply = 0;
+    bool hitFlash = false;      // took damage recently (red outline)
+};
+
+struct ShotView {
+    double x = 0.0, y = 0.0;
+    double dirX = 0.0, dirY = 0.0;
+    TeamId team = TeamId::Orange;
+};
+
+struct SnapshotOptions {
+    bool security = false;      // both teams' security maps
+    bool visibility = false;
+    bool profile = false;       // TickProfiler statistics
+};
+
+struct FrameSnapshot {
+    long long tick = 0;
+    MatchState matchState = MatchState::Running;
+    double matchDuration = 0.0;
+    int alive[2] = {};                  // per team (TeamId order)
+    int aliveByRole[2][4] = {};         // per team and Role
+
+    std::vector<AgentView> agents;      // Orange team, then Blue, living and dead
+    std::vector<ShotView> gunshots;
+    std::vector<std::pair<double, double>> shards;  // moving grenade bullets
+
+    // Terrain grid (row-major W x H), copied again only when its hash changes
+    uint64_t terrainHash = 0;
+    std::vector<Map::Cell> terrain;
+
+    // Empty unless requested
+    std::vector<float> security[2];             // row-major W x H, per team
+    std::vector<unsigned char> visibility;      // row-major W x H, 0 or 1
+
+    bool hasProfile = false;
+    int profileTicks = 0;
+    TickProfiler::Stats stages[Profile::STAGE_COUNT];
+    TickProfiler::Stats searches;
+    TickProfiler::Stats expanded;
+
+    Map::Cell Terrain(int x, int y) const { return terrain[y * Map::W + x]; }
+};
+
+namespace Snapshot
+{
+    // Fills 'out' from the current world (out may hold an older snapshot)
+    void Capture(FrameSnapshot& out, const SnapshotOptions& options);
+}
+
+// Drawing from snapshots - defined in the GLUT frontend
+void DrawAgent(const AgentView& agent);                 // NPCRender.cpp
+void DrawGunshots(const FrameSnapshot& snapshot);       // NPCRender.cpp
+void DrawGrenadeShards(const FrameSnapshot& snapshot);  // ProjectileRender.cpp
@@ -0,0 +1,178 @@
+#include <algorithm>
+#include "SpatialHash.h"
+#include "AgentTable.h"
+#include "NPC.h"
+
+SpatialHash::SpatialHash(const AgentTable& table)
+    : agents(table)
+{
+}
+
+// Rounds like the NPC cell lookups ((int)(v + 0.5)) and clamps onto the map
+int SpatialHash::CellOf(double v, int extent)
+{
+    int c = (int)(v + 0.5);
+    if (c < 0) return 0;
+    if (c >= extent) return extent - 1;
+    return c;
+}
+
+int SpatialHash::BucketOf(double x, double y)
+{
+    return (CellOf(y, Map::H) / BUCKET_SIZE) * COLS + CellOf(x, Map::W) / BUCKET_SIZE;
+}
+
+void SpatialHash::Clear()
+{
+    for (auto& team : buckets) {
+        for (std::vector<int>& bucket : team) bucket.clear();
+    }
+    entries.clear();
+}
+
+void SpatialHash::Update(NPC* npc)
+{
+    int s = npc->GetSlot();
+    if (s >= (int)entries.size()) entries.resize(s + 1);
+
+    int bucket = BucketOf(agents.x[s], agents.y[s]);
+    Entry& entry = entries[s];
+    if (entry.bucket == bucket) return;
+    if (entry.bucket >= 0) Remove(npc);
+
+    std::vector<int>& list = buckets[(int)agents.team[s]][bucket];
+    entry.bucket = bucket;
+    entry.index = (int)list.size();
+    list.push_back(s);
+}
+
+void SpatialHash::Remove(NPC* npc)
+{
+    int s = npc->GetSlot();
+    if (s >= (int)entries.size()) return;
+    Entry& entry = entries[s];
+    if (entry.bucket < 0) return;
+
+    // Swap with the last entry so removal is O(1)
+    std::vector<int>& list = buckets[(int)agents.team[s]][entry.bucket];
+    int last = list.back();
+    list[entry.index] = last;
+    entries[last].index = entry.index;
+    list.pop_back();
+
+    entry.bucket = -1;
+    entry.index = -1;
+}
+
+// Slots are handed out in id order, so sorting slots sorts by id
+void SpatialHash::CollectSorted(std::vector<int>& found, std::vector<NPC*>& out) const
+{
+    std::sort(found.begin(), found.end());
+    for (int s : found) out.push_back(agents.handle[s]);
+}
+
+void SpatialHash::QueryRadius(TeamId team, double x, double y, double radius, std::vector<NPC*>& out) const
+{
+    out.clear();
+    if (radius < 0.0) return;
+
+    // An NPC is at most half a cell from the cell it is filed under
+    int minBx = CellOf(x - radius - 0.5, Map::W) / BUCKET_SIZE;
+    int maxBx = CellOf(x + radius + 0.5, Map::W) / BUCKET_SIZE;
+    int minBy = CellOf(y - radius - 0.5, Map::H) / BUCKET_SIZE;
+    int maxBy = CellOf(y + radius + 0.5, Map::H) / BUCKET_SIZE;
+    const double radiusSq = radius * radius;
+
+    scratch.clear();
+    for (int by = minBy; by <= maxBy; ++by) {
+        for (int bx = minBx; bx <= maxBx; ++bx) {
+            for (int s : buckets[(int)team][by * COLS + bx]) {
+                if (!agents.alive[s]) continue;
+                double dx = agents.x[s] - x;
+                double dy = agents.y[s] - y;
+                if (dx * dx + dy * dy <= radiusSq) scratch.push_back(s);
+            }
+        }
+    }
+    CollectSorted(scratch, out);
+}
+
+bool SpatialHash::AnyInRadius(TeamId team, double x, double y, double radius, const NPC* exclude) const
+{
+    if (radius < 0.0) return false;
+
+    int minBx = CellOf(x - radius - 0.5, Map::W) / BUCKET_SIZE;
+    int maxBx = CellOf(x + radius + 0.5, Map::W) / BUCKET_SIZE;
+    int minBy = CellOf(y - radius - 0.5, Map::H) / BUCKET_SIZE;
+    int maxBy = CellOf(y + radius + 0.5, Map::H) / BUCKET_SIZE;
+    const double radiusSq = radius * radius;
+    const int skip = exclude ? exclude->GetSlot() : -1;
+
+    for (int by = minBy; by <= maxBy; ++by) {
+        for (int bx = minBx; bx <= maxBx; ++bx) {
+            for (int s : buckets[(int)team][by * COLS + bx]) {
+                if (s == skip || !agents.alive[s]) continue;
+                double dx = agents.x[s] - x;
+                double dy = agents.y[s] - y;
+                if (dx * dx + dy * dy <= radiusSq) return true;
+            }
+        }
+    }
+    return false;
+}
+
+NPC* SpatialHash::FindAtCell(int cellX, int cellY, const NPC* exclude) const
+{
+    if (!Map::InBounds(cellX, cellY)) return nullptr;
+
+    int found = -1;
+    const int skip = exclude ? exclude->GetSlot() : -1;
+    int bucket = (cellY / BUCKET_SIZE) * COLS + cellX / BUCKET_SIZE;
+    for (const auto& team : buckets) {
+        for (int s : team[bucket]) {
+            if (s == skip || !agents.alive[s]) continue;
+            if ((int)(agents.x[s] + 0.5) != cellX || (int)(agents.y[s] + 0.5) != cellY) continue;
+            if (found < 0 || s < found) found = s;
+        }
+    }
+    return found >= 0 ? agents.handle[found] : nullptr;
+}
+
+NPC* SpatialHash::FindNearest(TeamId team, double x, double y, const NPC* exclude) const
+{
+    const int centerBx = CellOf(x, Map::W) / BUCKET_SIZE;
+    const int centerBy = CellOf(y, Map::H) / BUCKET_SIZE;
+    const int maxRing = std::max(COLS, ROWS);
+    const int skip = exclude ? exclude->GetSlot() : -1;
+
+    int best = -1;
+    double bestDist2 = 0.0;
+
+    // Rings of buckets around the query; every NPC in ring d is at least
+    // (d - 1) * BUCKET_SIZE away, so stop once that exceeds the best hit
+    for (int ring = 0; ring <= maxRing; ++ring) {
+        if (best >= 0) {
+            double bound = (double)(ring - 1) * BUCKET_SIZE;
+            if (bound > 0.0 && bound * bound > bestDist2) break;
+        }
+        for (int by = centerBy - ring; by <= centerBy + ring; ++by) {
+            if (by < 0 || by >= ROWS) continue;
+            bool edgeRow = (by == centerBy - ring || by == centerBy + ring);
+            int stepX = edgeRow ? 1 : 2 * ring;
+            for (int bx = centerBx - ring; bx <= centerBx + ring; bx += std::max(1, stepX)) {
+                if (bx < 0 || bx >= COLS) continue;
+                for (int s : buckets[(int)team][by * COLS + bx]) {
+                    if (s == skip || !agents.alive[s]) continue;
+                    double dx = agents.x[s] - x;
+                    double dy = agents.y[s] - y;
+                    double dist2 = dx * dx + dy * dy;
+                    if (best < 0 || dist2 < bestDist2 || (dist2 == bestDist2 && s < best)) {
+                        best = s;
+                        bestDist2 = dist2;
+                    }
+                }
+            }
+        }
+    }
+    return best >= 0 ? agents.handle[best] : nullptr;
+}
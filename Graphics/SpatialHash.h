@@ -0,0 +1,58 @@
+#pragma once
+#include <vector>
+#include "Roles.h"
+#include "Map.h"
+
+class NPC;
+class AgentTable;
+
+// ---------------------------------------------------------
+// SpatialHash - uniform bucket grid of the living NPCs of both teams
+// An NPC lives in the bucket of its rounded cell; NPC keeps it current
+// as it moves, dies or is healed. Buckets hold AgentTable slots and the
+// queries read positions and health from the table's arrays. Queries
+// return NPCs sorted by id, which is the order of the team vectors, so
+// replacing a team scan by a query keeps seeded matches identical.
+// ---------------------------------------------------------
+class SpatialHash {
+public:
+    explicit SpatialHash(const AgentTable& agents);
+
+    static const int BUCKET_SIZE = 8;   // cells per bucket side
+    static const int COLS = (Map::W + BUCKET_SIZE - 1) / BUCKET_SIZE;
+    static const int ROWS = (Map::H + BUCKET_SIZE - 1) / BUCKET_SIZE;
+
+    // Removes every NPC
+    void Clear();
+
+    // Inserts the NPC or moves it to the bucket of its current cell
+    void Update(NPC* npc);
+    void Remove(NPC* npc);
+
+    // Living NPCs of 'team' within 'radius' of (x,y), sorted by id
+    void QueryRadius(TeamId team, double x, double y, double radius, std::vector<NPC*>& out) const;
+
+    // True if a living NPC of 'team' other than 'exclude' is within 'radius' of (x,y)
+    bool AnyInRadius(TeamId team, double x, double y, double radius, const NPC* exclude = nullptr) const;
+
+    // Living NPC of either team whose rounded cell is (cellX,cellY), lowest id first
+    NPC* FindAtCell(int cellX, int cellY, const NPC* exclude = nullptr) const;
+
+    // Closest living NPC of 'team' to (x,y); ties go to the lowest id
+    NPC* FindNearest(TeamId team, double x, double y, const NPC* exclude = nullptr) const;
+
+private:
+    struct Entry {
+        int bucket = -1;    // -1 = not in the grid
+        int index = -1;     // position inside the bucket
+    };
+
+    static int CellOf(double v, int extent);
+    static int BucketOf(double x, double y);
+    void CollectSorted(std::vector<int>& found, std::vector<NPC*>& out) const;
+
+    const AgentTable& agents;
+    std::vector<int> buckets[2][ROWS * COLS];   // AgentTable slots
+    std::vector<Entry> entries;                 // indexed by slot
+    mutable std::vector<int> scratch;           // QueryRadius hits before sorting
+};
@@ -0,0 +1,37 @@
+#pragma once
+#include <tuple>
+#include <utility>
+#include "GoToCover.h"
+#include "GoToCombat.h"
+#include "GoToSupply.h"
+#include "GoToMedSupply.h"
+#include "GoToHeal.h"
+#include "GoDeliverAmmo.h"
+#include "ReturnToWarehouse.h"
+
+// ---------------------------------------------------------
+// StatePool - per-NPC storage for the FSM states
+// Holds one instance of every state type for the NPC's lifetime.
+// Acquire<T>(args...) re-initialises that instance in place (as if freshly
+// constructed) and returns it, so a transition never touches the heap and
+// no state is ever deleted. NPC's current/interrupted state pointers only
+// refer into the pool and own nothing.
+// Acquiring the type that is already current resets the running state and
+// returns the same pointer, so code that must notice a state change made
+// under it (e.g. by a commander replan) compares NPC::GetStateEpoch().
+// ---------------------------------------------------------
+
+class StatePool {
+public:
+    template <class T, class... Args>
+    T* Acquire(Args&&... args)
+    {
+        T& slot = std::get<T>(slots);
+        slot = T(std::forward<Args>(args)...);
+        return &slot;
+    }
+
+private:
+    std::tuple<GoToCover, GoToCombat, GoToSupply, GoToMedSupply,
+        GoToHeal, GoDeliverAmmo, ReturnToWarehouse> slots;
+};
@@ -0,0 +1,45 @@
+#pragma once
+#include <atomic>
+
+// ---------------------------------------------------------
+// TripleBuffer - hands whole values from one writer thread to one reader
+// thread without locks
+// The writer fills WriteBuffer() and calls Publish(); the reader calls
+// Acquire() and reads ReadBuffer() until its next Acquire. Each side owns
+// one of the three slots and the third is exchanged between them through
+// a single atomic, so neither side ever waits; values published faster
+// than the reader acquires them are skipped. Slots are reused, so the
+// writer must overwrite every field it publishes.
+// ---------------------------------------------------------
+template <typename T>
+class TripleBuffer {
+public:
+    T& WriteBuffer() { return slots[back]; }
+
+    // Makes the write buffer the newest value and takes a free slot to write next
+    void Publish()
+    {
+        int old = middle.exchange(back | FRESH, std::memory_order_acq_rel);
+        back = old & INDEX;
+    }
+
+    // Switches ReadBuffer() to the newest published value; false if nothing new
+    bool Acquire()
+    {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH)) return false;
+        int old = middle.exchange(front, std::memory_order_acq_rel);
+        front = old & INDEX;
+        return true;
+    }
+
+    const T& ReadBuffer() const { return slots[front]; }
+
+private:
+    static const int INDEX = 3;     // slot bits of 'middle'
+    static const int FRESH = 4;     // set while 'middle' holds a value the reader has not taken
+
+    T slots[3];
+    int back = 0;                   // writer's slot
+    std::atomic<int> middle{ 1 };
+    int front = 2;                  // reader's slot
+};
@@ -0,0 +1,59 @@
+#include "World.h"
+#include "NPC.h"
+#include "Commander.h"
+#include "Grenade.h"
+
+static thread_local World* currentWorld = nullptr;
+
+World::World(const MatchParams& p)
+    : params(p), rng(p.seed)
+{
+}
+
+World::~World()
+{
+    // NPC destructors release occupancy through Map, which needs this world bound
+    WorldScope scope(this);
+    ClearAgents();
+}
+
+World& World::Current()
+{
+    return *currentWorld;
+}
+
+bool World::HasCurrent()
+{
+    return currentWorld != nullptr;
+}
+
+void World::ClearAgents()
+{
+    for (NPC* npc : teamOrange) delete npc;
+    teamOrange.clear();
+    for (NPC* npc : teamBlue) delete npc;
+    teamBlue.clear();
+    agents.Clear();
+    npcGrid.Clear();
+
+    delete commanderOrange;
+    commanderOrange = nullptr;
+    delete commanderBlue;
+    commanderBlue = nullptr;
+
+    for (Grenade* grenade : activeGrenades) delete grenade;
+    activeGrenades.clear();
+
+    gunshots.Clear();
+}
+
+WorldScope::WorldScope(World* w)
+    : previous(currentWorld)
+{
+    currentWorld = w;
+}
+
+WorldScope::~WorldScope()
+{
+    currentWorld = previous;
+}
@@ -0,0 +1,125 @@
+#pragma once
+#include <vector>
+#include <array>
+#include <utility>
+#include <random>
+#include "Roles.h"
+#include "Map.h"
+#include "Commander.h"
+#include "Simulation.h"
+#include "Definitions.h"
+#include "SpatialHash.h"
+#include "AgentTable.h"
+#include "GunshotTable.h"
+#include "FlowField.h"
+#include "PathHierarchy.h"
+#include "Pathfinding.h"
+#include "PathService.h"
+#include "PathCache.h"
+#include "Profiler.h"
+
+class NPC;
+class Grenade;
+
+// ---------------------------------------------------------
+// MatchParams - tunables that may differ between matches
+// ---------------------------------------------------------
+struct MatchParams
+{
+    double fireRange = FIRE_RANGE;
+    int grenadeDamage = GRENADE_DAMAGE;
+    int bulletDamage = BULLET_DAMAGE;
+    unsigned int seed = 0;
+    double maxMatchSeconds = 0.0;   // 0 = no limit; otherwise the match ends in a draw
+};
+
+// ---------------------------------------------------------
+// World - all state of one match
+// Every subsystem reaches it through World::Current(), which is
+// per-thread, so independent matches can run on different threads.
+// ---------------------------------------------------------
+class World {
+public:
+    explicit World(const MatchParams& p = MatchParams());
+    ~World();
+
+    World(const World&) = delete;
+    World& operator=(const World&) = delete;
+
+    // World bound to the calling thread (see WorldScope)
+    static World& Current();
+    static bool HasCurrent();
+
+    std::vector<NPC*>& Team(TeamId t) { return (t == TeamId::Orange) ? teamOrange : teamBlue; }
+    std::vector<NPC*>& EnemiesOf(TeamId t) { return (t == TeamId::Orange) ? teamBlue : teamOrange; }
+
+    // Deletes all NPCs, commanders, grenades and gunshots
+    void ClearAgents();
+
+    // Match-local replacement for rand(): uniform in [0, RANDOM_MAX]
+    int Random() { return static_cast<int>(rng() >> 1); }
+    static const int RANDOM_MAX = 0x7FFFFFFF;
+
+    MatchParams params;
+
+    // --- match ---
+    MatchState matchState = MatchState::Running;
+    double matchEndTime = 0.0;
+    double lastCommanderUpdateTime = 0.0;
+    long long tickCount = 0;        // SimClock ticks
+    TickProfiler profiler;          // stage timings of the last ticks
+
+    // --- agents ---
+    std::vector<NPC*> teamOrange;
+    std::vector<NPC*> teamBlue;
+    AgentTable agents;              // per-tick fields of every NPC above, by slot
+    Commander* commanderOrange = nullptr;
+    Commander* commanderBlue = nullptr;
+    std::vector<Grenade*> activeGrenades;
+    GunshotTable gunshots;          // bullets in flight
+    int nextNpcId = 1;
+    SpatialHash npcGrid{ agents };  // living NPCs by position, kept current by NPC
+
+    // --- map layers (terrain, occupancy, heatmaps) ---
+    Map::Layers map;
+    FlowFieldCache flowFields;      // routes toward shared goals, derived from map
+    PathHierarchy pathHierarchy;    // cluster graph for hierarchical search, derived from map
+    Path::SearchMode pathSearch = Path::SearchMode::AStar;  // kept across matches
+    PathService pathRequests;       // FSM path requests, inline or on worker threads
+    PathCache pathCache;            // recent FindSafePath routes, derived from map (off by default)
+
+    // --- state that used to be file-static in the FSM / commander code ---
+    struct CombatState {
+        double lastShotTime = 0;
+        double combatStartTime = 0;
+        Role lastThrowerRole = Role::Commander;
+    } combat;
+
+    struct WaitState {
+        double arrivalTime = 0;
+        bool waiting = false;
+    } supplyWait, medSupplyWait;
+
+    struct CommanderState {
+        std::array<std::vector<std::pair<int, int>>, 3> coverSlotsOrange;
+        std::array<std::vector<std::pair<int, int>>, 3> coverSlotsBlue;
+        bool coverCatalogBuilt = false;
+        TeamState lastPlannedTeamState = TeamState::DEFEND;
+    } commanders;
+
+private:
+    std::mt19937 rng;
+};
+
+// Binds a world to the current thread for the lifetime of the scope
+class WorldScope {
+public:
+    explicit WorldScope(World* w);
+    ~WorldScope();
+
+    WorldScope(const WorldScope&) = delete;
+    WorldScope& operator=(const WorldScope&) = delete;
+
+private:
+    World* previous;
+};
@@ -2,112 +2,35 @@
 #include <time.h>
 #include <math.h>
 #include <cmath>
-#include <stdio.h>
+#include "Log.h"
 #include <string>
 #include <sstream>
 #include <iomanip>
 #include <cctype>
+#include <algorithm>
+#include <thread>
+#include <chrono>
 #include "glut.h"
-#include "NPC.h"
 #include "Map.h"
 #include <vector>
 #include "Roles.h"
-#include "Commander.h"
 #include "Definitions.h"
-#include "Grenade.h"
-#include "GoToCombat.h"
-#include "GoToCover.h"
+#include "Simulation.h"
+#include "World.h"
+#include "SimThread.h"
 #include "Pathfinding.h"
-#include "GoDeliverAmmo.h"
-
-// ================== Globals ==================
-Commander* commanderOrange;
-Commander* commanderBlue;
-
-std::vector<NPC*> teamOrange;
-std::vector<NPC*> teamBlue;
-
-// Global list of active grenades (defined in NPC.cpp)
-extern std::vector<Grenade*> activeGrenades;
-
-enum class MatchState { Running, OrangeWin, BlueWin, Draw };
-static MatchState matchState = MatchState::Running;
-static double matchEndTime = 0.0;
-static double matchStartTime = 0.0;
+#include "RenderBatch.h"
 
 static bool g_showSecurity = false;
 static bool g_showVisibility = false;
+static bool g_showProfile = false;
 static TeamId g_securityOverlayTeam = TeamId::Orange;
-static double lastCommanderUpdateTime = 0.0;
-static bool g_randomSeeded = false;
+static MatchState g_lastMatchState = MatchState::Running;
+static SimThread* g_sim = nullptr;     // plays the world; the window only reads its snapshots
 
-static void CleanupSimulation();
-static void SetupSimulation();
 static void ResetSimulation();
 static void OnKeyboard(unsigned char key, int, int);
 static void OnMouse(int button, int state, int x, int y);
-static bool FindLocalPatrolTarget(NPC* npc, int radius, int& outX, int& outY);
-static void EnsureIdleMotion(NPC* npc, double currentTime);
-
-// ================== Security Map Builder ==================
-static void RebuildSecurityMap()
-{
-    Map::ResetSecurityMaps();
-    Map::BuildSecurityMap(teamBlue, TeamId::Orange);  // danger for Orange team
-    Map::BuildSecurityMap(teamOrange, TeamId::Blue);  // danger for Blue team
-}
-
-
-
-// ================== Team Spawns ==================
-struct SpawnSpec { int x, y; char sym; };
-inline Role CharToRole(char c) {
-    switch (c) {
-    case 'C': return Role::Commander;
-    case 'W': return Role::Warrior;
-    case 'M': return Role::Medic;
-    case 'P': return Role::Porter;
-    }
-    return Role::Warrior;
-}
-
-static const SpawnSpec ORANGE_SPAWN[] = {
-    {34,68,'C'},   // commander shifted slightly south to clear the choke
-    {50,72,'W'},
-    {42,58,'W'},
-    {13,18,'M'},
-    {24,82,'P'}
-};
-static const SpawnSpec BLUE_SPAWN[] = {
-    {172,64,'C'},  // commander tucked slightly behind northern cover
-    {150,70,'W'},
-    {158,54,'W'},
-    {187,18,'M'},
-    {176,82,'P'}
-};
-
-// ================== Team creation ==================
-void SpawnTeamsFromSpecs()
-{
-    teamOrange.reserve(5);
-    for (const auto& s : ORANGE_SPAWN) {
-        Role role = CharToRole(s.sym);
-        NPC* npc = new NPC(s.x, s.y, TeamId::Orange, role, 4.0);
-        teamOrange.push_back(npc);
-    }
-
-    teamBlue.reserve(5);
-    for (const auto& s : BLUE_SPAWN) {
-        Role role = CharToRole(s.sym);
-        NPC* npc = new NPC(s.x, s.y, TeamId::Blue, role, 4.0);
-        teamBlue.push_back(npc);
-    }
-
-    // Assign commander reference to each NPC
-    for (NPC* npc : teamOrange) npc->setCommander(commanderOrange);
-    for (NPC* npc : teamBlue) npc->setCommander(commanderBlue);
-
-}
 
 // ================== Initialization ==================
 void init()
@@ -118,110 +41,12 @@ void init()
     ResetSimulation();
 }
 
-static void CleanupTeam(std::vector<NPC*>& team)
-{
-    for (NPC* npc : team) {
-        delete npc;
-    }
-    team.clear();
-}
-
-static void CleanupActiveGrenades()
-{
-    for (Grenade* grenade : activeGrenades) {
-        delete grenade;
-    }
-    activeGrenades.clear();
-}
-
-static void CleanupSimulation()
-{
-    CleanupTeam(teamOrange);
-    CleanupTeam(teamBlue);
-
-    delete commanderOrange;
-    commanderOrange = nullptr;
-    delete commanderBlue;
-    commanderBlue = nullptr;
-
-    CleanupActiveGrenades();
-}
-
-static void SetupSimulation()
-{
-    if (!g_randomSeeded) {
-        unsigned int seed = (unsigned int)time(nullptr);
-        printf("[INIT] Random seed = %u\n", seed);
-        srand(seed);
-        g_randomSeeded = true;
-    }
-
-    Map::BuildLogicalMapLikeYourDrawField();
-    SpawnTeamsFromSpecs();
-
-    teamOrange[2]->setAmmo(1);
-    printf(" Simulated low ammo: Orange W Ammo = %d\n", teamOrange[2]->getAmmo());
-
-    commanderOrange = new Commander(teamOrange[0], teamOrange);
-    commanderBlue = new Commander(teamBlue[0], teamBlue);
-
-    for (NPC* npc : teamOrange) npc->setCommander(commanderOrange);
-    for (NPC* npc : teamBlue)  npc->setCommander(commanderBlue);
-
-    for (NPC* npc : teamOrange) {
-        if (npc) npc->AssignInitialStateByRole();
-    }
-    for (NPC* npc : teamBlue) {
-        if (npc) npc->AssignInitialStateByRole();
-    }
-
-    // Ensure initial ammo delivery kicks off immediately
-    NPC* initialLowAmmoWarrior = nullptr;
-    NPC* initialPorter = nullptr;
-    for (NPC* npc : teamOrange) {
-        if (!npc) continue;
-        if (npc->getRole() == Role::Warrior && npc->NeedsAmmo()) {
-            initialLowAmmoWarrior = npc;
-        }
-        else if (npc->getRole() == Role::Porter) {
-            initialPorter = npc;
-        }
-    }
-    if (initialLowAmmoWarrior && initialPorter) {
-        State* current = initialPorter->getCurrentState();
-        if (current) {
-            current->OnExit(initialPorter);
-            delete current;
-        }
-        printf("[INIT] Porter %c assigned immediate delivery to warrior %c.\n",
-            initialPorter->getSymbol(), initialLowAmmoWarrior->getSymbol());
-        initialPorter->setCurrentState(new GoDeliverAmmo(initialLowAmmoWarrior));
-        initialPorter->getCurrentState()->OnEnter(initialPorter);
-    }
-
-    printf("=== INIT COMPLETE ===\n");
-    commanderOrange->PlanAndAssignOrders();
-    commanderBlue->PlanAndAssignOrders();
-
-    // Build initial security map
-    RebuildSecurityMap();
-
-    matchStartTime = clock() / (double)CLOCKS_PER_SEC;
-    matchEndTime = 0.0;
-    matchState = MatchState::Running;
-    lastCommanderUpdateTime = 0.0;
-
-    Map::UpdateVisibilityMap(teamOrange);
-    Map::UpdateVisibilityMap(teamBlue);
-}
-
 static void ResetSimulation()
 {
-    CleanupSimulation();
     g_showSecurity = SHOW_SECURITY != 0;
     g_showVisibility = SHOW_VIS != 0;
     g_securityOverlayTeam = TeamId::Orange;
-    SetupSimulation();
+    g_sim->Post([] { Simulation::Reset(); });
     glutPostRedisplay();
 }
 
@@ -235,25 +60,31 @@ static void DrawString(double x, double y, const std::string& text, const TeamCo
     }
 }
 
-static int CountAlive(const std::vector<NPC*>& team)
+// Rolling stage timings of the simulation (T)
+static void DrawProfile(double x, double y, const FrameSnapshot& snapshot)
 {
-    int alive = 0;
-    for (NPC* npc : team) {
-        if (npc && npc->IsAlive()) alive++;
-    }
-    return alive;
-}
-
-static int CountAliveByRole(const std::vector<NPC*>& team, Role role)
-{
-    int alive = 0;
-    for (NPC* npc : team) {
-        if (npc && npc->IsAlive() && npc->getRole() == role) alive++;
-    }
-    return alive;
+    if (!snapshot.hasProfile) return;
+    const TeamColor headerColor{ 1.0, 1.0, 0.6 };
+
+    std::ostringstream header;
+    header << "Last " << snapshot.profileTicks << " ticks (us)   min     avg     p99";
+    DrawString(x, y, header.str(), headerColor);
+
+    auto row = [&](const char* name, const TickProfiler::Stats& st, int precision) {
+        y -= 3.0;
+        std::ostringstream os;
+        os << std::fixed << std::setprecision(precision) << std::left << std::setw(16) << name << std::right
+            << std::setw(8) << st.min << std::setw(8) << st.avg << std::setw(8) << st.p99;
+        DrawString(x, y, os.str());
+    };
+    for (int s = 0; s < Profile::STAGE_COUNT; ++s) {
+        row(Profile::StageName((Profile::Stage)s), snapshot.stages[s], 1);
+    }
+    row("searches", snapshot.searches, 1);
+    row("expanded", snapshot.expanded, 0);
 }
 
-static void DrawHud()
+static void DrawHud(const FrameSnapshot& snapshot)
 {
     glPushMatrix();
     glMatrixMode(GL_MODELVIEW);
@@ -261,24 +92,27 @@ static void DrawHud()
 
     TeamColor orangeColor = GetTeamColor(TeamId::Orange);
     TeamColor blueColor = GetTeamColor(TeamId::Blue);
+    const int orange = (int)TeamId::Orange;
+    const int blue = (int)TeamId::Blue;
 
     double baseY = 96.0;
     DrawString(2.0, baseY, "=== Match Status ===");
 
     std::ostringstream osOrange;
-    osOrange << "Orange Alive: " << CountAlive(teamOrange)
-        << " (W:" << CountAliveByRole(teamOrange, Role::Warrior)
-        << " M:" << CountAliveByRole(teamOrange, Role::Medic)
-        << " P:" << CountAliveByRole(teamOrange, Role::Porter) << ")";
+    osOrange << "Orange Alive: " << snapshot.alive[orange]
+        << " (W:" << snapshot.aliveByRole[orange][(int)Role::Warrior]
+        << " M:" << snapshot.aliveByRole[orange][(int)Role::Medic]
+        << " P:" << snapshot.aliveByRole[orange][(int)Role::Porter] << ")";
     DrawString(2.0, baseY - 4.0, osOrange.str(), orangeColor);
 
     std::ostringstream osBlue;
-    osBlue << "Blue Alive: " << CountAlive(teamBlue)
-        << " (W:" << CountAliveByRole(teamBlue, Role::Warrior)
-        << " M:" << CountAliveByRole(teamBlue, Role::Medic)
-        << " P:" << CountAliveByRole(teamBlue, Role::Porter) << ")";
+    osBlue << "Blue Alive: " << snapshot.alive[blue]
+        << " (W:" << snapshot.aliveByRole[blue][(int)Role::Warrior]
+        << " M:" << snapshot.aliveByRole[blue][(int)Role::Medic]
+        << " P:" << snapshot.aliveByRole[blue][(int)Role::Porter] << ")";
     DrawString(2.0, baseY - 8.0, osBlue.str(), blueColor);
 
+    MatchState matchState = snapshot.matchState;
     if (matchState != MatchState::Running) {
         std::string result;
         TeamColor resultColor{ 1.0,1.0,0.2 };
@@ -299,37 +133,26 @@ static void DrawHud()
         }
         DrawString(2.0, baseY - 14.0, result, resultColor);
         std::ostringstream osTime;
-        osTime << "Duration: " << std::fixed << std::setprecision(1) << matchEndTime << "s";
+        osTime << "Duration: " << std::fixed << std::setprecision(1) << snapshot.matchDuration << "s";
         DrawString(2.0, baseY - 18.0, osTime.str());
         DrawString(2.0, baseY - 22.0, "Press R to restart simulation.");
     }
 
     DrawString(120.0, baseY, "Controls: S/V overlays, Right-Click=Security, 1/2 teams, 0 off, R reset");
 
+    if (g_showProfile) {
+        DrawProfile(120.0, baseY - 4.0, snapshot);
+    }
+
     glPopMatrix();
 }
 
-static void CheckWinCondition()
+// Pops the result dialog once, when the match leaves the Running state
+static void ReportMatchResult(const FrameSnapshot& snapshot)
 {
-    if (matchState != MatchState::Running) return;
-
-    bool orangeAlive = CountAlive(teamOrange) > 0;
-    bool blueAlive = CountAlive(teamBlue) > 0;
-
-    if (orangeAlive && blueAlive) return;
-
-    double now = clock() / (double)CLOCKS_PER_SEC;
-    matchEndTime = now - matchStartTime;
-
-    if (!orangeAlive && !blueAlive) {
-        matchState = MatchState::Draw;
-    }
-    else if (orangeAlive) {
-        matchState = MatchState::OrangeWin;
-    }
-    else {
-        matchState = MatchState::BlueWin;
-    }
+    MatchState matchState = snapshot.matchState;
+    if (matchState == g_lastMatchState) return;
+    g_lastMatchState = matchState;
 
     std::string winMsg;
     switch (matchState) {
@@ -346,79 +169,6 @@ static void CheckWinCondition()
 }
 
 // ================== Drawing ==================
-static bool FindLocalPatrolTarget(NPC* npc, int radius, int& outX, int& outY)
-{
-    if (!npc) return false;
-    int baseX = static_cast<int>(npc->getX() + 0.5);
-    int baseY = static_cast<int>(npc->getY() + 0.5);
-    const int maxAttempts = 18;
-
-    for (int attempt = 0; attempt < maxAttempts; ++attempt) {
-        int dx = (rand() % (radius * 2 + 1)) - radius;
-        int dy = (rand() % (radius * 2 + 1)) - radius;
-        int candidateX = baseX + dx;
-        int candidateY = baseY + dy;
-        if (dx == 0 && dy == 0) continue;
-        if (!Map::InBounds(candidateX, candidateY)) continue;
-        if (!Map::IsWalkable(candidateX, candidateY)) continue;
-        if (Map::IsOccupied(candidateX, candidateY, npc->GetId())) continue;
-
-        double dist2 = (candidateX - npc->getX()) * (candidateX - npc->getX()) +
-            (candidateY - npc->getY()) * (candidateY - npc->getY());
-        if (dist2 < 9.0) continue; // skip targets too close
-
-        double risk = Map::GetSecurityValue(candidateY, candidateX, npc->getTeam());
-        if (risk > 0.78) continue;
-
-        outX = candidateX;
-        outY = candidateY;
-        return true;
-    }
-    return false;
-}
-
-static void EnsureIdleMotion(NPC* npc, double currentTime)
-{
-    if (!npc || !npc->IsAlive()) return;
-    if (npc->getIsMoving() || npc->getCurrentState()) return;
-
-    Role role = npc->getRole();
-    if (role == Role::Commander) return;
-
-    if ((currentTime - npc->GetLastIdleAnchorTime()) < 3.0) return;
-
-    int targetX = 0, targetY = 0;
-    if (FindLocalPatrolTarget(npc, 9, targetX, targetY)) {
-        npc->setOrderTarget(targetX, targetY);
-        npc->MarkIdleAnchorIssued();
-        npc->setCurrentState(new GoToCover());
-        npc->getCurrentState()->OnEnter(npc);
-        npc->clearOrderTarget();
-        return;
-    }
-
-    int startX = static_cast<int>(std::round(npc->getX()));
-    int startY = static_cast<int>(std::round(npc->getY()));
-
-    std::pair<int, int> safeCell;
-    if (Path::FindNearestCover(startX, startY, 12, npc->getTeam(), safeCell)) {
-        npc->setOrderTarget(safeCell.first, safeCell.second);
-        npc->MarkIdleAnchorIssued();
-        npc->GoToGrid(safeCell.first, safeCell.second);
-        npc->clearOrderTarget();
-        return;
-    }
-
-    int fallbackX = startX + ((rand() % 11) - 5);
-    int fallbackY = startY + ((rand() % 11) - 5);
-    if (Map::InBounds(fallbackX, fallbackY) && Map::IsWalkable(fallbackX, fallbackY)) {
-        npc->setOrderTarget(fallbackX, fallbackY);
-        npc->MarkIdleAnchorIssued();
-        npc->GoToGrid(fallbackX, fallbackY);
-        npc->clearOrderTarget();
-    }
-}
-
 void DrawTree(double x, double y, double size)
 {
     glColor3d(0.09, 0.45, 0.10);
@@ -536,133 +286,117 @@ void DrawField()
     DrawWaterPuddle(55, 36, 8, 5);
 }
 
-void DrawDebugMap()
+// One point per non-free cell, kept in client arrays and rebuilt only when
+// the terrain hash changes, so the whole layer is a single glDrawArrays
+struct TerrainPoints {
+    std::vector<GLfloat> vertices;  // x, y
+    std::vector<GLubyte> colors;    // r, g, b
+    uint64_t terrainHash = 0;
+    bool built = false;
+};
+static TerrainPoints g_terrainPoints;
+
+static void RebuildTerrainPoints(TerrainPoints& points, const FrameSnapshot& snapshot)
 {
+    points.vertices.clear();
+    points.colors.clear();
     for (int y = 0; y < Map::H; y++)
     {
         for (int x = 0; x < Map::W; x++)
         {
-            auto c = Map::Get(x, y);
-            if (c == Map::ROCK) glColor3d(0.4, 0.4, 0.4);
-            else if (c == Map::WATER) glColor3d(0.3, 0.6, 0.9);
-            else if (c == Map::WAREHOUSE) glColor3d(1.0, 1.0, 0.0);
-            else if (c == Map::TREE) glColor3d(0.0, 0.5, 0.0);
+            auto c = snapshot.Terrain(x, y);
+            GLubyte r, g, b;
+            if (c == Map::ROCK) { r = 102; g = 102; b = 102; }
+            else if (c == Map::WATER) { r = 77; g = 153; b = 230; }
+            else if (c == Map::WAREHOUSE) { r = 255; g = 255; b = 0; }
+            else if (c == Map::TREE) { r = 0; g = 128; b = 0; }
             else continue;
-            glBegin(GL_POINTS);
-            glVertex2d(x, y);
-            glEnd();
+            points.vertices.push_back((GLfloat)x);
+            points.vertices.push_back((GLfloat)y);
+            points.colors.push_back(r);
+            points.colors.push_back(g);
+            points.colors.push_back(b);
         }
     }
+    points.terrainHash = snapshot.terrainHash;
+    points.built = true;
 }
 
-// ================== Simulation ==================
-static void DrawAllAgents()
+void DrawDebugMap(const FrameSnapshot& snapshot)
 {
-    for (NPC* a : teamOrange) if (a) a->Show();
-    for (NPC* a : teamBlue)   if (a) a->Show();
-    
-    // Draw active grenades
-    for (Grenade* g : activeGrenades) {
-        if (g && g->GetIsExploding()) {
-            g->Show();
-        }
-    }
-
-    DrawActiveGunshots();
+    if (snapshot.terrain.empty()) return;      // nothing published yet
+    TerrainPoints& points = g_terrainPoints;
+    if (!points.built || points.terrainHash != snapshot.terrainHash) {
+        RebuildTerrainPoints(points, snapshot);
+    }
+    if (points.colors.empty()) return;
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(2, GL_FLOAT, 0, points.vertices.data());
+    glColorPointer(3, GL_UNSIGNED_BYTE, 0, points.colors.data());
+    glDrawArrays(GL_POINTS, 0, (GLsizei)(points.colors.size() / 3));
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
 }
 
-static void UpdateAllAgents(double currentTime)
+// ================== Agents ==================
+static void DrawAllAgents(const FrameSnapshot& snapshot)
 {
-    for (NPC* a : teamOrange)
-    {
-        if (!a || !a->IsAlive()) continue;  // Dead NPCs don't update
-        a->DoSomeWork();
-        if (a->getCurrentState()) a->getCurrentState()->Transition(a);
-    }
-    for (NPC* a : teamBlue)
-    {
-        if (!a || !a->IsAlive()) continue;  // Dead NPCs don't update
-        a->DoSomeWork();
-        if (a->getCurrentState()) a->getCurrentState()->Transition(a);
-    }
+    for (const AgentView& a : snapshot.agents) DrawAgent(a);
 
-    UpdateActiveGunshots();
-    
-    // Update active grenades
-    for (auto it = activeGrenades.begin(); it != activeGrenades.end();) {
-        Grenade* g = *it;
-        if (g && g->GetIsExploding()) {
-            g->Explode();
-            ++it;
-        } else {
-            delete g;
-            it = activeGrenades.erase(it);
-        }
-    }
+    DrawGrenadeShards(snapshot);
+    DrawGunshots(snapshot);
 
-    for (NPC* a : teamOrange) {
-        EnsureIdleMotion(a, currentTime);
-    }
-    for (NPC* a : teamBlue) {
-        EnsureIdleMotion(a, currentTime);
-    }
-
-    Map::DecayDynamicCosts(0.96);
+    RenderBatch::Frame().Flush();
 }
 
 // ================== GLUT callbacks ==================
 void display()
 {
+    // Overlays are copied into snapshots only while shown; a toggle reaches
+    // the screen with the next published tick
+    SnapshotOptions options;
+    options.security = g_showSecurity;
+    options.visibility = g_showVisibility;
+    options.profile = g_showProfile;
+    g_sim->SetSnapshotOptions(options);
+    const FrameSnapshot& snapshot = g_sim->CurrentSnapshot();
+
+    RenderBatch::Frame().Prepare();
     glClear(GL_COLOR_BUFFER_BIT);
 
-    if (g_showVisibility) {
-        Map::DrawVisibilityMap();
+    if (g_showVisibility && !snapshot.visibility.empty()) {
+        Map::DrawVisibilityMap(snapshot);
     }
     else {
         DrawField();
     }
 
     if (g_showSecurity) {
-        Map::DrawSecurityMap(g_securityOverlayTeam);
+        Map::DrawSecurityMap(snapshot, g_securityOverlayTeam);
     }
 
-    DrawAllAgents();
-    DrawHud();
+    DrawAllAgents(snapshot);
+    DrawHud(snapshot);
 
-    DrawDebugMap();
+    DrawDebugMap(snapshot);
 
 
     glutSwapBuffers();
-}
 
-const double COMMANDER_UPDATE_INTERVAL = 1.0; // Commander gives new orders every second
+    ReportMatchResult(snapshot);
+}
 
 void idle()
 {
-    double currentTime = clock() / (double)CLOCKS_PER_SEC;
-
-    if (matchState == MatchState::Running) {
-        UpdateAllAgents(currentTime);
-
-        RebuildSecurityMap();
-
-        Map::UpdateVisibilityMap(teamOrange);
-        Map::UpdateVisibilityMap(teamBlue);
-
-        if (currentTime - lastCommanderUpdateTime > COMMANDER_UPDATE_INTERVAL) {
-            if (commanderOrange && teamOrange.size() > 0 && teamOrange[0] && teamOrange[0]->IsAlive()) {
-                commanderOrange->PlanAndAssignOrders();
-            }
-            if (commanderBlue && teamBlue.size() > 0 && teamBlue[0] && teamBlue[0]->IsAlive()) {
-                commanderBlue->PlanAndAssignOrders();
-            }
-            lastCommanderUpdateTime = currentTime;
-        }
-
-        CheckWinCondition();
+    // Redraw when the simulation thread has published a newer tick
+    if (g_sim->AcquireSnapshot()) {
+        glutPostRedisplay();
+    }
+    else {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
     }
-
-    glutPostRedisplay();
 }
 
 void OnKeyboard(unsigned char key, int, int)
@@ -678,6 +412,39 @@ void OnKeyboard(unsigned char key, int, int)
     case 'r':
         ResetSimulation();
         return;
+    case 'f':
+        g_sim->Post([] {
+            bool shadow = Map::GetVisibilityBackend() == Map::VisibilityBackend::Rays;
+            Map::SetVisibilityBackend(shadow ? Map::VisibilityBackend::Shadowcast : Map::VisibilityBackend::Rays);
+            LOG_INFO(General, "Visibility backend: %s", shadow ? "shadowcasting" : "rays");
+        });
+        break;
+    case 'j':
+        g_sim->Post([] {
+            static const char* const SEARCH_NAMES[] = { "A*", "jump point", "hierarchical" };
+            int next = ((int)Path::GetSearchMode() + 1) % 3;
+            Path::SetSearchMode((Path::SearchMode)next);
+            LOG_INFO(General, "Path search: %s", SEARCH_NAMES[next]);
+        });
+        break;
+    case 'c':
+        g_sim->Post([] {
+            PathCache& cache = World::Current().pathCache;
+            cache.SetEnabled(!cache.IsEnabled());
+            LOG_INFO(General, "Path cache: %s", cache.IsEnabled() ? "on" : "off");
+        });
+        break;
+    case 't':
+        g_showProfile = !g_showProfile;
+        break;
+    case 'p':
+        g_sim->Post([] {
+            // Off-tick path requests: leave two hardware threads to the simulation and window
+            PathService& requests = World::Current().pathRequests;
+            int workers = std::max(1, (int)std::thread::hardware_concurrency() - 2);
+            requests.SetWorkers(requests.Workers() > 0 ? 0 : workers);
+        });
+        break;
     case '0':
         g_showSecurity = false;
         break;
@@ -705,6 +472,14 @@ void OnMouse(int button, int state, int, int)
 
 void main(int argc, char* argv[])
 {
+    // The window plays a single world for its whole lifetime
+    MatchParams params;
+    params.seed = (unsigned int)time(nullptr);
+    LOG_INFO(General, "Random seed = %u", params.seed);
+    static World world(params);
+    static SimThread sim(&world);     // destroyed (joined) before the world
+    g_sim = &sim;
+
     glutInit(&argc, argv);
     glutInitDisplayMode(GLUT_RGB | GLUT_DOUBLE);
     glutInitWindowSize(900, 450);
@@ -716,5 +491,6 @@ void main(int argc, char* argv[])
     glutKeyboardFunc(OnKeyboard);
     glutMouseFunc(OnMouse);
     init();
+    sim.Start();
     glutMainLoop();
 }